@@ -89,6 +89,15 @@ class FlexibleBuffer {
       other.totalLen = 0;
       other.currCapacity = 0;
    }
+   //frees all elements, the buffer can not be inserted into afterwards
+   void clear() {
+      for (auto buf : buffers) {
+         free(buf.ptr);
+      }
+      buffers.clear();
+      totalLen = 0;
+      currCapacity = 0;
+   }
    ~FlexibleBuffer() {
       for (auto buf : buffers) {
          free(buf.ptr);
@@ -7,6 +7,7 @@
 
 #include "ConcurrentMap.h"
 #include "Session.h"
+#include "Spilling.h"
 #include <lingodb/scheduler/Scheduler.h>
 namespace lingodb::runtime {
 class Database;
@@ -20,6 +21,7 @@ class ExecutionContext {
    std::unordered_map<uint32_t, int64_t> tupleCounts;
    ConcurrentMap<void*, State> states;
    std::vector<std::unordered_map<size_t, State>> allocators;
+   MemoryBudget memoryBudget;
    Session& session;
 
    public:
@@ -27,6 +29,9 @@ class ExecutionContext {
    Session& getSession() {
       return session;
    }
+   MemoryBudget& getMemoryBudget() {
+      return memoryBudget;
+   }
    template <class T>
    std::optional<T*> getResultOfType(uint32_t id) {
       if (results.contains(id)) {
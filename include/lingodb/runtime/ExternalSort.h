@@ -0,0 +1,48 @@
+#ifndef LINGODB_RUNTIME_EXTERNALSORT_H
+#define LINGODB_RUNTIME_EXTERNALSORT_H
+#include "lingodb/runtime/Buffer.h"
+#include "lingodb/runtime/Spilling.h"
+
+#include <memory>
+#include <vector>
+namespace lingodb::runtime {
+class GrowingBuffer;
+//sorts a materialized input that can only be consumed in order
+//if the sorted copy does not fit into the memory budget, the input is sorted into runs that are written to a spill file and merged while iterating
+//sequential iteration produces the entries in order, parallel iteration produces every entry once in no particular order
+class ExternalSort {
+   public:
+   struct Segment {
+      size_t offset;
+      size_t len;
+   };
+
+   private:
+   GrowingBuffer* input;
+   bool (*compareFn)(uint8_t*, uint8_t*);
+   //normalized key (prefix) used for radix sorting, may be null
+   uint64_t (*keyFn)(uint8_t*);
+   size_t typeSize;
+   MemoryBudget* memoryBudget;
+   //result of the in-memory sort, if no runs were spilled
+   Buffer sorted;
+   std::unique_ptr<SpillFile> spillFile;
+   std::vector<std::vector<Segment>> runs;
+
+   ExternalSort(GrowingBuffer* input, bool (*compareFn)(uint8_t*, uint8_t*), uint64_t (*keyFn)(uint8_t*), MemoryBudget* memoryBudget);
+   size_t getSortBytesPerEntry() const {
+      return keyFn ? sizeof(uint8_t*) + 2 * (sizeof(uint64_t) + sizeof(uint8_t*)) : sizeof(uint8_t*);
+   }
+   void createRuns();
+   void merge(void (*forEachChunk)(Buffer, void*), void* contextPtr);
+   void scanRunsParallel(void (*forEachChunk)(Buffer, void*), void* contextPtr);
+   friend class ExternalSortIterator;
+
+   public:
+   static ExternalSort* create(GrowingBuffer* input, bool (*compareFn)(uint8_t*, uint8_t*));
+   //keyFn returns an order-preserving key (prefix), compareFn is only called for entries with equal keys
+   static ExternalSort* createByKey(GrowingBuffer* input, bool (*compareFn)(uint8_t*, uint8_t*), uint64_t (*keyFn)(uint8_t*));
+   static BufferIterator* createIterator(ExternalSort* sort);
+};
+} // end namespace lingodb::runtime
+#endif //LINGODB_RUNTIME_EXTERNALSORT_H
@@ -0,0 +1,61 @@
+#ifndef LINGODB_RUNTIME_GRACEHASHJOIN_H
+#define LINGODB_RUNTIME_GRACEHASHJOIN_H
+#include "lingodb/runtime/Buffer.h"
+#include "lingodb/runtime/Spilling.h"
+
+#include <memory>
+#include <vector>
+namespace lingodb::runtime {
+class GrowingBuffer;
+//equi-join of two materialized inputs whose entries start with the hash value of the join keys
+//if the build side does not fit into the memory budget, both sides are radix-partitioned into a spill file and joined partition by partition
+//if it fits, but exceeds the cache, both sides are radix-partitioned in memory into partitions whose hash tables are cache resident
+//iterating produces pairs of (build entry, probe entry) with matching hash values
+//the smaller input is used as build side, even if it was materialized as probe side, the produced pairs keep the original order
+class GraceHashJoin {
+   public:
+   struct Segment {
+      size_t offset;
+      size_t len;
+   };
+   //entries of one input grouped by partition, partition i occupies the entries [offsets[i], offsets[i+1])
+   struct MemoryPartitions {
+      std::unique_ptr<uint8_t[]> data;
+      std::vector<size_t> offsets;
+   };
+
+   private:
+   GrowingBuffer* build;
+   GrowingBuffer* probe;
+   size_t buildTypeSize;
+   size_t probeTypeSize;
+   MemoryBudget* memoryBudget;
+   //build and probe were exchanged at runtime, matches have to be emitted as (probe entry, build entry)
+   bool swapped;
+   //0: both inputs stay in memory and are joined directly
+   //otherwise, the partitions live in the spill file if it exists and in memory if not
+   size_t numPartitions;
+   size_t partitionShift;
+   std::unique_ptr<SpillFile> spillFile;
+   std::vector<std::vector<Segment>> buildSegments;
+   std::vector<std::vector<Segment>> probeSegments;
+   MemoryPartitions buildPartitions;
+   MemoryPartitions probePartitions;
+   //bytes of the in-memory partitions, charged to the memory budget
+   size_t partitionBytes;
+
+   GraceHashJoin(GrowingBuffer* build, GrowingBuffer* probe, MemoryBudget* memoryBudget, bool swapped);
+   void partition(GrowingBuffer* input, std::vector<std::vector<Segment>>& segments);
+   void partitionInMemory(GrowingBuffer* input, MemoryPartitions& partitions);
+   void joinCachePartition(size_t partition, void (*forEachChunk)(Buffer, void*), void* contextPtr);
+   void joinInMemory(bool parallel, void (*forEachChunk)(Buffer, void*), void* contextPtr);
+   void joinPartition(size_t partition, void (*forEachChunk)(Buffer, void*), void* contextPtr);
+   friend class GraceHashJoinIterator;
+
+   public:
+   static GraceHashJoin* create(GrowingBuffer* build, GrowingBuffer* probe);
+   static BufferIterator* createIterator(GraceHashJoin* join);
+   ~GraceHashJoin();
+};
+} // end namespace lingodb::runtime
+#endif //LINGODB_RUNTIME_GRACEHASHJOIN_H
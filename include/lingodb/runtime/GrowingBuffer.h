@@ -23,6 +23,8 @@ class GrowingBuffer {
    size_t getLen() const;
    size_t getTypeSize() const;
    runtime::Buffer sort(bool (*compareFn)(uint8_t*, uint8_t*));
+   //keyFn returns an order-preserving key (prefix), compareFn is only called for entries with equal keys
+   runtime::Buffer sortByKey(bool (*compareFn)(uint8_t*, uint8_t*), uint64_t (*keyFn)(uint8_t*));
    runtime::Buffer asContinuous();
    static void destroy(GrowingBuffer* vec);
    BufferIterator* createIterator();
@@ -2,10 +2,31 @@
 #define LINGODB_RUNTIME_HEAP_H
 #include "Buffer.h"
 #include "ThreadLocal.h"
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <type_traits>
+#include <vector>
 namespace lingodb::runtime {
+//bound shared by the thread-local heaps of one top-k: the worst entry of a full heap
+//only entries that sort before it can still be part of the global result
+struct HeapThreshold {
+   //published bounds are immutable and kept until the top-k is destroyed, as other heaps may still compare against them
+   struct Bound {
+      Bound* previous;
+      uint8_t value[];
+   };
+   //the tightest bound so far (null: no heap is full yet), only ever replaced by a tighter one
+   std::atomic<Bound*> bound{nullptr};
+   ~HeapThreshold() {
+      for (auto* curr = bound.load(); curr;) {
+         auto* previous = curr->previous;
+         free(curr);
+         curr = previous;
+      }
+   }
+};
 class Heap {
    using CmpFn = std::add_pointer<bool(uint8_t* left, uint8_t* right)>::type;
 
@@ -14,27 +35,38 @@ class Heap {
    size_t maxElements;
    size_t currElements;
    uint8_t* data;
+   //1-based max-heap of entry indices into data, entries are never moved while inserting
+   std::vector<size_t> slots;
+   HeapThreshold* threshold;
+   //root replacements since the bound was last published by this heap
+   size_t unpublished;
    void bubbleDown(size_t idx, size_t end);
    void buildHeap();
+   uint8_t* entry(size_t slot) {
+      return &data[slot * typeSize];
+   }
    bool isLt(size_t l, size_t r) {
-      return cmpFn(&data[l * typeSize], &data[r * typeSize]);
+      return cmpFn(entry(slots[l]), entry(slots[r]));
    }
    void swap(size_t l, size_t r) {
-      std::swap_ranges(&data[l * typeSize], &data[l * typeSize + typeSize], &data[r * typeSize]);
+      std::swap(slots[l], slots[r]);
    }
+   bool passesThreshold(uint8_t* currData);
+   void publishThreshold();
+   void add(uint8_t* currData);
 
    public:
-   Heap(size_t maxElements, size_t typeSize, CmpFn cmpFn) : cmpFn(cmpFn), typeSize(typeSize), maxElements(maxElements), currElements(0), data(new uint8_t[typeSize * (maxElements + 1)]) {
+   Heap(size_t maxElements, size_t typeSize, CmpFn cmpFn, HeapThreshold* threshold) : cmpFn(cmpFn), typeSize(typeSize), maxElements(maxElements), currElements(0), data(new uint8_t[typeSize * maxElements]), slots(maxElements + 1), threshold(threshold), unpublished(0) {
    }
    static Heap* create(size_t maxElements, size_t typeSize, bool (*cmpFn)(unsigned char*, unsigned char*));
+   //one of the thread-local heaps of threadLocal, which share a bound for pruning
+   static Heap* createShared(size_t maxElements, size_t typeSize, bool (*cmpFn)(unsigned char*, unsigned char*), ThreadLocal* threadLocal);
    void insert(uint8_t* currData);
+   //checks an entry of which only the sort-by members are set against the current bound, without inserting it
+   bool isCandidate(uint8_t* currData);
    Buffer getBuffer();
    static void destroy(Heap*);
-   void mergeWithOther(Heap* other) {
-      for (size_t i = 1; i <= other->currElements; i++) {
-         insert(&other->data[i * typeSize]);
-      }
-   }
+   void mergeWithOther(Heap* other);
    static Heap* merge(ThreadLocal* threadLocal);
 
    ~Heap() {
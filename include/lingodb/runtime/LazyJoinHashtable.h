@@ -4,15 +4,26 @@
 #include "lingodb/runtime/helpers.h"
 namespace lingodb::runtime {
 class GrowingBuffer;
+//unchained hash table over the entries of a buffer: the entries of a bucket are referenced by a contiguous range of slots
+//ht has htMask + 2 words, ht[b] holds the begin of the slots of bucket b (shifted by 16 bits) and its bloom tag in the lower 16 bits, ht[b + 1] the end
 class HashIndexedView {
    struct Entry {
-      Entry* next;
       uint64_t hashValue;
       //kv follows
    };
-   Entry** ht;
+   //the hash value is stored next to the entry pointer, so that candidates can be rejected without touching the entry
+   struct Slot {
+      uint64_t hashValue;
+      Entry* entry;
+   };
+   uint64_t* ht;
    size_t htMask; //NOLINT(clang-diagnostic-unused-private-field)
-   HashIndexedView(size_t htSize, size_t htMask);
+   //blocked bloom filter over the hash values of all entries (one 64-bit word per hash value), probed by the generated code before the lookup
+   uint64_t* filter;
+   size_t filterMask; //NOLINT(clang-diagnostic-unused-private-field)
+   Slot* slots;
+   size_t numSlots;
+   HashIndexedView(size_t htSize, size_t htMask, size_t filterSize, size_t filterMask, size_t numSlots);
    static uint64_t nextPow2(uint64_t v) {
       v--;
       v |= v >> 1;
@@ -24,6 +35,14 @@ class HashIndexedView {
       v++;
       return v;
    }
+   //must match the probe in the generated code (CheckJoinFilterLowering)
+   //the word is selected by the upper half of the hash value, the three bits in the word by bits 14 to 31
+   static size_t filterWord(size_t hash, size_t filterMask) {
+      return (hash >> 32) & filterMask;
+   }
+   static uint64_t filterBits(size_t hash) {
+      return (1ull << ((hash >> 14) & 63)) | (1ull << ((hash >> 20) & 63)) | (1ull << ((hash >> 26) & 63));
+   }
 
    public:
    static HashIndexedView* build(GrowingBuffer* buffer);
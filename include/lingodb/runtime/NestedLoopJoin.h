@@ -0,0 +1,35 @@
+#ifndef LINGODB_RUNTIME_NESTEDLOOPJOIN_H
+#define LINGODB_RUNTIME_NESTEDLOOPJOIN_H
+#include "lingodb/runtime/Buffer.h"
+
+#include <vector>
+namespace lingodb::runtime {
+class GrowingBuffer;
+//nested-loop join of two materialized inputs without any usable join keys
+//the build side is cut into cache-sized blocks, the probe side into batches that are distributed over the workers
+//iterating produces pairs of (build block, probe batch), the consuming pipeline loops over both and evaluates the join predicate
+class NestedLoopJoin {
+   public:
+   struct BlockPair {
+      uint8_t* build;
+      size_t numBuild;
+      uint8_t* probe;
+      size_t numProbe;
+   };
+
+   private:
+   GrowingBuffer* build;
+   GrowingBuffer* probe;
+   std::vector<Buffer> buildBlocks;
+   std::vector<Buffer> probeBatches;
+
+   NestedLoopJoin(GrowingBuffer* build, GrowingBuffer* probe);
+   void joinBatch(size_t batch, void (*forEachChunk)(Buffer, void*), void* contextPtr);
+   friend class NestedLoopJoinIterator;
+
+   public:
+   static NestedLoopJoin* create(GrowingBuffer* build, GrowingBuffer* probe);
+   static BufferIterator* createIterator(NestedLoopJoin* join);
+};
+} // end namespace lingodb::runtime
+#endif //LINGODB_RUNTIME_NESTEDLOOPJOIN_H
@@ -1,9 +1,13 @@
 #ifndef LINGODB_RUNTIME_PREAGGREGATIONHASHTABLE_H
 #define LINGODB_RUNTIME_PREAGGREGATIONHASHTABLE_H
 #include "lingodb/runtime/Buffer.h"
+#include "lingodb/runtime/Spilling.h"
 #include "lingodb/runtime/ThreadLocal.h"
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <vector>
 namespace lingodb::runtime {
 class PreAggregationHashtableFragment {
    public:
@@ -13,14 +17,46 @@ class PreAggregationHashtableFragment {
       uint8_t content[];
       //kv follows
    };
-   static constexpr size_t numOutputs = 64;
-   static constexpr size_t hashtableSize = 1024;
-   Entry* ht[hashtableSize];
+   //ht, htMask and numLookups are accessed by generated code: do not reorder
+   Entry** ht;
+   size_t htMask;
+   //incremented by generated code for every lookup
+   size_t numLookups;
    size_t typeSize;
    size_t len;
-   runtime::FlexibleBuffer* outputs[numOutputs];
+   //entries are radix-partitioned by the lowest bits of their hash (numOutputs is a power of two)
+   size_t numOutputs;
+   runtime::FlexibleBuffer** outputs;
    bool withLocks;
-   PreAggregationHashtableFragment(size_t typeSize, bool withLocks) : ht(), typeSize(typeSize), len(0), outputs(), withLocks(withLocks) {}
+
+   private:
+   //pre-aggregation is bypassed if it does not reduce the number of entries: every lookup misses and insert() directly materializes into outputs
+   Entry** localHt;
+   size_t localHtMask;
+   Entry* bypassSlot;
+   bool bypass;
+   //statistics of the current sampling window
+   size_t windowLookups;
+   size_t windowLen;
+   //outputs are written to disk if the memory budget of the query is exceeded
+   struct SpilledSegment {
+      size_t offset;
+      size_t numEntries;
+   };
+   MemoryBudget* memoryBudget;
+   size_t accountedBytes;
+   //number of entries (of len) that were already spilled
+   size_t spilledLen;
+   std::unique_ptr<SpillFile> spillFile;
+   std::vector<std::vector<SpilledSegment>> spilledSegments;
+   PreAggregationHashtableFragment(size_t typeSize, bool withLocks, MemoryBudget* memoryBudget);
+   void adapt();
+   void spill();
+   friend class PreAggregationHashtable;
+
+   public:
+   //number of partitions each fragment produces, depends on the number of workers
+   static size_t getNumPartitions();
    static PreAggregationHashtableFragment* create(size_t typeSize, bool withLocks);
    Entry* insert(size_t hash);
    ~PreAggregationHashtableFragment();
@@ -31,10 +67,20 @@ class PreAggregationHashtable {
       Entry** ht;
       size_t hashMask;
    };
-   PartitionHt ht[PreAggregationHashtableFragment::numOutputs];
+   //ht, partitionMask and partitionShift are accessed by generated code: do not reorder
+   PartitionHt* ht;
+   size_t partitionMask;
+   //log2(#partitions): the bits above are used for the position inside a partition
+   size_t partitionShift;
    runtime::FlexibleBuffer buffer;
-   PreAggregationHashtable() : ht(), buffer(1, sizeof(PreAggregationHashtableFragment::Entry*)) {
-   }
+   //storage for entries that were loaded from spill files
+   std::vector<std::unique_ptr<runtime::FlexibleBuffer>> loadedEntries;
+   //partitions that use the table of another partition (all partitions of a spilled fragment partition share one table)
+   std::vector<bool> sharesHt;
+   //the merged tables are charged to the memory budget of the query
+   MemoryBudget* memoryBudget;
+   std::atomic<size_t> accountedBytes;
+   PreAggregationHashtable(size_t numPartitions, MemoryBudget* memoryBudget);
 
    public:
    static runtime::PreAggregationHashtable* merge(ThreadLocal*, bool (*eq)(uint8_t*, uint8_t*), void (*combine)(uint8_t*, uint8_t*));
@@ -4,34 +4,31 @@
 
 #include <cstdint>
 #include <type_traits>
+#include <vector>
 
 #include <stdlib.h>
 namespace lingodb::runtime {
 
+//segment tree with an implicit layout: the states of all levels are stored in one array, starting with the leaves
+//the state of node i on level l+1 combines the states of nodes [i*fanout, (i+1)*fanout) on level l
 class SegmentTreeView {
    using CreateInitialStateFn = std::add_pointer<void(uint8_t* newState, uint8_t* entry)>::type;
    using CombineStatesFn = std::add_pointer<void(uint8_t* newState, uint8_t* left, uint8_t* right)>::type;
    CreateInitialStateFn createInitialStateFn;
    CombineStatesFn combineStatesFn;
    size_t stateTypeSize;
-   struct TreeNode {
-      size_t leftMin;
-      size_t rightMax;
-      TreeNode* left = nullptr;
-      TreeNode* right = nullptr;
-      uint8_t* state;
-   };
-   TreeNode* storage;
-   size_t storageCntr = 0;
-   size_t numEntries;
-   TreeNode* buildRecursively(std::vector<uint8_t*>& entryPointers, size_t from, size_t to);
-   void lookupRecursively(TreeNode* t, uint8_t* result, size_t from, size_t to, bool& first);
-   TreeNode* root;
-   void destroyNode(TreeNode* node);
-   TreeNode* allocate();
-   uint8_t* allocateState();
+   size_t fanout;
    uint8_t* stateStorage;
-   size_t stateCntr = 0;
+   size_t numStates;
+   //index of the first state of every level
+   std::vector<size_t> levelOffsets;
+   std::vector<size_t> levelSizes;
+   uint8_t* getState(size_t level, size_t idx) {
+      return &stateStorage[(levelOffsets[level] + idx) * stateTypeSize];
+   }
+   void buildLevel(size_t level, uint8_t* entries, size_t typeSize);
+   //from: inclusive, to: exclusive
+   void aggregate(uint8_t* result, size_t level, size_t from, size_t to, bool& first);
 
    public:
    void lookup(uint8_t* result, size_t from, size_t to);
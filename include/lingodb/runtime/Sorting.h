@@ -2,10 +2,16 @@
 #define LINGODB_RUNTIME_SORTING_H
 #include "lingodb/runtime/GrowingBuffer.h"
 
+#include <vector>
+
 namespace lingodb::runtime {
 
 bool canParallelSort(const size_t valueSize);
 Buffer parallelSort(FlexibleBuffer& values, bool (*compareFn)(uint8_t*, uint8_t*));
+//sorts by a normalized key (prefix) per entry with a (parallel) MSD radix sort, entries with equal keys are ordered by compareFn
+Buffer radixSort(FlexibleBuffer& values, bool (*compareFn)(uint8_t*, uint8_t*), uint64_t (*keyFn)(uint8_t*));
+//sorts the entry pointers in place with the sequential MSD radix sort of radixSort, uses 2 * sizeof(uint64_t) + 2 * sizeof(uint8_t*) bytes per entry
+void radixSortPointers(std::vector<uint8_t*>& entries, bool (*compareFn)(uint8_t*, uint8_t*), uint64_t (*keyFn)(uint8_t*));
 
 } // end namespace lingodb::runtime
 #endif //LINGODB_RUNTIME_SORTING_H
\ No newline at end of file
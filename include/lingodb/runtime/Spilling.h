@@ -0,0 +1,43 @@
+#ifndef LINGODB_RUNTIME_SPILLING_H
+#define LINGODB_RUNTIME_SPILLING_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+namespace lingodb::runtime {
+//anonymous temporary file for data that does not fit into the memory budget, removed when destroyed
+class SpillFile {
+   int fd;
+   std::atomic<size_t> size;
+   SpillFile(int fd) : fd(fd), size(0) {}
+
+   public:
+   static std::unique_ptr<SpillFile> create();
+   //returns the offset the data was written to (thread-safe)
+   size_t append(const void* data, size_t len);
+   void read(size_t offset, void* data, size_t len) const;
+   size_t getSize() const { return size.load(); }
+   ~SpillFile();
+};
+//per-query accounting of the memory held by operators that are able to spill
+class MemoryBudget {
+   size_t limit;
+   std::atomic<size_t> used;
+
+   public:
+   //limit is taken from the system.memory_budget setting (0: unlimited)
+   MemoryBudget();
+   void allocate(size_t bytes) {
+      used.fetch_add(bytes);
+   }
+   void release(size_t bytes) {
+      used.fetch_sub(bytes);
+   }
+   bool isExceeded() const {
+      return limit && used.load(std::memory_order_relaxed) > limit;
+   }
+   size_t getLimit() const { return limit; }
+   size_t getUsed() const { return used.load(); }
+};
+} // end namespace lingodb::runtime
+#endif //LINGODB_RUNTIME_SPILLING_H
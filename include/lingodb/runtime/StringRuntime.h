@@ -34,6 +34,8 @@ struct StringRuntime {
    static VarLen32 concat(VarLen32 a, VarLen32 b);
    static size_t findMatch(VarLen32 str, VarLen32 needle, size_t start, size_t end);
    static size_t findNext(VarLen32 str, VarLen32 needle, size_t start);
+   //first 8 bytes in big-endian order (padded with zeros), ordered like the string
+   static uint64_t sortKey(VarLen32 str);
 };
 } // namespace lingodb::runtime
 #endif // LINGODB_RUNTIME_STRINGRUNTIME_H
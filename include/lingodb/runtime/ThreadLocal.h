@@ -2,18 +2,25 @@
 #define LINGODB_RUNTIME_THREADLOCAL_H
 #include "lingodb/scheduler/Scheduler.h"
 
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <span>
 namespace lingodb::runtime {
 class ThreadLocal {
    uint8_t** values;
    uint8_t* (*initFn)(uint8_t*);
    uint8_t* arg;
+   //state that is shared by all thread-local values, e.g., a bound for pruning
+   std::mutex sharedMutex;
+   std::shared_ptr<void> shared;
    ThreadLocal(uint8_t* (*initFn)(uint8_t*), uint8_t* arg) : initFn(initFn), arg(arg) {
       values = new uint8_t*[lingodb::scheduler::getNumWorkers()];
       for (size_t i = 0; i < lingodb::scheduler::getNumWorkers(); i++) {
          values[i] = nullptr;
       }
    }
+   static uint8_t* reduceParallel(std::span<uint8_t*> values, const std::function<void(uint8_t*, uint8_t*)>& mergeFn);
 
    public:
    uint8_t* getLocal();
@@ -28,7 +35,20 @@ class ThreadLocal {
       }
       return std::span<T*>(reinterpret_cast<T**>(values), lingodb::scheduler::getNumWorkers());
    }
+   //merges all thread-local values into one of them (parallel tree reduction, log2(#values) rounds)
+   template <class T>
+   T* reduce(const std::function<void(T*, T*)>& mergeFn) {
+      return reinterpret_cast<T*>(reduceParallel(getThreadLocalValues<uint8_t>(), [&](uint8_t* left, uint8_t* right) { mergeFn(reinterpret_cast<T*>(left), reinterpret_cast<T*>(right)); }));
+   }
    uint8_t* merge(void (*mergeFn)(uint8_t*, uint8_t*));
+   template <class T>
+   T* getShared() {
+      std::lock_guard<std::mutex> guard(sharedMutex);
+      if (!shared) {
+         shared = std::make_shared<T>();
+      }
+      return static_cast<T*>(shared.get());
+   }
 };
 } // end namespace lingodb::runtime
 
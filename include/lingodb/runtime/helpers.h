@@ -13,6 +13,9 @@
 #define INLINE __attribute__((always_inline))
 namespace lingodb::runtime {
 alignas(4096) extern uint16_t bloomMasks[2048];
+//initial capacities are derived from the optimizer's estimates, which can be far off:
+//a presized state never takes more than its share of system.presize.max_bytes, and grows by doubling afterwards
+size_t clampInitialCapacity(size_t initialCapacity, size_t typeSize);
 
 struct MemoryHelper {
    static uint8_t* resize(uint8_t* old, size_t oldNumBytes, size_t newNumBytes) {
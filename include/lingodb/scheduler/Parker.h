@@ -0,0 +1,95 @@
+#ifndef LINGODB_SCHEDULER_PARKER_H
+#define LINGODB_SCHEDULER_PARKER_H
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace lingodb::scheduler {
+//parking spot for one worker: a wakeup token that is consumed by park().
+//An idle worker first spins for a while (cheap wakeup for short gaps between tasks) and then blocks on a futex.
+//The spin budget adapts: it grows if the worker was woken up while spinning and shrinks if it had to block.
+//It never shrinks below minSpinBudget, so that a worker can still catch wakeups while spinning and grow the budget again.
+class Parker {
+   static constexpr uint32_t empty = 0;
+   static constexpr uint32_t notified = 1;
+   static constexpr uint32_t parked = 2;
+   std::atomic<uint32_t> state{empty};
+   size_t spinBudget;
+   size_t minSpinBudget;
+   size_t maxSpinBudget;
+
+   static void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#elif defined(__aarch64__)
+      asm volatile("yield");
+#endif
+   }
+   void wait() {
+#ifdef __linux__
+      syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state), FUTEX_WAIT_PRIVATE, parked, nullptr, nullptr, 0);
+#else
+      state.wait(parked);
+#endif
+   }
+   void wake() {
+#ifdef __linux__
+      syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+      state.notify_one();
+#endif
+   }
+
+   public:
+   //maxSpinBudget: upper bound for the number of iterations park() spins before it blocks (0: never spin)
+   Parker(size_t maxSpinBudget) : spinBudget(maxSpinBudget), minSpinBudget(maxSpinBudget == 0 ? 0 : std::max<size_t>(1, maxSpinBudget / 16)), maxSpinBudget(maxSpinBudget) {}
+   //blocks until unpark() is called (returns immediately if unpark() was called since the last park())
+   void park() {
+      for (size_t i = 0; i < spinBudget; i++) {
+         if (state.load(std::memory_order_relaxed) == notified) {
+            uint32_t expected = notified;
+            if (state.compare_exchange_strong(expected, empty)) {
+               spinBudget = std::min(maxSpinBudget, spinBudget * 2 + 1);
+               return;
+            }
+         }
+         cpuRelax();
+      }
+      spinBudget = std::max(minSpinBudget, spinBudget / 2);
+      uint32_t expected = empty;
+      if (!state.compare_exchange_strong(expected, parked)) {
+         //already notified
+         state.store(empty);
+         return;
+      }
+      while (true) {
+         wait();
+         expected = notified;
+         if (state.compare_exchange_strong(expected, empty)) {
+            return;
+         }
+         //spurious wakeup
+      }
+   }
+   void unpark() {
+      if (state.exchange(notified) == parked) {
+         wake();
+      }
+   }
+   size_t getSpinBudget() const {
+      return spinBudget;
+   }
+   //true while park() blocks on the futex
+   bool isBlocked() const {
+      return state.load() == parked;
+   }
+};
+} // namespace lingodb::scheduler
+#endif //LINGODB_SCHEDULER_PARKER_H
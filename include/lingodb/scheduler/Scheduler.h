@@ -1,7 +1,9 @@
 #ifndef LINGODB_SCHEDULER_SCHEDULER_H
 #define LINGODB_SCHEDULER_SCHEDULER_H
 #include "lingodb/scheduler/Task.h"
+#include <cstdint>
 #include <memory>
+#include <vector>
 namespace lingodb::scheduler {
 
 //handle to a scheduler. When the last handle is destroyed, the scheduler is stopped (waited for) and deleted.
@@ -21,11 +23,51 @@ void awaitEntryTask(std::unique_ptr<Task> task);
 //waits for the scheduler to finish the current task (this will yield the current worker thread, only use from a worker thread)
 void awaitChildTask(std::unique_ptr<Task> task);
 
-//returns the number of workers in the scheduler
+//returns the number of workers in the scheduler (including parked workers, i.e., an upper bound for worker ids)
 size_t getNumWorkers();
+//returns the number of workers that currently pick up new tasks
+size_t getNumActiveWorkers();
+//grows or shrinks the set of active workers at runtime (clamped to [1, getNumWorkers()]).
+//Workers beyond the given number are parked instead of destroyed: they finish their current unit of work and stop picking up new tasks.
+void setNumActiveWorkers(size_t numActiveWorkers);
 //returns the id of the current worker thread
 size_t currentWorkerId();
 
+//counters collected by each worker (since the scheduler was started or the last call to resetWorkerMetrics)
+struct WorkerMetrics {
+   size_t workerId = 0;
+   //units of work executed (calls to Task::performWork)
+   uint64_t tasksExecuted = 0;
+   //number of times the worker fetched a task from the global task queue
+   uint64_t tasksFetched = 0;
+   //fibers that yielded to wait for a child task / that were resumed afterwards
+   uint64_t fibersYielded = 0;
+   uint64_t fibersResumed = 0;
+   //time spent executing tasks (incl. resumed fibers)
+   uint64_t busyNs = 0;
+   //time spent sleeping, because there was nothing to do
+   uint64_t sleepNs = 0;
+   //remaining time: searching for work, scheduling overhead, ...
+   uint64_t idleNs = 0;
+   //time spent waiting for the lock protecting the global task queue
+   uint64_t taskQueueLockWaitNs = 0;
+};
+//returns the metrics of all workers of the running scheduler
+std::vector<WorkerMetrics> getWorkerMetrics();
+//resets the metrics of all workers (e.g., before executing a query)
+void resetWorkerMetrics();
+
+//state of the process-wide pool of fiber stacks
+struct FiberStackStats {
+   //stacks currently used by fibers
+   size_t inUse = 0;
+   //released stacks that are kept for reuse
+   size_t cachedStacks = 0;
+   //physical memory still backing the cached stacks
+   size_t cachedResidentBytes = 0;
+};
+FiberStackStats getFiberStackStats();
+
 } // namespace lingodb::scheduler
 
 #endif //LINGODB_SCHEDULER_SCHEDULER_H
@@ -15,6 +15,10 @@ class Task {
 
    virtual bool allocateWork() = 0;
    virtual void performWork() = 0;
+   //upper bound for the number of workers that can work on this task concurrently (limits the number of idle workers woken up for this task)
+   virtual size_t maxParallelism() {
+      return std::numeric_limits<size_t>::max();
+   }
    //e.g., to prepare environment
    virtual void setup() {}
    virtual void teardown() {}
@@ -2,6 +2,10 @@
 #ifndef LINGODB_SCHEDULER_TASKS_H
 #define LINGODB_SCHEDULER_TASKS_H
 #include "lingodb/runtime/ExecutionContext.h"
+
+#include <atomic>
+#include <functional>
+#include <vector>
 namespace lingodb::scheduler {
 class TaskWithContext : public Task {
    runtime::ExecutionContext* context;
@@ -27,6 +31,33 @@ class TaskWithImplicitContext : public Task {
       runtime::setCurrentExecutionContext(nullptr);
    }
 };
+//calls cb once for every index in [0, n), the indices are handed out to the workers one by one
+class ParallelForTask : public TaskWithImplicitContext {
+   size_t n;
+   std::function<void(size_t)> cb;
+   std::atomic<size_t> startIndex{0};
+   std::vector<size_t> workerResvs;
+
+   public:
+   ParallelForTask(size_t n, std::function<void(size_t)> cb) : n(n), cb(std::move(cb)) {
+      workerResvs.resize(getNumWorkers());
+   }
+   bool allocateWork() override {
+      size_t localStartIndex = startIndex.fetch_add(1);
+      if (localStartIndex >= n) {
+         workExhausted.store(true);
+         return false;
+      }
+      workerResvs[currentWorkerId()] = localStartIndex;
+      return true;
+   }
+   size_t maxParallelism() override {
+      return n;
+   }
+   void performWork() override {
+      cb(workerResvs[currentWorkerId()]);
+   }
+};
 } // namespace lingodb::scheduler
 
 #endif //LINGODB_SCHEDULER_TASKS_H
@@ -951,6 +951,55 @@ class SortCompareLowering : public OpConversionPattern<db::SortCompare> {
       return success();
    }
 };
+class SortKeyLowering : public OpConversionPattern<db::SortKey> {
+   //maps the value to an unsigned key, the order of signed integers is preserved by flipping the sign bit
+   Value sortKeyImpl(OpBuilder& builder, Location loc, Value v, Type originalType) const {
+      auto i64Type = builder.getI64Type();
+      Value signBit = builder.create<arith::ConstantIntOp>(loc, std::numeric_limits<int64_t>::min(), 64);
+      if (auto nullableType = mlir::dyn_cast_or_null<db::NullableType>(originalType)) {
+         llvm::SmallVector<mlir::Value> unpacked;
+         builder.createOrFold<util::UnPackOp>(unpacked, loc, v);
+         //nulls are larger than all other values
+         return builder.create<mlir::scf::IfOp>(
+                          loc, unpacked[0], [&](mlir::OpBuilder& builder, mlir::Location loc) {
+                             Value allOnes = builder.create<arith::ConstantIntOp>(loc, -1, 64);
+                             builder.create<mlir::scf::YieldOp>(loc, allOnes); }, [&](mlir::OpBuilder& builder, mlir::Location loc) { builder.create<mlir::scf::YieldOp>(loc, sortKeyImpl(builder, loc, unpacked[1], nullableType.getType())); })
+            .getResult(0);
+      }
+      if (mlir::isa<util::VarLen32Type>(v.getType())) {
+         return lingodb::compiler::runtime::StringRuntime::sortKey(builder, loc)({v})[0];
+      }
+      if (auto floatType = mlir::dyn_cast_or_null<mlir::FloatType>(v.getType())) {
+         if (floatType.getWidth() < 64) {
+            v = builder.create<arith::ExtFOp>(loc, builder.getF64Type(), v);
+         }
+         //negative values: invert all bits, positive values: set the sign bit
+         Value bits = builder.create<arith::BitcastOp>(loc, i64Type, v);
+         Value c63 = builder.create<arith::ConstantIntOp>(loc, 63, 64);
+         Value mask = builder.create<arith::ShRSIOp>(loc, bits, c63);
+         mask = builder.create<arith::OrIOp>(loc, mask, signBit);
+         return builder.create<arith::XOrIOp>(loc, bits, mask);
+      }
+      auto intType = mlir::cast<mlir::IntegerType>(v.getType());
+      if (intType.getWidth() > 64) {
+         //the upper 64 bits are ordered like the complete value
+         Value shift = builder.create<arith::ConstantOp>(loc, builder.getIntegerAttr(intType, 64));
+         v = builder.create<arith::ShRSIOp>(loc, v, shift);
+         v = builder.create<arith::TruncIOp>(loc, i64Type, v);
+      } else if (intType.getWidth() < 64) {
+         v = builder.create<arith::ExtSIOp>(loc, i64Type, v);
+      }
+      return builder.create<arith::XOrIOp>(loc, v, signBit);
+   }
+
+   public:
+   using OpConversionPattern<db::SortKey>::OpConversionPattern;
+   LogicalResult matchAndRewrite(db::SortKey sortKeyOp, OpAdaptor adaptor, ConversionPatternRewriter& rewriter) const override {
+      if (!db::SortKey::isSupported(sortKeyOp.getVal().getType())) return failure();
+      rewriter.replaceOp(sortKeyOp, sortKeyImpl(rewriter, sortKeyOp->getLoc(), adaptor.getVal(), sortKeyOp.getVal().getType()));
+      return success();
+   }
+};
 class HashLowering : public ConversionPattern {
    Value combineHashes(OpBuilder& builder, Location loc, Value hash1, Value totalHash) const {
       if (!totalHash) {
@@ -1146,6 +1195,7 @@ void DBToStdLoweringPass::runOnOperation() {
    patterns.insert<BetweenLowering>(typeConverter, ctxt);
    patterns.insert<OneOfLowering>(typeConverter, ctxt);
    patterns.insert<SortCompareLowering>(typeConverter, ctxt);
+   patterns.insert<SortKeyLowering>(typeConverter, ctxt);
 
    patterns.insert<NotOpLowering>(typeConverter, ctxt);
 
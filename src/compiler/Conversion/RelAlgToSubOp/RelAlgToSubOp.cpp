@@ -13,6 +13,7 @@
 #include "lingodb/compiler/Dialect/util/FunctionHelper.h"
 #include "lingodb/compiler/Dialect/util/UtilDialect.h"
 #include "lingodb/compiler/Dialect/util/UtilOps.h"
+#include "lingodb/utility/Setting.h"
 
 #include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Async/IR/Async.h"
@@ -31,12 +32,26 @@
 
 #include "llvm/ADT/TypeSwitch.h"
 
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <optional>
 
 using namespace mlir;
 
 namespace {
 using namespace lingodb::compiler::dialect;
+//ORDER BY inputs with at least this many (estimated) rows are sorted externally, i.e., into runs that can be spilled under memory pressure (0: never)
+lingodb::utility::GlobalSetting<int64_t> externalSortMinRows("system.opt.external_sort_min_rows", 0);
+//evaluation strategy for windows with PARTITION BY:
+//  sort: sort the whole input by (partition keys, order keys) and evaluate all partitions in one parallel pipeline, with frames clipped to the partition bounds
+//  hash: hash-partition the input by the partition keys, then sort and evaluate every partition on its own
+lingodb::utility::GlobalSetting<std::string> windowPartitioning("system.opt.window_partitioning", "sort");
+//inner joins without usable keys and cross products materialize both sides and join them block-wise in parallel, instead of scanning the build side once per probe tuple
+//off by default: the probe side is materialized as well, which the tuple-at-a-time nested loop avoids
+lingodb::utility::GlobalSetting<bool> blockNestedLoopJoin("system.opt.block_nested_loop_join", false);
+//semi, anti and mark hash joins whose predicate only reads the keys of the build side store the build side as a set of distinct keys
+lingodb::utility::GlobalSetting<bool> existenceJoinAsSet("system.opt.existence_join_as_set", true);
 struct RelalgToSubOpLoweringPass
    : public PassWrapper<RelalgToSubOpLoweringPass, OperationPass<ModuleOp>> {
    MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(RelalgToSubOpLoweringPass)
@@ -67,6 +82,25 @@ static relalg::ColumnSet getRequired(Operator op) {
    }
    return available.intersect(required);
 }
+//number of rows the query optimizer estimated for a relational operator, if any
+static std::optional<double> getEstimatedRows(mlir::Value rel) {
+   auto* op = rel.getDefiningOp();
+   if (!op) return {};
+   if (auto rowsAttr = mlir::dyn_cast_or_null<mlir::FloatAttr>(op->getAttr("rows"))) {
+      return rowsAttr.getValueAsDouble();
+   }
+   if (auto rowsAttr = mlir::dyn_cast_or_null<mlir::IntegerAttr>(op->getAttr("rows"))) {
+      return rowsAttr.getInt();
+   }
+   return {};
+}
+//presizes a hash table or buffer for the estimated number of entries
+//the runtime bounds the initial capacity, and the state grows as usual if the estimate is too low
+static void setInitialCapacity(mlir::Value state, std::optional<double> estimatedEntries) {
+   if (!estimatedEntries || *estimatedEntries < 1) return;
+   auto initialCapacity = static_cast<int64_t>(std::min(std::ceil(*estimatedEntries), static_cast<double>(std::numeric_limits<int32_t>::max())));
+   state.getDefiningOp()->setAttr("initial_capacity", mlir::IntegerAttr::get(mlir::IntegerType::get(state.getContext(), 64), initialCapacity));
+}
 class BaseTableLowering : public OpConversionPattern<relalg::BaseTableOp> {
    public:
    using OpConversionPattern<relalg::BaseTableOp>::OpConversionPattern;
@@ -318,6 +352,7 @@ class ProjectionDistinctLowering : public OpConversionPattern<relalg::Projection
 
       auto stateType = subop::MapType::get(rewriter.getContext(), keyMembers, stateMembers, false);
       mlir::Value state = rewriter.create<subop::GenericCreateOp>(loc, stateType);
+      setInitialCapacity(state, getEstimatedRows(projectionOp.getResult()));
       auto [referenceDef, referenceRef] = createColumn(subop::LookupEntryRefType::get(context, stateType), "lookup", "ref");
       auto lookupOp = rewriter.create<subop::LookupOrInsertOp>(loc, tuples::TupleStreamType::get(getContext()), adaptor.getRel(), state, projectionOp.getCols(), referenceDef);
       auto* initialValueBlock = new Block;
@@ -1059,7 +1094,8 @@ std::pair<mlir::Block*, mlir::ArrayAttr> createVerifyEqFnForTuple(mlir::Conversi
    return {helper.getMapBlock(), helper.getColRefs()};
 }
 
-static mlir::Value translateHJ(mlir::Value left, mlir::Value right, mlir::ArrayAttr nullsEqual, mlir::ArrayAttr hashLeft, mlir::ArrayAttr hashRight, relalg::ColumnSet columns, mlir::ConversionPatternRewriter& rewriter, mlir::Location loc, std::function<mlir::Value(mlir::Value, mlir::ConversionPatternRewriter& rewriter)> fn) {
+//filterable: the consumer ignores probe tuples without a match (inner and semi joins), so that they may already be dropped by a join filter
+static mlir::Value translateHJ(mlir::Value left, mlir::Value right, mlir::ArrayAttr nullsEqual, mlir::ArrayAttr hashLeft, mlir::ArrayAttr hashRight, relalg::ColumnSet columns, std::optional<double> buildRows, bool filterable, mlir::ConversionPatternRewriter& rewriter, mlir::Location loc, std::function<mlir::Value(mlir::Value, mlir::ConversionPatternRewriter& rewriter)> fn) {
    auto keyColumns = relalg::ColumnSet::fromArrayAttr(hashRight);
    MaterializationHelper keyHelper(hashRight, rewriter.getContext());
    auto valueColumns = columns;
@@ -1067,6 +1103,7 @@ static mlir::Value translateHJ(mlir::Value left, mlir::Value right, mlir::ArrayA
    MaterializationHelper valueHelper(valueColumns, rewriter.getContext());
    auto multiMapType = subop::MultiMapType::get(rewriter.getContext(), keyHelper.createStateMembersAttr(), valueHelper.createStateMembersAttr());
    mlir::Value multiMap = rewriter.create<subop::GenericCreateOp>(loc, multiMapType);
+   setInitialCapacity(multiMap, buildRows);
    auto insertOp = rewriter.create<subop::InsertOp>(loc, right, multiMap, keyHelper.createColumnstateMapping(valueHelper.createColumnstateMapping().getValue()));
    insertOp.getEqFn().push_back(createEqFn(rewriter, hashRight, hashRight, nullsEqual, loc));
 
@@ -1076,6 +1113,9 @@ static mlir::Value translateHJ(mlir::Value left, mlir::Value right, mlir::ArrayA
    auto [entryDef, entryRef] = createColumn(entryRefType, "lookup", "entryref");
    auto afterLookup = rewriter.create<subop::LookupOp>(loc, tuples::TupleStreamType::get(rewriter.getContext()), left, multiMap, hashLeft, listDef);
    afterLookup.getEqFn().push_back(createEqFn(rewriter, hashRight, hashLeft, nullsEqual, loc));
+   if (filterable) {
+      afterLookup->setAttr("filterable", rewriter.getUnitAttr());
+   }
    auto nestedMapOp = rewriter.create<subop::NestedMapOp>(loc, tuples::TupleStreamType::get(rewriter.getContext()), afterLookup, rewriter.getArrayAttr(listRef));
    auto* b = new Block;
    mlir::Value tuple = b->addArgument(tuples::TupleType::get(rewriter.getContext()), loc);
@@ -1174,9 +1214,162 @@ static mlir::Value translateINLJ(mlir::Value left, mlir::Value right, mlir::Arra
    }
    return nestedMapOp.getRes();
 }
-static mlir::Value translateNL(mlir::Value left, mlir::Value right, bool useHash, bool useIndexNestedLoop, mlir::ArrayAttr nullsEqual, mlir::ArrayAttr hashLeft, mlir::ArrayAttr hashRight, relalg::ColumnSet columns, mlir::ConversionPatternRewriter& rewriter, mlir::Operation* op, std::function<mlir::Value(mlir::Value, mlir::ConversionPatternRewriter& rewriter)> fn) {
+static mlir::Value hashKeys(mlir::ArrayAttr keys, subop::MapCreationHelper& helper, mlir::OpBuilder& rewriter, mlir::Location loc) {
+   std::vector<mlir::Value> values;
+   for (auto key : keys) {
+      values.push_back(helper.access(mlir::cast<tuples::ColumnRefAttr>(key), loc));
+   }
+   if (values.size() == 1) {
+      return rewriter.create<db::Hash>(loc, values[0]);
+   }
+   return rewriter.create<db::Hash>(loc, rewriter.create<util::PackOp>(loc, values));
+}
+//materializes the stream into a buffer whose entries start with the hash of the join keys
+static std::pair<mlir::Value, std::string> materializeForGraceHJ(mlir::Value stream, mlir::ArrayAttr keys, MaterializationHelper& helper, mlir::ConversionPatternRewriter& rewriter, mlir::Location loc) {
+   auto* ctxt = rewriter.getContext();
+   auto hashMember = getUniqueMember(ctxt, "hash");
+   auto [hashDef, hashRef] = createColumn(rewriter.getIndexType(), "hj", "hash");
+   stream = map(stream, rewriter, loc, rewriter.getArrayAttr(hashDef), [&](mlir::ConversionPatternRewriter& rewriter, subop::MapCreationHelper& mapHelper, mlir::Location loc) {
+      return std::vector<mlir::Value>({hashKeys(keys, mapHelper, rewriter, loc)});
+   });
+   auto bufferType = subop::BufferType::get(ctxt, helper.createStateMembersAttr({rewriter.getStringAttr(hashMember)}, {mlir::TypeAttr::get(rewriter.getIndexType())}));
+   mlir::Value buffer = rewriter.create<subop::GenericCreateOp>(loc, bufferType);
+   rewriter.create<subop::MaterializeOp>(loc, stream, buffer, helper.createColumnstateMapping({rewriter.getNamedAttr(hashMember, hashRef)}));
+   return {buffer, hashMember};
+}
+//partition-wise hash join: both sides are materialized and joined by the runtime, which radix-partitions them to disk if the build side exceeds the memory budget
+static mlir::Value translateGraceHJ(mlir::Value left, mlir::Value right, mlir::ArrayAttr nullsEqual, mlir::ArrayAttr hashLeft, mlir::ArrayAttr hashRight, relalg::ColumnSet leftColumns, relalg::ColumnSet rightColumns, mlir::ConversionPatternRewriter& rewriter, mlir::Location loc, std::function<mlir::Value(mlir::Value, mlir::ConversionPatternRewriter& rewriter)> fn) {
+   auto* ctxt = rewriter.getContext();
+   leftColumns.insert(relalg::ColumnSet::fromArrayAttr(hashLeft));
+   rightColumns.insert(relalg::ColumnSet::fromArrayAttr(hashRight));
+   MaterializationHelper probeHelper(leftColumns, ctxt);
+   MaterializationHelper buildHelper(rightColumns, ctxt);
+   auto [probeBuffer, probeHashMember] = materializeForGraceHJ(left, hashLeft, probeHelper, rewriter, loc);
+   auto [buildBuffer, buildHashMember] = materializeForGraceHJ(right, hashRight, buildHelper, rewriter, loc);
+   auto buildMembers = mlir::cast<subop::BufferType>(buildBuffer.getType()).getMembers();
+   auto probeMembers = mlir::cast<subop::BufferType>(probeBuffer.getType()).getMembers();
+   auto viewType = subop::GraceJoinViewType::get(ctxt, buildMembers, probeMembers);
+   mlir::Value view = rewriter.create<subop::CreateGraceJoinView>(loc, viewType, buildBuffer, probeBuffer, buildHashMember, probeHashMember);
+   mlir::Value scan = rewriter.create<subop::ScanOp>(loc, view, buildHelper.createStateColumnMapping(probeHelper.createStateColumnMapping().getValue()));
+
+   // eliminate hash collisions
+   auto [markerAttrDef, markerAttrRef] = createColumn(rewriter.getI1Type(), "map", "predicate");
+   auto [block, refCols] = createVerifyEqFnForTuple(rewriter, hashLeft, hashRight, nullsEqual, loc);
+   subop::MapOp keep = rewriter.create<subop::MapOp>(loc, tuples::TupleStreamType::get(ctxt), scan, rewriter.getArrayAttr(markerAttrDef), refCols);
+   keep.getFn().push_back(block);
+   mlir::Value filtered = rewriter.create<subop::FilterOp>(loc, keep, subop::FilterSemantic::all_true, rewriter.getArrayAttr(markerAttrRef));
+   return fn(filtered, rewriter);
+}
+//blocked nested-loop join: both sides are materialized, the runtime pairs cache-sized blocks of the build side with batches of the probe side and
+//distributes the batches over the workers, the generated code loops over every pair of entries and applies fn, i.e., the join predicate, in the inner loop
+static mlir::Value translateBlockNLJ(mlir::Value left, mlir::Value right, relalg::ColumnSet leftColumns, relalg::ColumnSet rightColumns, std::optional<double> buildRows, mlir::ConversionPatternRewriter& rewriter, mlir::Location loc, std::function<mlir::Value(mlir::Value, mlir::ConversionPatternRewriter& rewriter)> fn) {
+   auto* ctxt = rewriter.getContext();
+   MaterializationHelper probeHelper(leftColumns, ctxt);
+   MaterializationHelper buildHelper(rightColumns, ctxt);
+   mlir::Value probeBuffer = rewriter.create<subop::GenericCreateOp>(loc, subop::BufferType::get(ctxt, probeHelper.createStateMembersAttr()));
+   rewriter.create<subop::MaterializeOp>(loc, left, probeBuffer, probeHelper.createColumnstateMapping());
+   mlir::Value buildBuffer = rewriter.create<subop::GenericCreateOp>(loc, subop::BufferType::get(ctxt, buildHelper.createStateMembersAttr()));
+   setInitialCapacity(buildBuffer, buildRows);
+   rewriter.create<subop::MaterializeOp>(loc, right, buildBuffer, buildHelper.createColumnstateMapping());
+   auto buildMembers = mlir::cast<subop::BufferType>(buildBuffer.getType()).getMembers();
+   auto probeMembers = mlir::cast<subop::BufferType>(probeBuffer.getType()).getMembers();
+   auto viewType = subop::NestedLoopJoinViewType::get(ctxt, buildMembers, probeMembers);
+   mlir::Value view = rewriter.create<subop::CreateNestedLoopJoinView>(loc, viewType, buildBuffer, probeBuffer);
+   mlir::Value scan = rewriter.create<subop::ScanOp>(loc, view, buildHelper.createStateColumnMapping(probeHelper.createStateColumnMapping().getValue()));
+   return fn(scan, rewriter);
+}
+//band join: the build side is sorted by the key, every probe tuple binary-searches the range of entries whose key lies within its bounds
+//the full predicate is still applied to the produced pairs by fn
+static mlir::Value translateRangeJoin(mlir::Value left, mlir::Value right, tuples::ColumnRefAttr key, tuples::ColumnRefAttr lower, tuples::ColumnRefAttr upper, bool lowerInclusive, bool upperInclusive, relalg::ColumnSet columns, std::optional<double> buildRows, mlir::ConversionPatternRewriter& rewriter, mlir::Location loc, std::function<mlir::Value(mlir::Value, mlir::ConversionPatternRewriter& rewriter)> fn) {
+   auto* ctxt = rewriter.getContext();
+   auto tupleStreamType = tuples::TupleStreamType::get(ctxt);
+   //entries with a NULL key can not match
+   if (mlir::isa<db::NullableType>(key.getColumn().type)) {
+      auto [isNullDef, isNullRef] = createColumn(rewriter.getI1Type(), "range_join", "key_is_null");
+      right = map(right, rewriter, loc, rewriter.getArrayAttr(isNullDef), [&](mlir::ConversionPatternRewriter& rewriter, subop::MapCreationHelper& helper, mlir::Location loc) {
+         return std::vector<mlir::Value>{rewriter.create<db::IsNullOp>(loc, rewriter.getI1Type(), helper.access(key, loc))};
+      });
+      right = rewriter.create<subop::FilterOp>(loc, right, subop::FilterSemantic::none_true, rewriter.getArrayAttr(isNullRef));
+   }
+   columns.insert(&key.getColumn());
+   MaterializationHelper helper(columns, ctxt);
+   auto bufferType = subop::BufferType::get(ctxt, helper.createStateMembersAttr());
+   mlir::Value buffer = rewriter.create<subop::GenericCreateOp>(loc, bufferType);
+   setInitialCapacity(buffer, buildRows);
+   rewriter.create<subop::MaterializeOp>(loc, right, buffer, helper.createColumnstateMapping());
+   auto sortSpecs = rewriter.getArrayAttr(relalg::SortSpecificationAttr::get(ctxt, key, relalg::SortSpec::asc));
+   mlir::Value sortedView = createSortedView(rewriter, buffer, sortSpecs, loc, helper);
+   mlir::Value view = rewriter.create<subop::CreateContinuousView>(loc, subop::ContinuousViewType::get(ctxt, mlir::cast<subop::State>(sortedView.getType())), sortedView);
+   auto keyMember = helper.lookupStateMemberForMaterializedColumn(&key.getColumn());
+
+   //position of the first entry that satisfies the lower bound, or of the first entry that violates the upper bound
+   auto searchBound = [&](mlir::Value stream, tuples::ColumnRefAttr bound, bool isLower, bool inclusive) -> std::pair<mlir::Value, tuples::ColumnRefAttr> {
+      auto [posDef, posRef] = createColumn(rewriter.getIndexType(), "range_join", "pos");
+      std::vector<mlir::Attribute> keys;
+      auto* block = new Block;
+      mlir::Value entryKey = block->addArgument(key.getColumn().type, loc);
+      {
+         mlir::OpBuilder::InsertionGuard guard(rewriter);
+         rewriter.setInsertionPointToStart(block);
+         mlir::Value sortsBefore;
+         if (!bound) {
+            //unbounded: the range starts at the first entry or ends after the last entry
+            sortsBefore = rewriter.create<mlir::arith::ConstantIntOp>(loc, !isLower, 1);
+         } else {
+            keys.push_back(bound);
+            mlir::Value boundVal = block->addArgument(bound.getColumn().type, loc);
+            auto predicate = isLower != inclusive ? db::DBCmpPredicate::lte : db::DBCmpPredicate::lt;
+            sortsBefore = rewriter.create<db::CmpOp>(loc, predicate, entryKey, boundVal);
+            if (mlir::isa<db::NullableType>(sortsBefore.getType())) {
+               sortsBefore = rewriter.create<db::DeriveTruth>(loc, sortsBefore);
+            }
+         }
+         rewriter.create<tuples::ReturnOp>(loc, sortsBefore);
+      }
+      auto searchOp = rewriter.create<subop::BinarySearchOp>(loc, stream, view, rewriter.getArrayAttr({keyMember}), rewriter.getArrayAttr(keys), posDef);
+      searchOp.getFn().push_back(block);
+      return {searchOp.getResult(), posRef};
+   };
+   auto [withBegin, beginRef] = searchBound(left, lower, true, lowerInclusive);
+   auto [withEnd, endRef] = searchBound(withBegin, upper, false, upperInclusive);
+
+   auto nestedMapOp = rewriter.create<subop::NestedMapOp>(loc, tupleStreamType, withEnd, rewriter.getArrayAttr({beginRef, endRef}));
+   auto* b = new Block;
+   mlir::Value tuple = b->addArgument(tuples::TupleType::get(ctxt), loc);
+   mlir::Value beginPos = b->addArgument(rewriter.getIndexType(), loc);
+   mlir::Value endPos = b->addArgument(rewriter.getIndexType(), loc);
+   nestedMapOp.getRegion().push_back(b);
+   {
+      mlir::OpBuilder::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToStart(b);
+      auto [idxDef, idxRef] = createColumn(rewriter.getIndexType(), "range_join", "idx");
+      auto generateOp = rewriter.create<subop::GenerateOp>(loc, std::vector<mlir::Type>{tupleStreamType, tupleStreamType}, rewriter.getArrayAttr({idxDef}));
+      {
+         auto* generateBlock = new Block;
+         mlir::OpBuilder::InsertionGuard guard2(rewriter);
+         rewriter.setInsertionPointToStart(generateBlock);
+         generateOp.getRegion().push_back(generateBlock);
+         mlir::Value oneIdx = rewriter.create<mlir::arith::ConstantIndexOp>(loc, 1);
+         rewriter.create<mlir::scf::ForOp>(loc, beginPos, endPos, oneIdx, mlir::ValueRange{}, [&](mlir::OpBuilder& b, mlir::Location loc, mlir::Value idx, mlir::ValueRange vr) {
+            b.create<subop::GenerateEmitOp>(loc, mlir::ValueRange{idx});
+            b.create<mlir::scf::YieldOp>(loc);
+         });
+         rewriter.create<tuples::ReturnOp>(loc);
+      }
+      auto viewRefType = subop::ContinuousEntryRefType::get(ctxt, mlir::cast<subop::ContinuousViewType>(view.getType()));
+      auto [beginRefDef, beginRefRef] = createColumn(viewRefType, "range_join", "begin");
+      auto [entryRefDef, entryRefRef] = createColumn(viewRefType, "range_join", "entry");
+      mlir::Value stream = rewriter.create<subop::GetBeginReferenceOp>(loc, generateOp.getRes(), view, beginRefDef);
+      stream = rewriter.create<subop::OffsetReferenceBy>(loc, stream, beginRefRef, idxRef, entryRefDef);
+      stream = rewriter.create<subop::GatherOp>(loc, stream, entryRefRef, helper.createStateColumnMapping());
+      mlir::Value combined = rewriter.create<subop::CombineTupleOp>(loc, stream, tuple);
+      rewriter.create<tuples::ReturnOp>(loc, fn(combined, rewriter));
+   }
+   return nestedMapOp.getRes();
+}
+static mlir::Value translateNL(mlir::Value left, mlir::Value right, bool useHash, bool useIndexNestedLoop, mlir::ArrayAttr nullsEqual, mlir::ArrayAttr hashLeft, mlir::ArrayAttr hashRight, relalg::ColumnSet columns, std::optional<double> buildRows, bool filterable, mlir::ConversionPatternRewriter& rewriter, mlir::Operation* op, std::function<mlir::Value(mlir::Value, mlir::ConversionPatternRewriter& rewriter)> fn) {
    if (useHash) {
-      return translateHJ(left, right, nullsEqual, hashLeft, hashRight, columns, rewriter, op->getLoc(), fn);
+      return translateHJ(left, right, nullsEqual, hashLeft, hashRight, columns, buildRows, filterable, rewriter, op->getLoc(), fn);
    } else if (useIndexNestedLoop) {
       return translateINLJ(left, right, nullsEqual, hashLeft, hashRight, columns, rewriter, op, fn);
    } else {
@@ -1184,6 +1377,75 @@ static mlir::Value translateNL(mlir::Value left, mlir::Value right, bool useHash
    }
 }
 
+//hash join that only determines whether a match exists: the build side is deduplicated by its keys while it is inserted into a hash set,
+//so that every probe tuple finds at most one entry instead of walking all duplicates of its key
+static mlir::Value translateSetHJ(mlir::Value left, mlir::Value right, mlir::ArrayAttr nullsEqual, mlir::ArrayAttr hashLeft, mlir::ArrayAttr hashRight, std::optional<double> buildRows, mlir::ConversionPatternRewriter& rewriter, mlir::Location loc, std::function<mlir::Value(mlir::Value, mlir::ConversionPatternRewriter& rewriter)> fn) {
+   auto* ctxt = rewriter.getContext();
+   MaterializationHelper keyHelper(hashRight, ctxt);
+   auto setType = subop::MapType::get(ctxt, keyHelper.createStateMembersAttr(), subop::StateMembersAttr::get(ctxt, rewriter.getArrayAttr({}), rewriter.getArrayAttr({})), false);
+   mlir::Value set = rewriter.create<subop::GenericCreateOp>(loc, setType);
+   setInitialCapacity(set, buildRows);
+   auto [insertRefDef, insertRefRef] = createColumn(subop::LookupEntryRefType::get(ctxt, setType), "lookup", "ref");
+   auto insertOp = rewriter.create<subop::LookupOrInsertOp>(loc, tuples::TupleStreamType::get(ctxt), right, set, hashRight, insertRefDef);
+   {
+      auto* initialValueBlock = new Block;
+      mlir::OpBuilder::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToStart(initialValueBlock);
+      rewriter.create<tuples::ReturnOp>(loc);
+      insertOp.getInitFn().push_back(initialValueBlock);
+   }
+   insertOp.getEqFn().push_back(createEqFn(rewriter, hashRight, hashRight, nullsEqual, loc));
+   auto reduceOp = rewriter.create<subop::ReduceOp>(loc, insertOp, insertRefRef, rewriter.getArrayAttr({}), rewriter.getArrayAttr({}));
+   {
+      mlir::Block* reduceBlock = new Block;
+      mlir::OpBuilder::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToStart(reduceBlock);
+      rewriter.create<tuples::ReturnOp>(loc, mlir::ValueRange({}));
+      reduceOp.getRegion().push_back(reduceBlock);
+   }
+   {
+      mlir::Block* combineBlock = new Block;
+      mlir::OpBuilder::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToStart(combineBlock);
+      rewriter.create<tuples::ReturnOp>(loc, mlir::ValueRange({}));
+      reduceOp.getCombine().push_back(combineBlock);
+   }
+
+   auto entryRefType = subop::MapEntryRefType::get(ctxt, setType);
+   auto entryRefListType = subop::ListType::get(ctxt, entryRefType);
+   auto [listDef, listRef] = createColumn(entryRefListType, "lookup", "list");
+   auto [entryDef, entryRef] = createColumn(entryRefType, "lookup", "entryref");
+   auto afterLookup = rewriter.create<subop::LookupOp>(loc, tuples::TupleStreamType::get(ctxt), left, set, hashLeft, listDef);
+   afterLookup.getEqFn().push_back(createEqFn(rewriter, hashRight, hashLeft, nullsEqual, loc));
+   auto nestedMapOp = rewriter.create<subop::NestedMapOp>(loc, tuples::TupleStreamType::get(ctxt), afterLookup, rewriter.getArrayAttr(listRef));
+   auto* b = new Block;
+   mlir::Value tuple = b->addArgument(tuples::TupleType::get(ctxt), loc);
+   mlir::Value list = b->addArgument(entryRefListType, loc);
+   nestedMapOp.getRegion().push_back(b);
+   {
+      mlir::OpBuilder::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToStart(b);
+      auto [markerState, markerName] = createMarkerState(rewriter, loc);
+      mlir::Value scan = rewriter.create<subop::ScanListOp>(loc, list, entryDef);
+      mlir::Value gathered = rewriter.create<subop::GatherOp>(loc, scan, entryRef, keyHelper.createStateColumnMapping());
+      mlir::Value combined = rewriter.create<subop::CombineTupleOp>(loc, gathered, tuple);
+      rewriter.create<tuples::ReturnOp>(loc, fn(combined, rewriter));
+   }
+   return nestedMapOp.getRes();
+}
+//like translateNL, for joins that only need to know whether a probe tuple has a match
+//if the required columns of the build side are all join keys, duplicates of a key can not change the result and are dropped while building
+static mlir::Value translateExistenceNL(mlir::Value left, mlir::Value right, bool useHash, bool useIndexNestedLoop, mlir::ArrayAttr nullsEqual, mlir::ArrayAttr hashLeft, mlir::ArrayAttr hashRight, relalg::ColumnSet columns, std::optional<double> buildRows, bool filterable, mlir::ConversionPatternRewriter& rewriter, mlir::Operation* op, std::function<mlir::Value(mlir::Value, mlir::ConversionPatternRewriter& rewriter)> fn) {
+   if (useHash && existenceJoinAsSet.getValue()) {
+      auto valueColumns = columns;
+      valueColumns.remove(relalg::ColumnSet::fromArrayAttr(hashRight));
+      if (valueColumns.empty()) {
+         return translateSetHJ(left, right, nullsEqual, hashLeft, hashRight, buildRows, rewriter, op->getLoc(), fn);
+      }
+   }
+   return translateNL(left, right, useHash, useIndexNestedLoop, nullsEqual, hashLeft, hashRight, columns, buildRows, filterable, rewriter, op, fn);
+}
+
 static std::pair<mlir::Value, mlir::Value> translateNLJWithMarker(mlir::Value left, mlir::Value right, relalg::ColumnSet columns, mlir::ConversionPatternRewriter& rewriter, mlir::Location loc, tuples::ColumnDefAttr markerDefAttr, std::function<mlir::Value(mlir::Value, mlir::Value, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr, std::string markerName)> fn) {
    auto& colManager = rewriter.getContext()->getLoadedDialect<tuples::TupleStreamDialect>()->getColumnManager();
    MaterializationHelper helper(columns, rewriter.getContext());
@@ -1215,7 +1477,7 @@ static std::pair<mlir::Value, mlir::Value> translateNLJWithMarker(mlir::Value le
    return {nestedMapOp.getRes(), rewriter.create<subop::ScanOp>(loc, vector, helper.createStateColumnMapping())};
 }
 
-static std::pair<mlir::Value, mlir::Value> translateHJWithMarker(mlir::Value left, mlir::Value right, mlir::ArrayAttr nullsEqual, mlir::ArrayAttr hashLeft, mlir::ArrayAttr hashRight, relalg::ColumnSet columns, mlir::ConversionPatternRewriter& rewriter, mlir::Location loc, tuples::ColumnDefAttr markerDefAttr, std::function<mlir::Value(mlir::Value, mlir::Value, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr, std::string markerName)> fn) {
+static std::pair<mlir::Value, mlir::Value> translateHJWithMarker(mlir::Value left, mlir::Value right, mlir::ArrayAttr nullsEqual, mlir::ArrayAttr hashLeft, mlir::ArrayAttr hashRight, relalg::ColumnSet columns, std::optional<double> buildRows, mlir::ConversionPatternRewriter& rewriter, mlir::Location loc, tuples::ColumnDefAttr markerDefAttr, std::function<mlir::Value(mlir::Value, mlir::Value, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr, std::string markerName)> fn) {
    auto keyColumns = relalg::ColumnSet::fromArrayAttr(hashLeft);
    MaterializationHelper keyHelper(hashLeft, rewriter.getContext());
    auto valueColumns = columns;
@@ -1224,6 +1486,7 @@ static std::pair<mlir::Value, mlir::Value> translateHJWithMarker(mlir::Value lef
    auto flagMember = valueHelper.addFlag(markerDefAttr);
    auto multiMapType = subop::MultiMapType::get(rewriter.getContext(), keyHelper.createStateMembersAttr(), valueHelper.createStateMembersAttr());
    mlir::Value multiMap = rewriter.create<subop::GenericCreateOp>(loc, multiMapType);
+   setInitialCapacity(multiMap, buildRows);
    left = mapBool(left, rewriter, loc, false, &markerDefAttr.getColumn());
    auto insertOp = rewriter.create<subop::InsertOp>(loc, left, multiMap, keyHelper.createColumnstateMapping(valueHelper.createColumnstateMapping().getValue()));
    insertOp.getEqFn().push_back(createEqFn(rewriter, hashLeft, hashLeft, nullsEqual, loc));
@@ -1255,9 +1518,9 @@ static std::pair<mlir::Value, mlir::Value> translateHJWithMarker(mlir::Value lef
    }
    return {nestedMapOp.getRes(), rewriter.create<subop::ScanOp>(loc, multiMap, keyHelper.createStateColumnMapping(valueHelper.createStateColumnMapping().getValue()))};
 }
-static std::pair<mlir::Value, mlir::Value> translateNLWithMarker(mlir::Value left, mlir::Value right, bool useHash, mlir::ArrayAttr nullsEqual, mlir::ArrayAttr hashLeft, mlir::ArrayAttr hashRight, relalg::ColumnSet columns, mlir::ConversionPatternRewriter& rewriter, mlir::Location loc, tuples::ColumnDefAttr markerDefAttr, std::function<mlir::Value(mlir::Value, mlir::Value, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr, std::string markerName)> fn) {
+static std::pair<mlir::Value, mlir::Value> translateNLWithMarker(mlir::Value left, mlir::Value right, bool useHash, mlir::ArrayAttr nullsEqual, mlir::ArrayAttr hashLeft, mlir::ArrayAttr hashRight, relalg::ColumnSet columns, std::optional<double> buildRows, mlir::ConversionPatternRewriter& rewriter, mlir::Location loc, tuples::ColumnDefAttr markerDefAttr, std::function<mlir::Value(mlir::Value, mlir::Value, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr, std::string markerName)> fn) {
    if (useHash) {
-      return translateHJWithMarker(left, right, nullsEqual, hashLeft, hashRight, columns, rewriter, loc, markerDefAttr, fn);
+      return translateHJWithMarker(left, right, nullsEqual, hashLeft, hashRight, columns, buildRows, rewriter, loc, markerDefAttr, fn);
    } else {
       return translateNLJWithMarker(left, right, columns, rewriter, loc, markerDefAttr, fn);
    }
@@ -1278,7 +1541,15 @@ class CrossProductLowering : public OpConversionPattern<relalg::CrossProductOp>
    using OpConversionPattern<relalg::CrossProductOp>::OpConversionPattern;
 
    LogicalResult matchAndRewrite(relalg::CrossProductOp crossProductOp, OpAdaptor adaptor, ConversionPatternRewriter& rewriter) const override {
-      rewriter.replaceOp(crossProductOp, translateNL(adaptor.getRight(), adaptor.getLeft(), false, false, mlir::ArrayAttr(), mlir::ArrayAttr(), mlir::ArrayAttr(), getRequired(mlir::cast<Operator>(crossProductOp.getLeft().getDefiningOp())), rewriter, crossProductOp, [](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
+      auto leftColumns = getRequired(mlir::cast<Operator>(crossProductOp.getLeft().getDefiningOp()));
+      auto rightColumns = getRequired(mlir::cast<Operator>(crossProductOp.getRight().getDefiningOp()));
+      if (blockNestedLoopJoin.getValue() && !leftColumns.empty() && !rightColumns.empty()) {
+         rewriter.replaceOp(crossProductOp, translateBlockNLJ(adaptor.getRight(), adaptor.getLeft(), rightColumns, leftColumns, getEstimatedRows(crossProductOp.getLeft()), rewriter, crossProductOp->getLoc(), [](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
+                               return v;
+                            }));
+         return success();
+      }
+      rewriter.replaceOp(crossProductOp, translateNL(adaptor.getRight(), adaptor.getLeft(), false, false, mlir::ArrayAttr(), mlir::ArrayAttr(), mlir::ArrayAttr(), getRequired(mlir::cast<Operator>(crossProductOp.getLeft().getDefiningOp())), getEstimatedRows(crossProductOp.getLeft()), false, rewriter, crossProductOp, [](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
                             return v;
                          }));
       return success();
@@ -1295,7 +1566,38 @@ class InnerJoinNLLowering : public OpConversionPattern<relalg::InnerJoinOp> {
       auto rightHash = innerJoinOp->getAttrOfType<mlir::ArrayAttr>("rightHash");
       auto leftHash = innerJoinOp->getAttrOfType<mlir::ArrayAttr>("leftHash");
       auto nullsEqual = innerJoinOp->getAttrOfType<mlir::ArrayAttr>("nullsEqual");
-      rewriter.replaceOp(innerJoinOp, translateNL(adaptor.getRight(), adaptor.getLeft(), useHash, useIndexNestedLoop, nullsEqual, rightHash, leftHash, getRequired(mlir::cast<Operator>(innerJoinOp.getLeft().getDefiningOp())), rewriter, innerJoinOp, [loc, &innerJoinOp](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
+      if (useHash && innerJoinOp->hasAttr("useGraceHashJoin")) {
+         auto leftColumns = getRequired(mlir::cast<Operator>(innerJoinOp.getLeft().getDefiningOp()));
+         auto rightColumns = getRequired(mlir::cast<Operator>(innerJoinOp.getRight().getDefiningOp()));
+         rewriter.replaceOp(innerJoinOp, translateGraceHJ(adaptor.getRight(), adaptor.getLeft(), nullsEqual, rightHash, leftHash, rightColumns, leftColumns, rewriter, loc, [loc, &innerJoinOp](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
+                               return translateSelection(v, innerJoinOp.getPredicate(), rewriter, loc);
+                            }));
+         return success();
+      }
+      if (innerJoinOp->hasAttr("useRangeJoin")) {
+         bool buildRight = innerJoinOp->hasAttr("rangeBuildRight");
+         auto build = buildRight ? innerJoinOp.getRight() : innerJoinOp.getLeft();
+         auto key = innerJoinOp->getAttrOfType<tuples::ColumnRefAttr>("rangeKey");
+         auto lower = innerJoinOp->getAttrOfType<tuples::ColumnRefAttr>("rangeLower");
+         auto upper = innerJoinOp->getAttrOfType<tuples::ColumnRefAttr>("rangeUpper");
+         bool lowerInclusive = innerJoinOp->hasAttr("rangeLowerInclusive");
+         bool upperInclusive = innerJoinOp->hasAttr("rangeUpperInclusive");
+         rewriter.replaceOp(innerJoinOp, translateRangeJoin(buildRight ? adaptor.getLeft() : adaptor.getRight(), buildRight ? adaptor.getRight() : adaptor.getLeft(), key, lower, upper, lowerInclusive, upperInclusive, getRequired(mlir::cast<Operator>(build.getDefiningOp())), getEstimatedRows(build), rewriter, loc, [loc, &innerJoinOp](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
+                               return translateSelection(v, innerJoinOp.getPredicate(), rewriter, loc);
+                            }));
+         return success();
+      }
+      if (!useHash && !useIndexNestedLoop && blockNestedLoopJoin.getValue()) {
+         auto leftColumns = getRequired(mlir::cast<Operator>(innerJoinOp.getLeft().getDefiningOp()));
+         auto rightColumns = getRequired(mlir::cast<Operator>(innerJoinOp.getRight().getDefiningOp()));
+         if (!leftColumns.empty() && !rightColumns.empty()) {
+            rewriter.replaceOp(innerJoinOp, translateBlockNLJ(adaptor.getRight(), adaptor.getLeft(), rightColumns, leftColumns, getEstimatedRows(innerJoinOp.getLeft()), rewriter, loc, [loc, &innerJoinOp](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
+                                  return translateSelection(v, innerJoinOp.getPredicate(), rewriter, loc);
+                               }));
+            return success();
+         }
+      }
+      rewriter.replaceOp(innerJoinOp, translateNL(adaptor.getRight(), adaptor.getLeft(), useHash, useIndexNestedLoop, nullsEqual, rightHash, leftHash, getRequired(mlir::cast<Operator>(innerJoinOp.getLeft().getDefiningOp())), getEstimatedRows(innerJoinOp.getLeft()), true, rewriter, innerJoinOp, [loc, &innerJoinOp](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
                             return translateSelection(v, innerJoinOp.getPredicate(), rewriter, loc);
                          }));
       return success();
@@ -1315,14 +1617,14 @@ class SemiJoinLowering : public OpConversionPattern<relalg::SemiJoinOp> {
       auto nullsEqual = semiJoinOp->getAttrOfType<mlir::ArrayAttr>("nullsEqual");
 
       if (!reverse) {
-         rewriter.replaceOp(semiJoinOp, translateNL(adaptor.getLeft(), adaptor.getRight(), useHash, useIndexNestedLoop, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(semiJoinOp.getRight().getDefiningOp())), rewriter, semiJoinOp, [loc, &semiJoinOp](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
+         rewriter.replaceOp(semiJoinOp, translateExistenceNL(adaptor.getLeft(), adaptor.getRight(), useHash, useIndexNestedLoop, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(semiJoinOp.getRight().getDefiningOp())), getEstimatedRows(semiJoinOp.getRight()), true, rewriter, semiJoinOp, [loc, &semiJoinOp](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
                                auto filtered = translateSelection(v, semiJoinOp.getPredicate(), rewriter, loc);
                                auto [markerDefAttr, markerRefAttr] = createColumn(rewriter.getI1Type(), "marker", "marker");
                                return rewriter.create<subop::FilterOp>(loc, anyTuple(filtered, markerDefAttr, rewriter, loc), subop::FilterSemantic::all_true, rewriter.getArrayAttr({markerRefAttr}));
                             }));
       } else {
          auto [flagAttrDef, flagAttrRef] = createColumn(rewriter.getI1Type(), "materialized", "marker");
-         auto [_, scan] = translateNLWithMarker(adaptor.getLeft(), adaptor.getRight(), useHash, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(semiJoinOp.getLeft().getDefiningOp())), rewriter, loc, flagAttrDef, [loc, &semiJoinOp](mlir::Value v, mlir::Value, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr ref, std::string flagMember) -> mlir::Value {
+         auto [_, scan] = translateNLWithMarker(adaptor.getLeft(), adaptor.getRight(), useHash, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(semiJoinOp.getLeft().getDefiningOp())), getEstimatedRows(semiJoinOp.getLeft()), rewriter, loc, flagAttrDef, [loc, &semiJoinOp](mlir::Value v, mlir::Value, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr ref, std::string flagMember) -> mlir::Value {
             auto filtered = translateSelection(v, semiJoinOp.getPredicate(), rewriter, loc);
             auto [markerDefAttr, markerRefAttr] = createColumn(rewriter.getI1Type(), "marker", "marker");
             auto afterBool = mapBool(filtered, rewriter, loc, true, &markerDefAttr.getColumn());
@@ -1348,12 +1650,12 @@ class MarkJoinLowering : public OpConversionPattern<relalg::MarkJoinOp> {
       auto nullsEqual = markJoinOp->getAttrOfType<mlir::ArrayAttr>("nullsEqual");
 
       if (!reverse) {
-         rewriter.replaceOp(markJoinOp, translateNL(adaptor.getLeft(), adaptor.getRight(), useHash, useIndexNestedLoop, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(markJoinOp.getRight().getDefiningOp())), rewriter, markJoinOp, [loc, &markJoinOp](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
+         rewriter.replaceOp(markJoinOp, translateExistenceNL(adaptor.getLeft(), adaptor.getRight(), useHash, useIndexNestedLoop, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(markJoinOp.getRight().getDefiningOp())), getEstimatedRows(markJoinOp.getRight()), false, rewriter, markJoinOp, [loc, &markJoinOp](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
                                auto filtered = translateSelection(v, markJoinOp.getPredicate(), rewriter, loc);
                                return anyTuple(filtered, markJoinOp.getMarkattr(), rewriter, loc);
                             }));
       } else {
-         auto [_, scan] = translateNLWithMarker(adaptor.getLeft(), adaptor.getRight(), useHash, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(markJoinOp.getLeft().getDefiningOp())), rewriter, loc, markJoinOp.getMarkattr(), [loc, &markJoinOp](mlir::Value v, mlir::Value, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr ref, std::string flagMember) -> mlir::Value {
+         auto [_, scan] = translateNLWithMarker(adaptor.getLeft(), adaptor.getRight(), useHash, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(markJoinOp.getLeft().getDefiningOp())), getEstimatedRows(markJoinOp.getLeft()), rewriter, loc, markJoinOp.getMarkattr(), [loc, &markJoinOp](mlir::Value v, mlir::Value, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr ref, std::string flagMember) -> mlir::Value {
             auto filtered = translateSelection(v, markJoinOp.getPredicate(), rewriter, loc);
             auto [markerDefAttr, markerRefAttr] = createColumn(rewriter.getI1Type(), "marker", "marker");
             auto afterBool = mapBool(filtered, rewriter, loc, true, &markerDefAttr.getColumn());
@@ -1379,14 +1681,14 @@ class AntiSemiJoinLowering : public OpConversionPattern<relalg::AntiSemiJoinOp>
       auto nullsEqual = antiSemiJoinOp->getAttrOfType<mlir::ArrayAttr>("nullsEqual");
 
       if (!reverse) {
-         rewriter.replaceOp(antiSemiJoinOp, translateNL(adaptor.getLeft(), adaptor.getRight(), useHash, useIndexNestedLoop, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(antiSemiJoinOp.getRight().getDefiningOp())), rewriter, antiSemiJoinOp, [loc, &antiSemiJoinOp](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
+         rewriter.replaceOp(antiSemiJoinOp, translateExistenceNL(adaptor.getLeft(), adaptor.getRight(), useHash, useIndexNestedLoop, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(antiSemiJoinOp.getRight().getDefiningOp())), getEstimatedRows(antiSemiJoinOp.getRight()), false, rewriter, antiSemiJoinOp, [loc, &antiSemiJoinOp](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
                                auto filtered = translateSelection(v, antiSemiJoinOp.getPredicate(), rewriter, loc);
                                auto [markerDefAttr, markerRefAttr] = createColumn(rewriter.getI1Type(), "marker", "marker");
                                return rewriter.create<subop::FilterOp>(loc, anyTuple(filtered, markerDefAttr, rewriter, loc), subop::FilterSemantic::none_true, rewriter.getArrayAttr({markerRefAttr}));
                             }));
       } else {
          auto [flagAttrDef, flagAttrRef] = createColumn(rewriter.getI1Type(), "materialized", "marker");
-         auto [_, scan] = translateNLWithMarker(adaptor.getLeft(), adaptor.getRight(), useHash, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(antiSemiJoinOp.getLeft().getDefiningOp())), rewriter, loc, flagAttrDef, [loc, &antiSemiJoinOp](mlir::Value v, mlir::Value, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr ref, std::string flagMember) -> mlir::Value {
+         auto [_, scan] = translateNLWithMarker(adaptor.getLeft(), adaptor.getRight(), useHash, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(antiSemiJoinOp.getLeft().getDefiningOp())), getEstimatedRows(antiSemiJoinOp.getLeft()), rewriter, loc, flagAttrDef, [loc, &antiSemiJoinOp](mlir::Value v, mlir::Value, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr ref, std::string flagMember) -> mlir::Value {
             auto filtered = translateSelection(v, antiSemiJoinOp.getPredicate(), rewriter, loc);
             auto [markerDefAttr, markerRefAttr] = createColumn(rewriter.getI1Type(), "marker", "marker");
             auto afterBool = mapBool(filtered, rewriter, loc, true, &markerDefAttr.getColumn());
@@ -1412,7 +1714,7 @@ class FullOuterJoinLowering : public OpConversionPattern<relalg::FullOuterJoinOp
       auto nullsEqual = semiJoinOp->getAttrOfType<mlir::ArrayAttr>("nullsEqual");
 
       auto [flagAttrDef, flagAttrRef] = createColumn(rewriter.getI1Type(), "materialized", "marker");
-      auto [stream, scan] = translateNLWithMarker(adaptor.getLeft(), adaptor.getRight(), useHash, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(semiJoinOp.getLeft().getDefiningOp())), rewriter, loc, flagAttrDef, [loc, &semiJoinOp, leftColumns, rightColumns](mlir::Value v, mlir::Value tuple, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr ref, std::string flagMember) -> mlir::Value {
+      auto [stream, scan] = translateNLWithMarker(adaptor.getLeft(), adaptor.getRight(), useHash, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(semiJoinOp.getLeft().getDefiningOp())), getEstimatedRows(semiJoinOp.getLeft()), rewriter, loc, flagAttrDef, [loc, &semiJoinOp, leftColumns, rightColumns](mlir::Value v, mlir::Value tuple, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr ref, std::string flagMember) -> mlir::Value {
          auto filtered = translateSelection(v, semiJoinOp.getPredicate(), rewriter, loc);
          auto [markerDefAttr, markerRefAttr] = createColumn(rewriter.getI1Type(), "marker", "marker");
          auto afterBool = mapBool(filtered, rewriter, loc, true, &markerDefAttr.getColumn());
@@ -1449,7 +1751,7 @@ class OuterJoinLowering : public OpConversionPattern<relalg::OuterJoinOp> {
       auto nullsEqual = semiJoinOp->getAttrOfType<mlir::ArrayAttr>("nullsEqual");
 
       if (!reverse) {
-         rewriter.replaceOp(semiJoinOp, translateNL(adaptor.getLeft(), adaptor.getRight(), useHash, useIndexNestedLoop, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(semiJoinOp.getRight().getDefiningOp())), rewriter, semiJoinOp, [loc, &semiJoinOp](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
+         rewriter.replaceOp(semiJoinOp, translateNL(adaptor.getLeft(), adaptor.getRight(), useHash, useIndexNestedLoop, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(semiJoinOp.getRight().getDefiningOp())), getEstimatedRows(semiJoinOp.getRight()), false, rewriter, semiJoinOp, [loc, &semiJoinOp](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
                                auto filtered = translateSelection(v, semiJoinOp.getPredicate(), rewriter, loc);
                                auto [markerDefAttr, markerRefAttr] = createColumn(rewriter.getI1Type(), "marker", "marker");
                                Value filteredNoMatch = rewriter.create<subop::FilterOp>(loc, anyTuple(filtered, markerDefAttr, rewriter, loc), subop::FilterSemantic::none_true, rewriter.getArrayAttr({markerRefAttr}));
@@ -1459,7 +1761,7 @@ class OuterJoinLowering : public OpConversionPattern<relalg::OuterJoinOp> {
                             }));
       } else {
          auto [flagAttrDef, flagAttrRef] = createColumn(rewriter.getI1Type(), "materialized", "marker");
-         auto [stream, scan] = translateNLWithMarker(adaptor.getLeft(), adaptor.getRight(), useHash, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(semiJoinOp.getLeft().getDefiningOp())), rewriter, loc, flagAttrDef, [loc, &semiJoinOp](mlir::Value v, mlir::Value, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr ref, std::string flagMember) -> mlir::Value {
+         auto [stream, scan] = translateNLWithMarker(adaptor.getLeft(), adaptor.getRight(), useHash, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(semiJoinOp.getLeft().getDefiningOp())), getEstimatedRows(semiJoinOp.getLeft()), rewriter, loc, flagAttrDef, [loc, &semiJoinOp](mlir::Value v, mlir::Value, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr ref, std::string flagMember) -> mlir::Value {
             auto filtered = translateSelection(v, semiJoinOp.getPredicate(), rewriter, loc);
             auto [markerDefAttr, markerRefAttr] = createColumn(rewriter.getI1Type(), "marker", "marker");
             auto afterBool = mapBool(filtered, rewriter, loc, true, &markerDefAttr.getColumn());
@@ -1505,7 +1807,7 @@ class SingleJoinLowering : public OpConversionPattern<relalg::SingleJoinOp> {
          auto mappedNullable = mapColsToNullable(gathered.getRes(), rewriter, loc, semiJoinOp.getMapping());
          rewriter.replaceOp(semiJoinOp, mappedNullable);
       } else if (!reverse) {
-         rewriter.replaceOp(semiJoinOp, translateNL(adaptor.getLeft(), adaptor.getRight(), useHash, useIndexNestedLoop, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(semiJoinOp.getRight().getDefiningOp())), rewriter, semiJoinOp, [loc, &semiJoinOp](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
+         rewriter.replaceOp(semiJoinOp, translateNL(adaptor.getLeft(), adaptor.getRight(), useHash, useIndexNestedLoop, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(semiJoinOp.getRight().getDefiningOp())), getEstimatedRows(semiJoinOp.getRight()), false, rewriter, semiJoinOp, [loc, &semiJoinOp](mlir::Value v, mlir::ConversionPatternRewriter& rewriter) -> mlir::Value {
                                auto filtered = translateSelection(v, semiJoinOp.getPredicate(), rewriter, loc);
                                auto [markerDefAttr, markerRefAttr] = createColumn(rewriter.getI1Type(), "marker", "marker");
                                Value filteredNoMatch = rewriter.create<subop::FilterOp>(loc, anyTuple(filtered, markerDefAttr, rewriter, loc), subop::FilterSemantic::none_true, rewriter.getArrayAttr({markerRefAttr}));
@@ -1515,7 +1817,7 @@ class SingleJoinLowering : public OpConversionPattern<relalg::SingleJoinOp> {
                             }));
       } else {
          auto [flagAttrDef, flagAttrRef] = createColumn(rewriter.getI1Type(), "materialized", "marker");
-         auto [stream, scan] = translateNLWithMarker(adaptor.getLeft(), adaptor.getRight(), useHash, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(semiJoinOp.getLeft().getDefiningOp())), rewriter, loc, flagAttrDef, [loc, &semiJoinOp](mlir::Value v, mlir::Value, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr ref, std::string flagMember) -> mlir::Value {
+         auto [stream, scan] = translateNLWithMarker(adaptor.getLeft(), adaptor.getRight(), useHash, nullsEqual, leftHash, rightHash, getRequired(mlir::cast<Operator>(semiJoinOp.getLeft().getDefiningOp())), getEstimatedRows(semiJoinOp.getLeft()), rewriter, loc, flagAttrDef, [loc, &semiJoinOp](mlir::Value v, mlir::Value, mlir::ConversionPatternRewriter& rewriter, tuples::ColumnRefAttr ref, std::string flagMember) -> mlir::Value {
             auto filtered = translateSelection(v, semiJoinOp.getPredicate(), rewriter, loc);
             auto [markerDefAttr, markerRefAttr] = createColumn(rewriter.getI1Type(), "marker", "marker");
             auto afterBool = mapBool(filtered, rewriter, loc, true, &markerDefAttr.getColumn());
@@ -1572,7 +1874,7 @@ static mlir::Value spaceShipCompare(mlir::OpBuilder& builder, std::vector<std::p
       return compareRes;
    }
 }
-static mlir::Value createSortedView(ConversionPatternRewriter& rewriter, mlir::Value buffer, mlir::ArrayAttr sortSpecs, mlir::Location loc, MaterializationHelper& helper) {
+static mlir::Value createSortedView(ConversionPatternRewriter& rewriter, mlir::Value buffer, mlir::ArrayAttr sortSpecs, mlir::Location loc, MaterializationHelper& helper, bool external = false) {
    auto* block = new Block;
    std::vector<Attribute> sortByMembers;
    std::vector<Type> argumentTypes;
@@ -1586,6 +1888,7 @@ static mlir::Value createSortedView(ConversionPatternRewriter& rewriter, mlir::V
    block->addArguments(argumentTypes, locs);
    block->addArguments(argumentTypes, locs);
    std::vector<std::pair<mlir::Value, mlir::Value>> sortCriteria;
+   std::vector<mlir::Attribute> descending;
    for (auto attr : sortSpecs) {
       auto sortspecAttr = mlir::cast<relalg::SortSpecificationAttr>(attr);
       mlir::Value left = block->getArgument(sortCriteria.size());
@@ -1594,6 +1897,7 @@ static mlir::Value createSortedView(ConversionPatternRewriter& rewriter, mlir::V
          std::swap(left, right);
       }
       sortCriteria.push_back({left, right});
+      descending.push_back(rewriter.getBoolAttr(sortspecAttr.getSortSpec() == relalg::SortSpec::desc));
    }
    {
       mlir::OpBuilder::InsertionGuard guard(rewriter);
@@ -1604,11 +1908,20 @@ static mlir::Value createSortedView(ConversionPatternRewriter& rewriter, mlir::V
       rewriter.create<tuples::ReturnOp>(loc, isLt);
    }
 
-   auto subOpSort = rewriter.create<subop::CreateSortedViewOp>(loc, subop::SortedViewType::get(rewriter.getContext(), mlir::cast<subop::State>(buffer.getType())), buffer, rewriter.getArrayAttr(sortByMembers));
+   auto subOpSort = rewriter.create<subop::CreateSortedViewOp>(loc, subop::SortedViewType::get(rewriter.getContext(), mlir::cast<subop::State>(buffer.getType()), external), buffer, rewriter.getArrayAttr(sortByMembers));
    subOpSort.getRegion().getBlocks().push_back(block);
+   //the sort order of every member, allows to sort by normalized keys
+   subOpSort->setAttr("descending", rewriter.getArrayAttr(descending));
    return subOpSort.getResult();
 }
 class SortLowering : public OpConversionPattern<relalg::SortOp> {
+   static bool useExternalSort(relalg::SortOp sortOp) {
+      if (externalSortMinRows.getValue() <= 0) return false;
+      auto estimatedRows = getEstimatedRows(sortOp.getRel());
+      //without an estimate, assume the input can be large
+      return !estimatedRows || *estimatedRows >= externalSortMinRows.getValue();
+   }
+
    public:
    using OpConversionPattern<relalg::SortOp>::OpConversionPattern;
 
@@ -1619,8 +1932,9 @@ class SortLowering : public OpConversionPattern<relalg::SortOp> {
       MaterializationHelper helper(requiredColumns, rewriter.getContext());
       auto vectorType = subop::BufferType::get(rewriter.getContext(), helper.createStateMembersAttr());
       mlir::Value vector = rewriter.create<subop::GenericCreateOp>(sortOp->getLoc(), vectorType);
+      setInitialCapacity(vector, getEstimatedRows(sortOp.getRel()));
       rewriter.create<subop::MaterializeOp>(sortOp->getLoc(), adaptor.getRel(), vector, helper.createColumnstateMapping());
-      auto sortedView = createSortedView(rewriter, vector, sortOp.getSortspecs(), loc, helper);
+      auto sortedView = createSortedView(rewriter, vector, sortOp.getSortspecs(), loc, helper, useExternalSort(sortOp));
       auto scanOp = rewriter.replaceOpWithNewOp<subop::ScanOp>(sortOp, sortedView, helper.createStateColumnMapping());
       scanOp->setAttr("sequential", rewriter.getUnitAttr());
       return success();
@@ -1628,6 +1942,34 @@ class SortLowering : public OpConversionPattern<relalg::SortOp> {
 };
 
 class TopKLowering : public OpConversionPattern<relalg::TopKOp> {
+   //returns the first of the maps and filters directly preceding the top-k that does not depend on a map computing a sort key
+   static mlir::Operation* findBoundCheckUser(relalg::TopKOp topk, mlir::Value stream, mlir::Block* block) {
+      relalg::ColumnSet sortColumns;
+      for (auto attr : topk.getSortspecs()) {
+         sortColumns.insert(&mlir::cast<relalg::SortSpecificationAttr>(attr).getAttr().getColumn());
+      }
+      mlir::Operation* boundUser = nullptr;
+      mlir::Operation* consumer = topk.getOperation();
+      while (auto* defOp = stream.getDefiningOp()) {
+         if (!mlir::isa<subop::MapOp, subop::FilterOp>(defOp) || defOp->getBlock() != block) {
+            break;
+         }
+         //tuples of other consumers must not be dropped
+         if (llvm::any_of(stream.getUsers(), [&](mlir::Operation* user) { return user != consumer; })) {
+            break;
+         }
+         if (auto mapOp = mlir::dyn_cast<subop::MapOp>(defOp)) {
+            if (llvm::any_of(mapOp.getComputedCols(), [&](mlir::Attribute attr) { return sortColumns.contains(&mlir::cast<tuples::ColumnDefAttr>(attr).getColumn()); })) {
+               break;
+            }
+         }
+         boundUser = defOp;
+         consumer = defOp;
+         stream = defOp->getOperand(0);
+      }
+      return boundUser;
+   }
+
    public:
    using OpConversionPattern<relalg::TopKOp>::OpConversionPattern;
 
@@ -1668,8 +2010,27 @@ class TopKLowering : public OpConversionPattern<relalg::TopKOp> {
          rewriter.create<tuples::ReturnOp>(loc, isLt);
       }
       auto heapType = subop::HeapType::get(getContext(), helper.createStateMembersAttr(), topk.getMaxRows());
+      //the bound of the heap only becomes tighter: check tuples against it before maps and filters that do not compute sort keys
+      auto* boundUser = findBoundCheckUser(topk, adaptor.getRel(), rewriter.getInsertionBlock());
+      mlir::OpBuilder::InsertPoint materializeInsertionPoint = rewriter.saveInsertionPoint();
+      if (boundUser) {
+         rewriter.setInsertionPoint(boundUser);
+      }
       auto createHeapOp = rewriter.create<subop::CreateHeapOp>(loc, heapType, rewriter.getArrayAttr(sortByMembers));
       createHeapOp.getRegion().getBlocks().push_back(block);
+      if (boundUser) {
+         auto& colManager = getContext()->getLoadedDialect<tuples::TupleStreamDialect>()->getColumnManager();
+         std::vector<mlir::NamedAttribute> boundMapping;
+         for (auto attr : topk.getSortspecs()) {
+            auto* column = &mlir::cast<relalg::SortSpecificationAttr>(attr).getAttr().getColumn();
+            boundMapping.push_back(rewriter.getNamedAttr(helper.lookupStateMemberForMaterializedColumn(column), colManager.createRef(column)));
+         }
+         auto checkOp = rewriter.create<subop::CheckHeapBoundOp>(loc, boundUser->getOperand(0), createHeapOp.getRes(), rewriter.getDictionaryAttr(boundMapping));
+         rewriter.modifyOpInPlace(boundUser, [&] {
+            boundUser->setOperand(0, checkOp.getResult());
+         });
+      }
+      rewriter.restoreInsertionPoint(materializeInsertionPoint);
       rewriter.create<subop::MaterializeOp>(loc, adaptor.getRel(), createHeapOp.getRes(), helper.createColumnstateMapping());
       auto scanOp = rewriter.replaceOpWithNewOp<subop::ScanOp>(topk, createHeapOp.getRes(), helper.createStateColumnMapping());
       scanOp->setAttr("sequential", rewriter.getUnitAttr());
@@ -2174,28 +2535,136 @@ class WindowLowering : public OpConversionPattern<relalg::WindowOp> {
          analyzedWindow.distAggrFuncs.push_back({d.second.first, d.second.second});
       }
    }
-   void performWindowOp(relalg::WindowOp windowOp, mlir::Value inputStream, ConversionPatternRewriter& rewriter, std::function<mlir::Value(ConversionPatternRewriter&, mlir::Value, mlir::DictionaryAttr, mlir::Location)> evaluate) const {
+   //first and last index of every partition inside a continuous view that is sorted by the partition keys
+   struct PartitionBounds {
+      mlir::Value state;
+      mlir::ArrayAttr keys;
+      mlir::DictionaryAttr mapping;
+      tuples::ColumnRefAttr begin;
+      tuples::ColumnRefAttr end;
+   };
+   PartitionBounds computePartitionBounds(Location loc, ConversionPatternRewriter& rewriter, mlir::Value continuousView, mlir::DictionaryAttr continuousViewMapping, mlir::ArrayAttr partitionBy) const {
+      auto* context = rewriter.getContext();
+      auto keyAttributes = relalg::OrderedAttributes::fromRefArr(partitionBy);
+      auto keyColumns = relalg::ColumnSet::fromArrayAttr(partitionBy);
+      std::vector<mlir::NamedAttribute> keyMapping;
+      for (auto x : continuousViewMapping) {
+         if (keyColumns.contains(&mlir::cast<tuples::ColumnDefAttr>(x.getValue()).getColumn())) {
+            keyMapping.push_back(x);
+         }
+      }
+      auto continuousViewRefType = subop::ContinuousEntryRefType::get(context, mlir::cast<subop::ContinuousViewType>(continuousView.getType()));
+      auto [beginReferenceDefAttr, beginReferenceRefAttr] = createColumn(continuousViewRefType, "view", "begin");
+      auto [referenceDefAttr, referenceRefAttr] = createColumn(continuousViewRefType, "scan", "ref");
+      auto [indexDefAttr, indexRefAttr] = createColumn(rewriter.getIndexType(), "window", "idx");
+      mlir::Value stream = rewriter.create<subop::ScanRefsOp>(loc, continuousView, referenceDefAttr);
+      stream = rewriter.create<subop::GatherOp>(loc, stream, referenceRefAttr, rewriter.getDictionaryAttr(keyMapping));
+      stream = rewriter.create<subop::GetBeginReferenceOp>(loc, stream, continuousView, beginReferenceDefAttr);
+      stream = rewriter.create<subop::EntriesBetweenOp>(loc, stream, beginReferenceRefAttr, referenceRefAttr, indexDefAttr);
+
+      std::vector<mlir::Attribute> keyNames;
+      std::vector<mlir::Attribute> keyTypesAttr;
+      std::vector<mlir::Type> keyTypes;
+      std::vector<mlir::Location> locations;
+      for (auto* x : keyAttributes.getAttrs()) {
+         keyNames.push_back(rewriter.getStringAttr(getUniqueMember(context, "keyval")));
+         keyTypesAttr.push_back(mlir::TypeAttr::get(x->type));
+         keyTypes.push_back(x->type);
+         locations.push_back(loc);
+      }
+      auto beginMember = rewriter.getStringAttr(getUniqueMember(context, "partition_begin"));
+      auto endMember = rewriter.getStringAttr(getUniqueMember(context, "partition_end"));
+      auto indexTypeAttr = mlir::TypeAttr::get(rewriter.getIndexType());
+      auto keyMembers = subop::StateMembersAttr::get(context, mlir::ArrayAttr::get(context, keyNames), mlir::ArrayAttr::get(context, keyTypesAttr));
+      auto valueMembers = subop::StateMembersAttr::get(context, mlir::ArrayAttr::get(context, {beginMember, endMember}), mlir::ArrayAttr::get(context, {indexTypeAttr, indexTypeAttr}));
+      auto boundsType = subop::MapType::get(context, keyMembers, valueMembers, false);
+      mlir::Value bounds = rewriter.create<subop::GenericCreateOp>(loc, boundsType);
+
+      auto [lookupDefAttr, lookupRefAttr] = createColumn(subop::LookupEntryRefType::get(context, mlir::cast<subop::LookupAbleState>(boundsType)), "lookup", "ref");
+      auto lookupOp = rewriter.create<subop::LookupOrInsertOp>(loc, tuples::TupleStreamType::get(context), stream, bounds, keyAttributes.getArrayAttr(context), lookupDefAttr);
+      {
+         Block* initialValueBlock = new Block;
+         mlir::OpBuilder::InsertionGuard guard(rewriter);
+         rewriter.setInsertionPointToStart(initialValueBlock);
+         mlir::Value noBegin = rewriter.create<mlir::arith::ConstantIndexOp>(loc, std::numeric_limits<int64_t>::max());
+         mlir::Value noEnd = rewriter.create<mlir::arith::ConstantIndexOp>(loc, 0);
+         rewriter.create<tuples::ReturnOp>(loc, mlir::ValueRange{noBegin, noEnd});
+         lookupOp.getInitFn().push_back(initialValueBlock);
+      }
+      {
+         mlir::Block* equalBlock = new Block;
+         lookupOp.getEqFn().push_back(equalBlock);
+         equalBlock->addArguments(keyTypes, locations);
+         equalBlock->addArguments(keyTypes, locations);
+         mlir::OpBuilder::InsertionGuard guard(rewriter);
+         rewriter.setInsertionPointToStart(equalBlock);
+         mlir::Value compared = compareKeys(rewriter, equalBlock->getArguments().drop_back(keyTypes.size()), equalBlock->getArguments().drop_front(keyTypes.size()), loc);
+         rewriter.create<tuples::ReturnOp>(loc, compared);
+      }
+      auto reduceOp = rewriter.create<subop::ReduceOp>(loc, lookupOp, lookupRefAttr, rewriter.getArrayAttr({indexRefAttr}), rewriter.getArrayAttr({beginMember, endMember}));
+      {
+         mlir::Block* reduceBlock = new Block;
+         mlir::Value index = reduceBlock->addArgument(rewriter.getIndexType(), loc);
+         mlir::Value currentBegin = reduceBlock->addArgument(rewriter.getIndexType(), loc);
+         mlir::Value currentEnd = reduceBlock->addArgument(rewriter.getIndexType(), loc);
+         mlir::OpBuilder::InsertionGuard guard(rewriter);
+         rewriter.setInsertionPointToStart(reduceBlock);
+         mlir::Value newBegin = rewriter.create<mlir::arith::MinUIOp>(loc, currentBegin, index);
+         mlir::Value newEnd = rewriter.create<mlir::arith::MaxUIOp>(loc, currentEnd, index);
+         rewriter.create<tuples::ReturnOp>(loc, mlir::ValueRange{newBegin, newEnd});
+         reduceOp.getRegion().push_back(reduceBlock);
+      }
+      {
+         mlir::Block* combineBlock = new Block;
+         mlir::Value leftBegin = combineBlock->addArgument(rewriter.getIndexType(), loc);
+         mlir::Value leftEnd = combineBlock->addArgument(rewriter.getIndexType(), loc);
+         mlir::Value rightBegin = combineBlock->addArgument(rewriter.getIndexType(), loc);
+         mlir::Value rightEnd = combineBlock->addArgument(rewriter.getIndexType(), loc);
+         mlir::OpBuilder::InsertionGuard guard(rewriter);
+         rewriter.setInsertionPointToStart(combineBlock);
+         mlir::Value newBegin = rewriter.create<mlir::arith::MinUIOp>(loc, leftBegin, rightBegin);
+         mlir::Value newEnd = rewriter.create<mlir::arith::MaxUIOp>(loc, leftEnd, rightEnd);
+         rewriter.create<tuples::ReturnOp>(loc, mlir::ValueRange{newBegin, newEnd});
+         reduceOp.getCombine().push_back(combineBlock);
+      }
+      auto [partitionBeginDef, partitionBeginRef] = createColumn(rewriter.getIndexType(), "window", "partition_begin");
+      auto [partitionEndDef, partitionEndRef] = createColumn(rewriter.getIndexType(), "window", "partition_end");
+      auto mapping = rewriter.getDictionaryAttr({rewriter.getNamedAttr(beginMember, partitionBeginDef), rewriter.getNamedAttr(endMember, partitionEndDef)});
+      return {bounds, partitionBy, mapping, partitionBeginRef, partitionEndRef};
+   }
+   void performWindowOp(relalg::WindowOp windowOp, mlir::Value inputStream, ConversionPatternRewriter& rewriter, std::function<mlir::Value(ConversionPatternRewriter&, mlir::Value, mlir::DictionaryAttr, std::optional<PartitionBounds>, mlir::Location)> evaluate) const {
       relalg::ColumnSet requiredColumns = getRequired(windowOp);
       auto& colManager = getContext()->getLoadedDialect<tuples::TupleStreamDialect>()->getColumnManager();
       requiredColumns.insert(windowOp.getUsedColumns());
       requiredColumns.remove(windowOp.getCreatedColumns());
       auto loc = windowOp->getLoc();
-      if (windowOp.getPartitionBy().empty()) {
+      if (windowOp.getPartitionBy().empty() || windowPartitioning.getValue() != "hash") {
          MaterializationHelper helper(requiredColumns, rewriter.getContext());
 
          auto vectorType = subop::BufferType::get(rewriter.getContext(), helper.createStateMembersAttr());
          mlir::Value vector = rewriter.create<subop::GenericCreateOp>(loc, vectorType);
          rewriter.create<subop::MaterializeOp>(loc, inputStream, vector, helper.createColumnstateMapping());
+         //the partitions become contiguous ranges of the sorted view
+         std::vector<mlir::Attribute> sortSpecs;
+         for (auto partitionBy : windowOp.getPartitionBy()) {
+            sortSpecs.push_back(relalg::SortSpecificationAttr::get(rewriter.getContext(), mlir::cast<tuples::ColumnRefAttr>(partitionBy), relalg::SortSpec::asc));
+         }
+         sortSpecs.insert(sortSpecs.end(), windowOp.getOrderBy().begin(), windowOp.getOrderBy().end());
          mlir::Value continuousView;
-         if (windowOp.getOrderBy().empty()) {
+         if (sortSpecs.empty()) {
             auto continuousViewType = subop::ContinuousViewType::get(rewriter.getContext(), vectorType);
             continuousView = rewriter.create<subop::CreateContinuousView>(loc, continuousViewType, vector);
          } else {
-            auto sortedView = createSortedView(rewriter, vector, windowOp.getOrderBy(), loc, helper);
+            auto sortedView = createSortedView(rewriter, vector, rewriter.getArrayAttr(sortSpecs), loc, helper);
             auto continuousViewType = subop::ContinuousViewType::get(rewriter.getContext(), mlir::cast<subop::State>(sortedView.getType()));
             continuousView = rewriter.create<subop::CreateContinuousView>(loc, continuousViewType, sortedView);
          }
-         rewriter.replaceOp(windowOp, evaluate(rewriter, continuousView, helper.createStateColumnMapping(), loc));
+         auto columnMapping = helper.createStateColumnMapping();
+         std::optional<PartitionBounds> partitionBounds;
+         if (!windowOp.getPartitionBy().empty()) {
+            partitionBounds = computePartitionBounds(loc, rewriter, continuousView, columnMapping, windowOp.getPartitionBy());
+         }
+         rewriter.replaceOp(windowOp, evaluate(rewriter, continuousView, columnMapping, partitionBounds, loc));
       } else {
          auto keyAttributes = relalg::OrderedAttributes::fromRefArr(windowOp.getPartitionBy());
          auto valueColumns = requiredColumns;
@@ -2326,7 +2795,7 @@ class WindowLowering : public OpConversionPattern<relalg::WindowOp> {
                auto continuousViewType = subop::ContinuousViewType::get(rewriter.getContext(), mlir::cast<subop::State>(sortedView.getType()));
                continuousView = rewriter.create<subop::CreateContinuousView>(loc, continuousViewType, sortedView);
             }
-            rewriter.create<tuples::ReturnOp>(loc, evaluate(rewriter, continuousView, helper.createStateColumnMapping(), loc));
+            rewriter.create<tuples::ReturnOp>(loc, evaluate(rewriter, continuousView, helper.createStateColumnMapping(), std::nullopt, loc));
          }
 
          rewriter.replaceOp(windowOp, nestedMapOp.getRes());
@@ -2417,7 +2886,7 @@ class WindowLowering : public OpConversionPattern<relalg::WindowOp> {
       auto fromBegin = from == std::numeric_limits<int64_t>().min();
       auto fromEnd = to == std::numeric_limits<int64_t>().max();
 
-      auto evaluate = [&](ConversionPatternRewriter& rewriter, mlir::Value continuousView, mlir::DictionaryAttr columnMapping, mlir::Location loc) {
+      auto evaluate = [&](ConversionPatternRewriter& rewriter, mlir::Value continuousView, mlir::DictionaryAttr columnMapping, std::optional<PartitionBounds> partitionBounds, mlir::Location loc) {
          auto& colManager = rewriter.getContext()->getLoadedDialect<tuples::TupleStreamDialect>()->getColumnManager();
          auto continuousViewRefType = subop::ContinuousEntryRefType::get(rewriter.getContext(), mlir::cast<subop::ContinuousViewType>(continuousView.getType()));
          auto [beginReferenceDefAttr, beginReferenceRefAttr] = createColumn(continuousViewRefType, "view", "begin");
@@ -2426,7 +2895,9 @@ class WindowLowering : public OpConversionPattern<relalg::WindowOp> {
 
          std::tuple<mlir::Value, mlir::DictionaryAttr, mlir::DictionaryAttr> staticAggregateResults;
          std::tuple<mlir::Value, mlir::DictionaryAttr> segmentTreeViewResult;
-         if (!distAggrFuncs.empty() && fromBegin && fromEnd) {
+         //with partitions, the aggregates over whole partitions are also looked up in the segment tree
+         bool staticAggregates = fromBegin && fromEnd && !partitionBounds;
+         if (!distAggrFuncs.empty() && staticAggregates) {
             mlir::Value scan = rewriter.create<subop::ScanOp>(loc, continuousView, columnMapping);
             staticAggregateResults = performAggregation(loc, rewriter, distAggrFuncs, relalg::OrderedAttributes::fromVec({}), scan, performAggrFuncReduce);
          } else if (!distAggrFuncs.empty()) {
@@ -2445,27 +2916,86 @@ class WindowLowering : public OpConversionPattern<relalg::WindowOp> {
          if (fromEnd) {
             rangeEnd = endReferenceRefAttr;
          }
-         if (from == 0) {
-            rangeBegin = referenceRefAttr;
-         } else {
-            auto [fromDefAttr, fromRefAttr] = createColumn(continuousViewRefType, "frame", "from");
-            auto [withConst, constCol] = mapIndex(current, rewriter, loc, from);
-            current = rewriter.create<subop::OffsetReferenceBy>(loc, withConst, referenceRefAttr, colManager.createRef(constCol), fromDefAttr);
-            rangeBegin = fromRefAttr;
-         }
-         if (to == 0) {
-            rangeEnd = referenceRefAttr;
+         if (partitionBounds) {
+            //frames are clipped to the bounds of the current partition, which are given as indices into the view
+            auto [boundsDefAttr, boundsRefAttr] = createColumn(subop::OptionalType::get(getContext(), subop::LookupEntryRefType::get(getContext(), mlir::cast<subop::LookupAbleState>(partitionBounds->state.getType()))), "lookup", "ref");
+            auto [unwrappedDefAttr, unwrappedRefAttr] = createColumn(subop::LookupEntryRefType::get(getContext(), mlir::cast<subop::LookupAbleState>(partitionBounds->state.getType())), "lookup", "ref");
+            auto lookupOp = rewriter.create<subop::LookupOp>(loc, tuples::TupleStreamType::get(getContext()), current, partitionBounds->state, partitionBounds->keys, boundsDefAttr);
+            {
+               std::vector<mlir::Type> keyTypes;
+               std::vector<mlir::Location> locations;
+               for (auto* x : relalg::OrderedAttributes::fromRefArr(partitionBounds->keys).getAttrs()) {
+                  keyTypes.push_back(x->type);
+                  locations.push_back(loc);
+               }
+               mlir::Block* equalBlock = new Block;
+               lookupOp.getEqFn().push_back(equalBlock);
+               equalBlock->addArguments(keyTypes, locations);
+               equalBlock->addArguments(keyTypes, locations);
+               mlir::OpBuilder::InsertionGuard guard(rewriter);
+               rewriter.setInsertionPointToStart(equalBlock);
+               mlir::Value compared = compareKeys(rewriter, equalBlock->getArguments().drop_back(keyTypes.size()), equalBlock->getArguments().drop_front(keyTypes.size()), loc);
+               rewriter.create<tuples::ReturnOp>(loc, compared);
+            }
+            current = rewriter.create<subop::UnwrapOptionalRefOp>(loc, lookupOp.getRes(), boundsRefAttr, unwrappedDefAttr);
+            current = rewriter.create<subop::GatherOp>(loc, current, unwrappedRefAttr, partitionBounds->mapping);
+            auto [indexDefAttr, indexRefAttr] = createColumn(rewriter.getIndexType(), "window", "idx");
+            current = rewriter.create<subop::EntriesBetweenOp>(loc, current, beginReferenceRefAttr, referenceRefAttr, indexDefAttr);
+            auto currentIndex = indexRefAttr;
+            auto viewBegin = beginReferenceRefAttr;
+            auto referenceAt = [&](tuples::ColumnRefAttr index, std::string name) {
+               auto [defAttr, refAttr] = createColumn(continuousViewRefType, "frame", name);
+               current = rewriter.create<subop::OffsetReferenceBy>(loc, current, viewBegin, index, defAttr);
+               return refAttr;
+            };
+            auto clippedIndex = [&](int64_t offset, std::string name) {
+               auto [defAttr, refAttr] = createColumn(rewriter.getIndexType(), "frame", name);
+               current = map(current, rewriter, loc, rewriter.getArrayAttr({defAttr}), [&](mlir::ConversionPatternRewriter& rewriter, subop::MapCreationHelper& helper, mlir::Location loc) {
+                  mlir::Value offsetConst = rewriter.create<mlir::arith::ConstantIndexOp>(loc, offset);
+                  mlir::Value index = rewriter.create<mlir::arith::AddIOp>(loc, helper.access(currentIndex, loc), offsetConst);
+                  index = rewriter.create<mlir::arith::MaxSIOp>(loc, index, helper.access(partitionBounds->begin, loc));
+                  index = rewriter.create<mlir::arith::MinSIOp>(loc, index, helper.access(partitionBounds->end, loc));
+                  return std::vector<mlir::Value>{index};
+               });
+               return refAttr;
+            };
+            if (fromBegin) {
+               rangeBegin = referenceAt(partitionBounds->begin, "from");
+            } else if (from == 0) {
+               rangeBegin = referenceRefAttr;
+            } else {
+               rangeBegin = referenceAt(clippedIndex(from, "from_idx"), "from");
+            }
+            if (fromEnd) {
+               rangeEnd = referenceAt(partitionBounds->end, "to");
+            } else if (to == 0) {
+               rangeEnd = referenceRefAttr;
+            } else {
+               rangeEnd = referenceAt(clippedIndex(to, "to_idx"), "to");
+            }
          } else {
-            auto [toDefAttr, toRefAttr] = createColumn(continuousViewRefType, "frame", "to");
-            auto [withConst, constCol] = mapIndex(current, rewriter, loc, to);
-            current = rewriter.create<subop::OffsetReferenceBy>(loc, withConst, referenceRefAttr, colManager.createRef(constCol), toDefAttr);
-            rangeEnd = toRefAttr;
+            if (from == 0) {
+               rangeBegin = referenceRefAttr;
+            } else {
+               auto [fromDefAttr, fromRefAttr] = createColumn(continuousViewRefType, "frame", "from");
+               auto [withConst, constCol] = mapIndex(current, rewriter, loc, from);
+               current = rewriter.create<subop::OffsetReferenceBy>(loc, withConst, referenceRefAttr, colManager.createRef(constCol), fromDefAttr);
+               rangeBegin = fromRefAttr;
+            }
+            if (to == 0) {
+               rangeEnd = referenceRefAttr;
+            } else {
+               auto [toDefAttr, toRefAttr] = createColumn(continuousViewRefType, "frame", "to");
+               auto [withConst, constCol] = mapIndex(current, rewriter, loc, to);
+               current = rewriter.create<subop::OffsetReferenceBy>(loc, withConst, referenceRefAttr, colManager.createRef(constCol), toDefAttr);
+               rangeEnd = toRefAttr;
+            }
          }
          assert(rangeBegin && rangeEnd);
          for (auto orderedWindowFn : analyzedWindow.orderedWindowFunctions) {
             current = orderedWindowFn->evaluate(rewriter, loc, current, rangeBegin, rangeEnd, colManager.createRef(&referenceDefAttr.getColumn()));
          }
-         if (!distAggrFuncs.empty() && fromBegin && fromEnd) {
+         if (!distAggrFuncs.empty() && staticAggregates) {
             mlir::Value state = std::get<0>(staticAggregateResults);
             mlir::DictionaryAttr stateColumnMapping = std::get<2>(staticAggregateResults);
             auto [referenceDef, referenceRef] = createColumn(subop::LookupEntryRefType::get(getContext(), mlir::cast<subop::LookupAbleState>(state.getType())), "lookup", "ref");
@@ -2549,6 +3079,8 @@ class AggregationLowering : public OpConversionPattern<relalg::AggregationOp> {
             tree = rewriter.create<relalg::ProjectionOp>(aggregationOp->getLoc(), relalg::SetSemantic::distinct, tree, relalg::OrderedAttributes::fromVec(projectionAttrs).getArrayAttr(rewriter.getContext()));
          }
          auto partialResult = performAggregation(aggregationOp->getLoc(), rewriter, x.second, keyAttributes, tree, performAggrFuncReduce);
+         //one entry per group
+         setInitialCapacity(std::get<0>(partialResult), getEstimatedRows(aggregationOp.getResult()));
          subResults.push_back(partialResult);
       }
       if (subResults.empty()) {
@@ -18,12 +18,15 @@
 #include "lingodb/compiler/runtime/DataSourceIteration.h"
 #include "lingodb/compiler/runtime/EntryLock.h"
 #include "lingodb/compiler/runtime/ExecutionContext.h"
+#include "lingodb/compiler/runtime/ExternalSort.h"
+#include "lingodb/compiler/runtime/GraceHashJoin.h"
 #include "lingodb/compiler/runtime/GrowingBuffer.h"
 #include "lingodb/compiler/runtime/HashMultiMap.h"
 #include "lingodb/compiler/runtime/Hashtable.h"
 #include "lingodb/compiler/runtime/Heap.h"
 #include "lingodb/compiler/runtime/LazyJoinHashtable.h"
 #include "lingodb/compiler/runtime/LingoDBHashIndex.h"
+#include "lingodb/compiler/runtime/NestedLoopJoin.h"
 #include "lingodb/compiler/runtime/PreAggregationHashtable.h"
 #include "lingodb/compiler/runtime/RelationHelper.h"
 #include "lingodb/compiler/runtime/SegmentTreeView.h"
@@ -925,6 +928,12 @@ static mlir::TupleType getHashMultiMapValueType(subop::HashMultiMapType t, mlir:
    return mlir::TupleType::get(t.getContext(), {i8PtrType, valTupleType});
 }
 
+//slot of the unchained HashIndexedView: hash value and entry pointer
+static mlir::TupleType getHashIndexedViewSlotType(mlir::MLIRContext* context) {
+   auto i8PtrType = util::RefType::get(context, IntegerType::get(context, 8));
+   return mlir::TupleType::get(context, {mlir::IndexType::get(context), i8PtrType});
+}
+
 static TupleType convertTuple(TupleType tupleType, TypeConverter& typeConverter) {
    std::vector<Type> types;
    for (auto t : tupleType.getTypes()) {
@@ -1028,6 +1037,12 @@ class CreateThreadLocalLowering : public SubOpConversionPattern<subop::CreateThr
       for (auto* op : toDelete) {
          op->erase();
       }
+      //thread-local heaps share a bound through the thread local, which is passed to them in the last slot of the argument
+      std::optional<size_t> threadLocalSlot;
+      newBlock->walk([&](subop::CreateHeapOp heapOp) {
+         threadLocalSlot = toStore.size();
+         heapOp->setAttr("thread_local_slot", builder.getIndexAttr(toStore.size()));
+      });
       rewriter.atStartOf(funcBody, [&](SubOpRewriter& rewriter) {
          rewriter.inlineBlock<tuples::ReturnOpAdaptor>(newBlock, mlir::ValueRange{funcArg}, [&](tuples::ReturnOpAdaptor adaptor) {
             mlir::Value unrealized = rewriter.create<mlir::UnrealizedConversionCastOp>(createThreadLocal->getLoc(), createThreadLocal.getType().getWrapped(), adaptor.getResults()[0]).getOutputs()[0];
@@ -1035,7 +1050,7 @@ class CreateThreadLocalLowering : public SubOpConversionPattern<subop::CreateThr
             rewriter.create<mlir::func::ReturnOp>(loc, casted);
          });
       });
-      Value arg = rewriter.create<util::AllocOp>(loc, util::RefType::get(i8PtrType), rewriter.create<mlir::arith::ConstantIndexOp>(loc, toStore.size()));
+      Value arg = rewriter.create<util::AllocOp>(loc, util::RefType::get(i8PtrType), rewriter.create<mlir::arith::ConstantIndexOp>(loc, toStore.size() + threadLocalSlot.has_value()));
       for (size_t i = 0; i < toStore.size(); i++) {
          Value valPtr = rewriter.create<util::AllocOp>(loc, util::RefType::get(toStore[i].getType()), mlir::Value());
 
@@ -1044,7 +1059,12 @@ class CreateThreadLocalLowering : public SubOpConversionPattern<subop::CreateThr
          rewriter.create<util::StoreOp>(loc, valPtr, arg, rewriter.create<mlir::arith::ConstantIndexOp>(loc, i));
       }
       Value functionPointer = rewriter.create<mlir::func::ConstantOp>(loc, funcOp.getFunctionType(), SymbolRefAttr::get(rewriter.getStringAttr(funcOp.getSymName())));
-      rewriter.replaceOp(createThreadLocal, rt::ThreadLocal::create(rewriter, loc)({functionPointer, arg}));
+      Value threadLocal = rt::ThreadLocal::create(rewriter, loc)({functionPointer, arg})[0];
+      if (threadLocalSlot) {
+         //values are only initialized on first use, i.e., after the thread local is stored
+         rewriter.create<util::StoreOp>(loc, threadLocal, arg, rewriter.create<mlir::arith::ConstantIndexOp>(loc, threadLocalSlot.value()));
+      }
+      rewriter.replaceOp(createThreadLocal, threadLocal);
       return mlir::success();
    }
 };
@@ -1451,7 +1471,7 @@ class CreateHashMapLowering : public SubOpConversionPattern<subop::GenericCreate
       auto t = mlir::cast<subop::HashMapType>(createOp.getType());
 
       auto typeSize = rewriter.create<util::SizeOfOp>(createOp->getLoc(), rewriter.getIndexType(), getHtEntryType(t, *typeConverter));
-      Value initialCapacity = rewriter.create<arith::ConstantIndexOp>(createOp->getLoc(), 4);
+      Value initialCapacity = rewriter.create<arith::ConstantIndexOp>(createOp->getLoc(), createOp->hasAttr("initial_capacity") ? mlir::cast<mlir::IntegerAttr>(createOp->getAttr("initial_capacity")).getInt() : 4);
       auto ptr = rt::Hashtable::create(rewriter, createOp->getLoc())({typeSize, initialCapacity})[0];
       rewriter.replaceOp(createOp, ptr);
       return mlir::success();
@@ -1466,7 +1486,7 @@ class CreateHashMultiMapLowering : public SubOpConversionPattern<subop::GenericC
 
       auto entryTypeSize = rewriter.create<util::SizeOfOp>(createOp->getLoc(), rewriter.getIndexType(), getHashMultiMapEntryType(t, *typeConverter));
       auto valueTypeSize = rewriter.create<util::SizeOfOp>(createOp->getLoc(), rewriter.getIndexType(), getHashMultiMapValueType(t, *typeConverter));
-      Value initialCapacity = rewriter.create<arith::ConstantIndexOp>(createOp->getLoc(), 4);
+      Value initialCapacity = rewriter.create<arith::ConstantIndexOp>(createOp->getLoc(), createOp->hasAttr("initial_capacity") ? mlir::cast<mlir::IntegerAttr>(createOp->getAttr("initial_capacity")).getInt() : 4);
       auto ptr = rt::HashMultiMap::create(rewriter, createOp->getLoc())({entryTypeSize, valueTypeSize, initialCapacity})[0];
       rewriter.replaceOp(createOp, ptr);
       return mlir::success();
@@ -1613,6 +1633,15 @@ class CreateHeapLowering : public SubOpConversionPattern<subop::CreateHeapOp> {
       Value typeSize = rewriter.create<util::SizeOfOp>(loc, rewriter.getIndexType(), elementType);
       Value maxElements = rewriter.create<mlir::arith::ConstantIndexOp>(loc, heapType.getMaxElements());
       Value functionPointer = rewriter.create<mlir::func::ConstantOp>(loc, funcOp.getFunctionType(), SymbolRefAttr::get(rewriter.getStringAttr(funcOp.getSymName())));
+      if (auto threadLocalSlot = heapOp->getAttrOfType<mlir::IntegerAttr>("thread_local_slot")) {
+         //created by the init function of a thread local (see CreateThreadLocalLowering), which receives the thread local in its argument
+         auto initFunc = heapOp->getParentOfType<mlir::func::FuncOp>();
+         Value args = rewriter.create<util::GenericMemrefCastOp>(loc, util::RefType::get(getContext(), ptrType), initFunc.getArgument(0));
+         Value threadLocal = rewriter.create<util::LoadOp>(loc, args, rewriter.create<mlir::arith::ConstantIndexOp>(loc, threadLocalSlot.getInt()));
+         auto heap = rt::Heap::createShared(rewriter, loc)({maxElements, typeSize, functionPointer, threadLocal})[0];
+         rewriter.replaceOp(heapOp, heap);
+         return mlir::success();
+      }
       auto heap = rt::Heap::create(rewriter, loc)({maxElements, typeSize, functionPointer})[0];
       rewriter.replaceOp(heapOp, heap);
       return mlir::success();
@@ -1847,6 +1876,42 @@ class MergePreAggrHashMap : public SubOpConversionPattern<subop::MergeOp> {
    }
 };
 class SortLowering : public SubOpConversionPattern<subop::CreateSortedViewOp> {
+   //generates a function that computes the normalized key of the first member, if the sort order is known and the type is supported
+   mlir::func::FuncOp createSortKeyFunc(subop::CreateSortedViewOp sortOp, EntryStorageHelper& storageHelper, SubOpRewriter& rewriter) const {
+      static size_t id = 0;
+      auto descending = sortOp->getAttrOfType<mlir::ArrayAttr>("descending");
+      if (!descending || descending.empty()) return {};
+      auto bufferType = mlir::cast<subop::BufferType>(sortOp.getToSort().getType());
+      auto firstMember = mlir::cast<mlir::StringAttr>(sortOp.getSortBy()[0]);
+      mlir::Type memberType;
+      for (auto [name, type] : llvm::zip(bufferType.getMembers().getNames(), bufferType.getMembers().getTypes())) {
+         if (name == firstMember) {
+            memberType = mlir::cast<mlir::TypeAttr>(type).getValue();
+         }
+      }
+      if (!memberType || !db::SortKey::isSupported(memberType)) return {};
+      auto loc = sortOp->getLoc();
+      auto ptrType = util::RefType::get(getContext(), IntegerType::get(getContext(), 8));
+      ModuleOp parentModule = sortOp->getParentOfType<ModuleOp>();
+      mlir::func::FuncOp funcOp;
+      rewriter.atStartOf(parentModule.getBody(), [&](SubOpRewriter& rewriter) {
+         funcOp = rewriter.create<mlir::func::FuncOp>(parentModule.getLoc(), "sort_key" + std::to_string(id++), mlir::FunctionType::get(getContext(), TypeRange({ptrType}), TypeRange(rewriter.getI64Type())));
+      });
+      auto* funcBody = new Block;
+      funcBody->addArguments(TypeRange({ptrType}), {parentModule->getLoc()});
+      funcOp.getBody().push_back(funcBody);
+      rewriter.atStartOf(funcBody, [&](SubOpRewriter& rewriter) {
+         auto values = storageHelper.getValueMap(funcBody->getArgument(0), rewriter, loc, rewriter.getArrayAttr({firstMember}));
+         mlir::Value key = rewriter.create<db::SortKey>(loc, values.get(firstMember.str()));
+         if (mlir::cast<mlir::BoolAttr>(descending[0]).getValue()) {
+            mlir::Value allOnes = rewriter.create<mlir::arith::ConstantIntOp>(loc, -1, 64);
+            key = rewriter.create<mlir::arith::XOrIOp>(loc, key, allOnes);
+         }
+         rewriter.create<mlir::func::ReturnOp>(loc, key);
+      });
+      return funcOp;
+   }
+
    public:
    using SubOpConversionPattern<subop::CreateSortedViewOp>::SubOpConversionPattern;
 
@@ -1877,6 +1942,21 @@ class SortLowering : public SubOpConversionPattern<subop::CreateSortedViewOp> {
       });
 
       Value functionPointer = rewriter.create<mlir::func::ConstantOp>(sortOp->getLoc(), funcOp.getFunctionType(), SymbolRefAttr::get(rewriter.getStringAttr(funcOp.getSymName())));
+      if (auto keyFuncOp = createSortKeyFunc(sortOp, storageHelper, rewriter)) {
+         //sort by a normalized key of the first member, the comparator only decides between equal keys
+         Value keyFunctionPointer = rewriter.create<mlir::func::ConstantOp>(sortOp->getLoc(), keyFuncOp.getFunctionType(), SymbolRefAttr::get(rewriter.getStringAttr(keyFuncOp.getSymName())));
+         if (sortOp.getType().getExternal()) {
+            rewriter.replaceOp(sortOp, rt::ExternalSort::createByKey(rewriter, sortOp->getLoc())({adaptor.getToSort(), functionPointer, keyFunctionPointer})[0]);
+            return mlir::success();
+         }
+         auto genericBuffer = rt::GrowingBuffer::sortByKey(rewriter, sortOp->getLoc())({adaptor.getToSort(), functionPointer, keyFunctionPointer})[0];
+         rewriter.replaceOpWithNewOp<util::BufferCastOp>(sortOp, typeConverter->convertType(sortOp.getType()), genericBuffer);
+         return mlir::success();
+      }
+      if (sortOp.getType().getExternal()) {
+         rewriter.replaceOp(sortOp, rt::ExternalSort::create(rewriter, sortOp->getLoc())({adaptor.getToSort(), functionPointer})[0]);
+         return mlir::success();
+      }
       auto genericBuffer = rt::GrowingBuffer::sort(rewriter, sortOp->getLoc())({adaptor.getToSort(), functionPointer})[0];
       rewriter.replaceOpWithNewOp<util::BufferCastOp>(sortOp, typeConverter->convertType(sortOp.getType()), genericBuffer);
       return mlir::success();
@@ -1904,8 +1984,18 @@ class ScanRefsSortedViewLowering : public SubOpConversionPattern<subop::ScanRefs
       auto sortedViewType = mlir::dyn_cast_or_null<subop::SortedViewType>(scanOp.getState().getType());
       if (!sortedViewType) return failure();
       ColumnMapping mapping;
-      auto elementType = util::RefType::get(getContext(), EntryStorageHelper(scanOp, sortedViewType.getMembers(), sortedViewType.hasLock(), typeConverter).getStorageType());
+      auto storageType = EntryStorageHelper(scanOp, sortedViewType.getMembers(), sortedViewType.hasLock(), typeConverter).getStorageType();
+      auto elementType = util::RefType::get(getContext(), storageType);
       auto loc = scanOp->getLoc();
+      if (sortedViewType.getExternal()) {
+         //the runtime merges the sorted runs and produces the entries in order, unless the scan does not depend on the order
+         auto it = rt::ExternalSort::createIterator(rewriter, loc)({adaptor.getState()})[0];
+         implementBufferIteration(scanOp->hasAttr("parallel"), it, storageType, loc, rewriter, *typeConverter, scanOp.getOperation(), [&](SubOpRewriter& rewriter, mlir::Value ptr) {
+            mapping.define(scanOp.getRef(), ptr);
+            rewriter.replaceTupleStream(scanOp, mapping);
+         });
+         return success();
+      }
       auto start = rewriter.create<mlir::arith::ConstantIndexOp>(loc, 0);
       auto end = rewriter.create<util::BufferGetLen>(loc, rewriter.getIndexType(), adaptor.getState());
       auto c1 = rewriter.create<mlir::arith::ConstantIndexOp>(loc, 1);
@@ -2080,6 +2170,64 @@ class ScanHashMultiMap : public SubOpConversionPattern<subop::ScanRefsOp> {
       return success();
    }
 };
+class ScanRefsGraceJoinViewLowering : public SubOpConversionPattern<subop::ScanRefsOp> {
+   public:
+   using SubOpConversionPattern<subop::ScanRefsOp>::SubOpConversionPattern;
+
+   LogicalResult matchAndRewrite(subop::ScanRefsOp scanRefsOp, OpAdaptor adaptor, SubOpRewriter& rewriter) const override {
+      if (!mlir::isa<subop::GraceJoinViewType>(scanRefsOp.getState().getType())) return failure();
+      ColumnMapping mapping;
+      auto loc = scanRefsOp->getLoc();
+      auto i8PtrType = util::RefType::get(getContext(), rewriter.getI8Type());
+      //the runtime produces pairs of pointers to matching build and probe entries
+      auto pairType = mlir::TupleType::get(getContext(), {i8PtrType, i8PtrType});
+      auto it = rt::GraceHashJoin::createIterator(rewriter, loc)({adaptor.getState()})[0];
+      implementBufferIteration(scanRefsOp->hasAttr("parallel"), it, pairType, loc, rewriter, *typeConverter, scanRefsOp.getOperation(), [&](SubOpRewriter& rewriter, mlir::Value ptr) {
+         mapping.define(scanRefsOp.getRef(), ptr);
+         rewriter.replaceTupleStream(scanRefsOp, mapping);
+      });
+      return success();
+   }
+};
+class ScanRefsNestedLoopJoinViewLowering : public SubOpConversionPattern<subop::ScanRefsOp> {
+   public:
+   using SubOpConversionPattern<subop::ScanRefsOp>::SubOpConversionPattern;
+
+   LogicalResult matchAndRewrite(subop::ScanRefsOp scanRefsOp, OpAdaptor adaptor, SubOpRewriter& rewriter) const override {
+      auto nestedLoopJoinViewType = mlir::dyn_cast_or_null<subop::NestedLoopJoinViewType>(scanRefsOp.getState().getType());
+      if (!nestedLoopJoinViewType) return failure();
+      ColumnMapping mapping;
+      auto loc = scanRefsOp->getLoc();
+      auto i8PtrType = util::RefType::get(getContext(), rewriter.getI8Type());
+      EntryStorageHelper buildStorageHelper(scanRefsOp, nestedLoopJoinViewType.getBuildMembers(), false, typeConverter);
+      EntryStorageHelper probeStorageHelper(scanRefsOp, nestedLoopJoinViewType.getProbeMembers(), false, typeConverter);
+      //the runtime produces pairs of (build block, probe batch), every pair is joined by two nested loops with the consumer in the inner one
+      auto blockPairType = mlir::TupleType::get(getContext(), {i8PtrType, rewriter.getIndexType(), i8PtrType, rewriter.getIndexType()});
+      auto it = rt::NestedLoopJoin::createIterator(rewriter, loc)({adaptor.getState()})[0];
+      implementBufferIteration(scanRefsOp->hasAttr("parallel"), it, blockPairType, loc, rewriter, *typeConverter, scanRefsOp.getOperation(), [&](SubOpRewriter& rewriter, mlir::Value ptr) {
+         mlir::Value blockPair = rewriter.create<util::LoadOp>(loc, ptr, mlir::Value());
+         llvm::SmallVector<mlir::Value> unpacked;
+         rewriter.createOrFold<util::UnPackOp>(unpacked, loc, blockPair);
+         mlir::Value buildBlock = rewriter.create<util::GenericMemrefCastOp>(loc, buildStorageHelper.getRefType(), unpacked[0]);
+         mlir::Value probeBatch = rewriter.create<util::GenericMemrefCastOp>(loc, probeStorageHelper.getRefType(), unpacked[2]);
+         auto c0 = rewriter.create<mlir::arith::ConstantIndexOp>(loc, 0);
+         auto c1 = rewriter.create<mlir::arith::ConstantIndexOp>(loc, 1);
+         auto probeLoop = rewriter.create<mlir::scf::ForOp>(loc, c0, unpacked[3], c1, mlir::ValueRange{});
+         rewriter.atStartOf(probeLoop.getBody(), [&](SubOpRewriter& rewriter) {
+            mlir::Value probeRef = rewriter.create<util::ArrayElementPtrOp>(loc, probeStorageHelper.getRefType(), probeBatch, probeLoop.getInductionVar());
+            mlir::Value probePtr = rewriter.create<util::GenericMemrefCastOp>(loc, i8PtrType, probeRef);
+            auto buildLoop = rewriter.create<mlir::scf::ForOp>(loc, c0, unpacked[1], c1, mlir::ValueRange{});
+            rewriter.atStartOf(buildLoop.getBody(), [&](SubOpRewriter& rewriter) {
+               mlir::Value buildRef = rewriter.create<util::ArrayElementPtrOp>(loc, buildStorageHelper.getRefType(), buildBlock, buildLoop.getInductionVar());
+               mlir::Value buildPtr = rewriter.create<util::GenericMemrefCastOp>(loc, i8PtrType, buildRef);
+               mapping.define(scanRefsOp.getRef(), rewriter.create<util::PackOp>(loc, mlir::ValueRange{buildPtr, probePtr}));
+               rewriter.replaceTupleStream(scanRefsOp, mapping);
+            });
+         });
+      });
+      return success();
+   }
+};
 class ScanHashMapListLowering : public SubOpConversionPattern<subop::ScanListOp> {
    public:
    using SubOpConversionPattern<subop::ScanListOp>::SubOpConversionPattern;
@@ -2177,46 +2325,41 @@ class ScanListLowering : public SubOpConversionPattern<subop::ScanListOp> {
       llvm::SmallVector<mlir::Value> unpacked;
       rewriter.createOrFold<util::UnPackOp>(unpacked, loc, adaptor.getList());
       auto ptr = unpacked[0];
-      auto hash = unpacked[1];
-      auto initialValid = unpacked[2];
-      auto iteratorType = ptr.getType();
+      auto numSlots = unpacked[1];
+      auto hash = unpacked[2];
+      auto initialValid = unpacked[3];
       auto referenceType = mlir::cast<subop::ListType>(scanOp.getList().getType()).getT();
       rewriter.create<mlir::scf::IfOp>(
          loc, initialValid, [&](mlir::OpBuilder& builder1, mlir::Location loc) {
-            auto whileOp = rewriter.create<mlir::scf::WhileOp>(loc, iteratorType, ptr);
-            Block* before = new Block;
-            Block* after = new Block;
-            whileOp.getBefore().push_back(before);
-            whileOp.getAfter().push_back(after);
+            auto slotType = getHashIndexedViewSlotType(getContext());
+            auto i8PtrType = util::RefType::get(getContext(), rewriter.getI8Type());
+            Value slots = rewriter.create<util::GenericMemrefCastOp>(loc, util::RefType::get(getContext(), slotType), ptr);
+            auto forOp = rewriter.create<mlir::scf::ForOp>(loc, rewriter.create<mlir::arith::ConstantIndexOp>(loc, 0), numSlots, rewriter.create<mlir::arith::ConstantIndexOp>(loc, 1), mlir::ValueRange{});
             rewriter.create<scf::YieldOp>(loc);
-            mlir::Value beforePtr = before->addArgument(iteratorType, loc);
-            mlir::Value afterPtr = after->addArgument(iteratorType, loc);
-            rewriter.atStartOf(before, [&](SubOpRewriter& rewriter) {
+            rewriter.atStartOf(forOp.getBody(), [&](SubOpRewriter& rewriter) {
+               Value slotPtr = rewriter.create<util::ArrayElementPtrOp>(loc, util::RefType::get(getContext(), slotType), slots, forOp.getInductionVar());
                auto tupleType = mlir::TupleType::get(getContext(), unpackTypes(referenceType.getMembers().getTypes()));
-               auto i8PtrType = util::RefType::get(getContext(), rewriter.getI8Type());
-               Value castedPtr = rewriter.create<util::GenericMemrefCastOp>(loc, util::RefType::get(getContext(), mlir::TupleType::get(getContext(), {i8PtrType, rewriter.getIndexType(), tupleType})), beforePtr);
-               Value valuePtr = rewriter.create<util::TupleElementPtrOp>(loc, util::RefType::get(getContext(), tupleType), castedPtr, 2);
+               auto resolveEntry = [&]() {
+                  Value entryPtrRef = rewriter.create<util::TupleElementPtrOp>(loc, util::RefType::get(getContext(), i8PtrType), slotPtr, 1);
+                  Value entryPtr = rewriter.create<util::LoadOp>(loc, entryPtrRef, mlir::Value());
+                  Value castedPtr = rewriter.create<util::GenericMemrefCastOp>(loc, util::RefType::get(getContext(), mlir::TupleType::get(getContext(), {rewriter.getIndexType(), tupleType})), entryPtr);
+                  Value valuePtr = rewriter.create<util::TupleElementPtrOp>(loc, util::RefType::get(getContext(), tupleType), castedPtr, 1);
+                  mapping.define(scanOp.getElem(), valuePtr);
+                  rewriter.replaceTupleStream(scanOp, mapping);
+               };
                if (hashIndexedViewType.getCompareHashForLookup()) {
-                  Value hashPtr = rewriter.create<util::TupleElementPtrOp>(loc, util::RefType::get(getContext(), rewriter.getIndexType()), castedPtr, 1);
+                  //the hash value is stored in the slot, so that the entry is only accessed for candidates
+                  Value hashPtr = rewriter.create<util::TupleElementPtrOp>(loc, util::RefType::get(getContext(), rewriter.getIndexType()), slotPtr, 0);
                   mlir::Value currHash = rewriter.create<util::LoadOp>(loc, hashPtr, mlir::Value());
                   mlir::Value hashEq = rewriter.create<mlir::arith::CmpIOp>(loc, mlir::arith::CmpIPredicate::eq, currHash, hash);
-                  rewriter.create<mlir::scf::IfOp>(
-                     loc, hashEq, [&](mlir::OpBuilder& builder1, mlir::Location loc) {
-                        mapping.define(scanOp.getElem(), valuePtr);
-                        rewriter.replaceTupleStream(scanOp, mapping);
-                        builder1.create<mlir::scf::YieldOp>(loc);
-                     });
+                  auto ifOp = rewriter.create<mlir::scf::IfOp>(loc, mlir::TypeRange{}, hashEq);
+                  ifOp.ensureTerminator(ifOp.getThenRegion(), rewriter, loc);
+                  rewriter.atStartOf(ifOp.thenBlock(), [&](SubOpRewriter& rewriter) {
+                     resolveEntry();
+                  });
                } else {
-                  mapping.define(scanOp.getElem(), valuePtr);
-                  rewriter.replaceTupleStream(scanOp, mapping);
+                  resolveEntry();
                }
-               Value nextPtr = rewriter.create<util::TupleElementPtrOp>(loc, util::RefType::get(getContext(), i8PtrType), castedPtr, 0);
-               mlir::Value next = rewriter.create<util::LoadOp>(loc, nextPtr, mlir::Value());
-               mlir::Value cond = rewriter.create<util::IsRefValidOp>(loc, rewriter.getI1Type(), next);
-               rewriter.create<mlir::scf::ConditionOp>(loc, cond, next);
-            });
-            rewriter.atStartOf(after, [&](SubOpRewriter& rewriter) {
-               rewriter.create<mlir::scf::YieldOp>(loc, afterPtr);
             });
          });
 
@@ -2436,6 +2579,29 @@ class MaterializeHeapLowering : public SubOpTupleStreamConsumerConversionPattern
    }
 };
 
+class CheckHeapBoundLowering : public SubOpTupleStreamConsumerConversionPattern<subop::CheckHeapBoundOp> {
+   public:
+   using SubOpTupleStreamConsumerConversionPattern<subop::CheckHeapBoundOp>::SubOpTupleStreamConsumerConversionPattern;
+
+   LogicalResult matchAndRewrite(subop::CheckHeapBoundOp checkOp, OpAdaptor adaptor, SubOpRewriter& rewriter, ColumnMapping& mapping) const override {
+      auto heapType = mlir::cast<subop::HeapType>(checkOp.getState().getType());
+      EntryStorageHelper storageHelper(checkOp, heapType.getMembers(), heapType.hasLock(), typeConverter);
+      mlir::Value ref;
+      rewriter.atStartOf(&rewriter.getCurrentStreamLoc()->getParentOfType<mlir::func::FuncOp>().getFunctionBody().front(), [&](SubOpRewriter& rewriter) {
+         ref = rewriter.create<util::AllocaOp>(checkOp->getLoc(), util::RefType::get(storageHelper.getStorageType()), mlir::Value());
+      });
+      //only the sort-by members are stored, the comparison function does not read the others
+      storageHelper.storeFromColumns(checkOp.getMapping(), mapping, ref, rewriter, checkOp->getLoc());
+      mlir::Value isCandidate = rt::Heap::isCandidate(rewriter, checkOp->getLoc())({adaptor.getState(), ref})[0];
+      auto ifOp = rewriter.create<mlir::scf::IfOp>(checkOp->getLoc(), mlir::TypeRange{}, isCandidate);
+      ifOp.ensureTerminator(ifOp.getThenRegion(), rewriter, checkOp->getLoc());
+      rewriter.atStartOf(ifOp.thenBlock(), [&](SubOpRewriter& rewriter) {
+         rewriter.replaceTupleStream(checkOp, mapping);
+      });
+      return success();
+   }
+};
+
 class MaterializeVectorLowering : public SubOpTupleStreamConsumerConversionPattern<subop::MaterializeOp> {
    public:
    using SubOpTupleStreamConsumerConversionPattern<subop::MaterializeOp>::SubOpTupleStreamConsumerConversionPattern;
@@ -2462,6 +2628,8 @@ class LookupSimpleStateLowering : public SubOpTupleStreamConsumerConversionPatte
    }
 };
 
+//probes tuple-at-a-time: the consumers are emitted inline, so a batch of probes could not be resolved together without a pipeline breaker
+//(joins with build sides beyond the cache use the grace hash join instead, which probes its partitions in prefetched groups)
 class LookupHashIndexedViewLowering : public SubOpTupleStreamConsumerConversionPattern<subop::LookupOp> {
    public:
    using SubOpTupleStreamConsumerConversionPattern<subop::LookupOp>::SubOpTupleStreamConsumerConversionPattern;
@@ -2471,6 +2639,7 @@ class LookupHashIndexedViewLowering : public SubOpTupleStreamConsumerConversionP
       mlir::Value hash = mapping.resolve(lookupOp, lookupOp.getKeys())[0];
       auto* context = getContext();
       auto indexType = rewriter.getIndexType();
+      auto i64Type = rewriter.getI64Type();
       auto htType = util::RefType::get(context, util::RefType::get(context, rewriter.getI8Type()));
 
       Value castedPointer = rewriter.create<util::GenericMemrefCastOp>(loc, util::RefType::get(context, TupleType::get(context, {htType, indexType})), adaptor.getState());
@@ -2484,13 +2653,57 @@ class LookupHashIndexedViewLowering : public SubOpTupleStreamConsumerConversionP
       //optimization
       Value refValid = rewriter.create<util::PtrTagMatches>(loc, rewriter.getI1Type(), ptr, hash);
       ptr = rewriter.create<util::UnTagPtr>(loc, ptr.getType(), ptr);
-      Value matches = rewriter.create<util::PackOp>(loc, ValueRange{ptr, hash, refValid});
+      //the slots of the bucket end where the slots of the next bucket begin (see HashIndexedView)
+      Value htWords = rewriter.create<util::GenericMemrefCastOp>(loc, util::RefType::get(context, i64Type), ht);
+      Value nextBucketPos = rewriter.create<arith::AddIOp>(loc, buckedPos, rewriter.create<arith::ConstantIndexOp>(loc, 1));
+      Value beginWord = rewriter.create<util::LoadOp>(loc, i64Type, htWords, buckedPos);
+      Value endWord = rewriter.create<util::LoadOp>(loc, i64Type, htWords, nextBucketPos);
+      Value rangeBytes = rewriter.create<arith::SubIOp>(loc, rewriter.create<arith::ShRUIOp>(loc, endWord, rewriter.create<arith::ConstantIntOp>(loc, 16, i64Type)), rewriter.create<arith::ShRUIOp>(loc, beginWord, rewriter.create<arith::ConstantIntOp>(loc, 16, i64Type)));
+      Value slotBytes = rewriter.create<util::SizeOfOp>(loc, indexType, getHashIndexedViewSlotType(context));
+      Value numSlots = rewriter.create<arith::DivUIOp>(loc, rewriter.create<arith::IndexCastOp>(loc, indexType, rangeBytes), slotBytes);
+      Value matches = rewriter.create<util::PackOp>(loc, ValueRange{ptr, numSlots, hash, refValid});
 
       mapping.define(lookupOp.getRef(), matches);
       rewriter.replaceTupleStream(lookupOp, mapping);
       return mlir::success();
    }
 };
+class CheckJoinFilterLowering : public SubOpTupleStreamConsumerConversionPattern<subop::CheckJoinFilterOp> {
+   public:
+   using SubOpTupleStreamConsumerConversionPattern<subop::CheckJoinFilterOp>::SubOpTupleStreamConsumerConversionPattern;
+   LogicalResult matchAndRewrite(subop::CheckJoinFilterOp checkOp, OpAdaptor adaptor, SubOpRewriter& rewriter, ColumnMapping& mapping) const override {
+      auto loc = checkOp->getLoc();
+      auto* context = getContext();
+      auto indexType = rewriter.getIndexType();
+      auto i64Type = rewriter.getI64Type();
+      auto htType = util::RefType::get(context, util::RefType::get(context, rewriter.getI8Type()));
+      auto filterType = util::RefType::get(context, i64Type);
+
+      Value castedPointer = rewriter.create<util::GenericMemrefCastOp>(loc, util::RefType::get(context, TupleType::get(context, {htType, indexType, filterType, indexType})), adaptor.getState());
+      auto loaded = rewriter.create<util::LoadOp>(loc, mlir::cast<util::RefType>(castedPointer.getType()).getElementType(), castedPointer, Value());
+      auto unpacked = rewriter.create<util::UnPackOp>(loc, loaded);
+      Value filter = unpacked.getResult(2);
+      Value filterMask = unpacked.getResult(3);
+      //same hash bits as HashIndexedView::filterWord/filterBits
+      Value hash = rewriter.create<arith::IndexCastOp>(loc, i64Type, mapping.resolve(checkOp, checkOp.getHash()));
+      auto bitAt = [&](int64_t shift) -> Value {
+         Value shifted = rewriter.create<arith::ShRUIOp>(loc, hash, rewriter.create<arith::ConstantIntOp>(loc, shift, i64Type));
+         Value pos = rewriter.create<arith::AndIOp>(loc, shifted, rewriter.create<arith::ConstantIntOp>(loc, 63, i64Type));
+         return rewriter.create<arith::ShLIOp>(loc, rewriter.create<arith::ConstantIntOp>(loc, 1, i64Type), pos);
+      };
+      Value bits = rewriter.create<arith::OrIOp>(loc, rewriter.create<arith::OrIOp>(loc, bitAt(14), bitAt(20)), bitAt(26));
+      Value upperHalf = rewriter.create<arith::ShRUIOp>(loc, hash, rewriter.create<arith::ConstantIntOp>(loc, 32, i64Type));
+      Value wordPos = rewriter.create<arith::AndIOp>(loc, rewriter.create<arith::IndexCastOp>(loc, indexType, upperHalf), filterMask);
+      Value word = rewriter.create<util::LoadOp>(loc, i64Type, filter, wordPos);
+      Value maybeMatches = rewriter.create<arith::CmpIOp>(loc, arith::CmpIPredicate::eq, rewriter.create<arith::AndIOp>(loc, word, bits), bits);
+      auto ifOp = rewriter.create<mlir::scf::IfOp>(loc, mlir::TypeRange{}, maybeMatches);
+      ifOp.ensureTerminator(ifOp.getThenRegion(), rewriter, loc);
+      rewriter.atStartOf(ifOp.thenBlock(), [&](SubOpRewriter& rewriter) {
+         rewriter.replaceTupleStream(checkOp, mapping);
+      });
+      return success();
+   }
+};
 class LookupSegmentTreeViewLowering : public SubOpTupleStreamConsumerConversionPattern<subop::LookupOp> {
    public:
    using SubOpTupleStreamConsumerConversionPattern<subop::LookupOp>::SubOpTupleStreamConsumerConversionPattern;
@@ -2526,6 +2739,7 @@ mlir::Value hashKeys(std::vector<mlir::Value> keys, OpBuilder& rewriter, Locatio
       return rewriter.create<db::Hash>(loc, packed);
    }
 }
+//probes tuple-at-a-time, see LookupHashIndexedViewLowering
 class PureLookupHashMapLowering : public SubOpTupleStreamConsumerConversionPattern<subop::LookupOp> {
    public:
    using SubOpTupleStreamConsumerConversionPattern<subop::LookupOp>::SubOpTupleStreamConsumerConversionPattern;
@@ -2674,14 +2888,18 @@ class PureLookupPreAggregationHtLowering : public SubOpTupleStreamConsumerConver
       auto keyPtrType = keyStorageHelper.getRefType();
       Type bucketPtrType = util::RefType::get(context, entryType);
 
-      mlir::Value partition = rewriter.create<mlir::arith::AndIOp>(loc, hashed, rewriter.create<mlir::arith::ConstantIndexOp>(loc, 64 - 1));
       Type partitionHtType = mlir::TupleType::get(rewriter.getContext(), {util::RefType::get(context, bucketPtrType), rewriter.getIndexType()});
-      Value preaggregationHt = rewriter.create<util::GenericMemrefCastOp>(loc, util::RefType::get(context, partitionHtType), adaptor.getState());
-      Value partitionHt = rewriter.create<util::LoadOp>(loc, preaggregationHt, partition);
+      Type partitionHtsType = util::RefType::get(context, partitionHtType);
+      Value castedState = rewriter.create<util::GenericMemrefCastOp>(loc, util::RefType::get(context, mlir::TupleType::get(context, {partitionHtsType, idxType, idxType})), adaptor.getState());
+      Value partitionHts = rewriter.create<util::LoadOp>(loc, partitionHtsType, rewriter.create<util::TupleElementPtrOp>(loc, util::RefType::get(context, partitionHtsType), castedState, 0));
+      Value partitionMask = rewriter.create<util::LoadOp>(loc, idxType, rewriter.create<util::TupleElementPtrOp>(loc, idxPtrType, castedState, 1));
+      Value partitionShift = rewriter.create<util::LoadOp>(loc, idxType, rewriter.create<util::TupleElementPtrOp>(loc, idxPtrType, castedState, 2));
+      mlir::Value partition = rewriter.create<mlir::arith::AndIOp>(loc, hashed, partitionMask);
+      Value partitionHt = rewriter.create<util::LoadOp>(loc, partitionHts, partition);
       auto unpacked = rewriter.create<util::UnPackOp>(loc, partitionHt).getResults();
       Value ht = unpacked[0];
       Value htMask = unpacked[1];
-      Value position = rewriter.create<arith::AndIOp>(loc, htMask, rewriter.create<arith::ShRUIOp>(loc, hashed, rewriter.create<mlir::arith::ConstantIndexOp>(loc, 6)));
+      Value position = rewriter.create<arith::AndIOp>(loc, htMask, rewriter.create<arith::ShRUIOp>(loc, hashed, partitionShift));
       Value ptr = rewriter.create<util::LoadOp>(loc, bucketPtrType, ht, position);
       Value tagMatches = rewriter.create<util::PtrTagMatches>(loc, rewriter.getI1Type(), ptr, hashed);
       ptr = rewriter.create<util::UnTagPtr>(loc, ptr.getType(), ptr);
@@ -2754,6 +2972,7 @@ class PureLookupPreAggregationHtLowering : public SubOpTupleStreamConsumerConver
    }
 };
 
+//probes tuple-at-a-time, see LookupHashIndexedViewLowering
 class LookupHashMultiMapLowering : public SubOpTupleStreamConsumerConversionPattern<subop::LookupOp> {
    public:
    using SubOpTupleStreamConsumerConversionPattern<subop::LookupOp>::SubOpTupleStreamConsumerConversionPattern;
@@ -3029,8 +3248,16 @@ class LookupPreAggrHtFragment : public SubOpTupleStreamConsumerConversionPattern
       auto keyPtrType = keyStorageHelper.getRefType();
       auto valPtrType = valStorageHelper.getRefType();
 
-      Value ht = adaptor.getState();
-      Value htMask = rewriter.create<arith::ConstantIndexOp>(loc, 1024 - 1);
+      auto htType = util::RefType::get(context, util::RefType::get(context, entryType));
+      Value castedState = rewriter.create<util::GenericMemrefCastOp>(loc, util::RefType::get(getContext(), mlir::TupleType::get(getContext(), {htType, idxType, idxType})), adaptor.getState());
+      Value htAddress = rewriter.create<util::TupleElementPtrOp>(loc, util::RefType::get(rewriter.getContext(), htType), castedState, 0);
+      Value htMaskAddress = rewriter.create<util::TupleElementPtrOp>(loc, idxPtrType, castedState, 1);
+      Value numLookupsAddress = rewriter.create<util::TupleElementPtrOp>(loc, idxPtrType, castedState, 2);
+      Value ht = rewriter.create<util::LoadOp>(loc, htType, htAddress);
+      Value htMask = rewriter.create<util::LoadOp>(loc, idxType, htMaskAddress);
+      //the fragment tracks its hit ratio to decide whether pre-aggregation pays off
+      Value numLookups = rewriter.create<util::LoadOp>(loc, idxType, numLookupsAddress);
+      rewriter.create<util::StoreOp>(loc, rewriter.create<arith::AddIOp>(loc, numLookups, rewriter.create<arith::ConstantIndexOp>(loc, 1)), numLookupsAddress, mlir::Value());
       Value falseValue = rewriter.create<arith::ConstantOp>(loc, rewriter.getIntegerAttr(rewriter.getI1Type(), 0));
 
       //position = hash & hashTableMask
@@ -3331,6 +3558,50 @@ class HashMultiMapRefGatherOpLowering : public SubOpTupleStreamConsumerConversio
       return success();
    }
 };
+class GraceJoinRefGatherOpLowering : public SubOpTupleStreamConsumerConversionPattern<subop::GatherOp, 2> {
+   public:
+   using SubOpTupleStreamConsumerConversionPattern<subop::GatherOp, 2>::SubOpTupleStreamConsumerConversionPattern;
+
+   LogicalResult matchAndRewrite(subop::GatherOp gatherOp, OpAdaptor adaptor, SubOpRewriter& rewriter, ColumnMapping& mapping) const override {
+      auto referenceType = mlir::dyn_cast_or_null<subop::GraceJoinEntryRefType>(gatherOp.getRef().getColumn().type);
+      if (!referenceType) { return failure(); }
+      auto graceJoinViewType = referenceType.getGraceJoinView();
+      auto loc = gatherOp->getLoc();
+      EntryStorageHelper buildStorageHelper(gatherOp, graceJoinViewType.getBuildMembers(), false, typeConverter);
+      EntryStorageHelper probeStorageHelper(gatherOp, graceJoinViewType.getProbeMembers(), false, typeConverter);
+      mlir::Value pair = rewriter.create<util::LoadOp>(loc, mapping.resolve(gatherOp, gatherOp.getRef()));
+      llvm::SmallVector<mlir::Value> unpacked;
+      rewriter.createOrFold<util::UnPackOp>(unpacked, loc, pair);
+      mlir::Value buildRef = rewriter.create<util::GenericMemrefCastOp>(loc, buildStorageHelper.getRefType(), unpacked[0]);
+      mlir::Value probeRef = rewriter.create<util::GenericMemrefCastOp>(loc, probeStorageHelper.getRefType(), unpacked[1]);
+      buildStorageHelper.loadIntoColumns(gatherOp.getMapping(), mapping, buildRef, rewriter, loc);
+      probeStorageHelper.loadIntoColumns(gatherOp.getMapping(), mapping, probeRef, rewriter, loc);
+      rewriter.replaceTupleStream(gatherOp, mapping);
+      return success();
+   }
+};
+
+class NestedLoopJoinRefGatherOpLowering : public SubOpTupleStreamConsumerConversionPattern<subop::GatherOp, 2> {
+   public:
+   using SubOpTupleStreamConsumerConversionPattern<subop::GatherOp, 2>::SubOpTupleStreamConsumerConversionPattern;
+
+   LogicalResult matchAndRewrite(subop::GatherOp gatherOp, OpAdaptor adaptor, SubOpRewriter& rewriter, ColumnMapping& mapping) const override {
+      auto referenceType = mlir::dyn_cast_or_null<subop::NestedLoopJoinEntryRefType>(gatherOp.getRef().getColumn().type);
+      if (!referenceType) { return failure(); }
+      auto nestedLoopJoinViewType = referenceType.getNestedLoopJoinView();
+      auto loc = gatherOp->getLoc();
+      EntryStorageHelper buildStorageHelper(gatherOp, nestedLoopJoinViewType.getBuildMembers(), false, typeConverter);
+      EntryStorageHelper probeStorageHelper(gatherOp, nestedLoopJoinViewType.getProbeMembers(), false, typeConverter);
+      llvm::SmallVector<mlir::Value> unpacked;
+      rewriter.createOrFold<util::UnPackOp>(unpacked, loc, mapping.resolve(gatherOp, gatherOp.getRef()));
+      mlir::Value buildRef = rewriter.create<util::GenericMemrefCastOp>(loc, buildStorageHelper.getRefType(), unpacked[0]);
+      mlir::Value probeRef = rewriter.create<util::GenericMemrefCastOp>(loc, probeStorageHelper.getRefType(), unpacked[1]);
+      buildStorageHelper.loadIntoColumns(gatherOp.getMapping(), mapping, buildRef, rewriter, loc);
+      probeStorageHelper.loadIntoColumns(gatherOp.getMapping(), mapping, probeRef, rewriter, loc);
+      rewriter.replaceTupleStream(gatherOp, mapping);
+      return success();
+   }
+};
 
 class ExternalHashIndexRefGatherOpLowering : public SubOpTupleStreamConsumerConversionPattern<subop::GatherOp, 2> {
    public:
@@ -3662,14 +3933,36 @@ class CreateHashIndexedViewLowering : public SubOpConversionPattern<subop::Creat
    LogicalResult matchAndRewrite(subop::CreateHashIndexedView createOp, OpAdaptor adaptor, SubOpRewriter& rewriter) const override {
       auto bufferType = mlir::dyn_cast<subop::BufferType>(createOp.getSource().getType());
       if (!bufferType) return failure();
-      auto linkIsFirst = mlir::cast<mlir::StringAttr>(bufferType.getMembers().getNames()[0]).str() == createOp.getLinkMember();
-      auto hashIsSecond = mlir::cast<mlir::StringAttr>(bufferType.getMembers().getNames()[1]).str() == createOp.getHashMember();
-      if (!linkIsFirst || !hashIsSecond) return failure();
+      //the runtime reads the hash value from the start of every entry
+      auto hashIsFirst = mlir::cast<mlir::StringAttr>(bufferType.getMembers().getNames()[0]).str() == createOp.getHashMember();
+      if (!hashIsFirst) return failure();
       auto htView = rt::HashIndexedView::build(rewriter, createOp->getLoc())({adaptor.getSource()})[0];
       rewriter.replaceOp(createOp, htView);
       return success();
    }
 };
+class CreateGraceJoinViewLowering : public SubOpConversionPattern<subop::CreateGraceJoinView> {
+   using SubOpConversionPattern<subop::CreateGraceJoinView>::SubOpConversionPattern;
+   LogicalResult matchAndRewrite(subop::CreateGraceJoinView createOp, OpAdaptor adaptor, SubOpRewriter& rewriter) const override {
+      auto buildType = mlir::cast<subop::BufferType>(createOp.getBuild().getType());
+      auto probeType = mlir::cast<subop::BufferType>(createOp.getProbe().getType());
+      //the runtime reads the hash value from the start of every entry
+      auto buildHashIsFirst = mlir::cast<mlir::StringAttr>(buildType.getMembers().getNames()[0]).str() == createOp.getBuildHashMember();
+      auto probeHashIsFirst = mlir::cast<mlir::StringAttr>(probeType.getMembers().getNames()[0]).str() == createOp.getProbeHashMember();
+      if (!buildHashIsFirst || !probeHashIsFirst) return failure();
+      auto join = rt::GraceHashJoin::create(rewriter, createOp->getLoc())({adaptor.getBuild(), adaptor.getProbe()})[0];
+      rewriter.replaceOp(createOp, join);
+      return success();
+   }
+};
+class CreateNestedLoopJoinViewLowering : public SubOpConversionPattern<subop::CreateNestedLoopJoinView> {
+   using SubOpConversionPattern<subop::CreateNestedLoopJoinView>::SubOpConversionPattern;
+   LogicalResult matchAndRewrite(subop::CreateNestedLoopJoinView createOp, OpAdaptor adaptor, SubOpRewriter& rewriter) const override {
+      auto join = rt::NestedLoopJoin::create(rewriter, createOp->getLoc())({adaptor.getBuild(), adaptor.getProbe()})[0];
+      rewriter.replaceOp(createOp, join);
+      return success();
+   }
+};
 class CreateContinuousViewLowering : public SubOpConversionPattern<subop::CreateContinuousView> {
    using SubOpConversionPattern<subop::CreateContinuousView>::SubOpConversionPattern;
    LogicalResult matchAndRewrite(subop::CreateContinuousView createOp, OpAdaptor adaptor, SubOpRewriter& rewriter) const override {
@@ -3678,7 +3971,9 @@ class CreateContinuousViewLowering : public SubOpConversionPattern<subop::Create
          rewriter.replaceOp(createOp, adaptor.getSource());
          return success();
       }
-      if (mlir::isa<subop::SortedViewType>(createOp.getSource().getType())) {
+      if (auto sortedViewType = mlir::dyn_cast<subop::SortedViewType>(createOp.getSource().getType())) {
+         //an external sorted view can only be scanned
+         if (sortedViewType.getExternal()) return failure();
          //todo: for now: every sorted view is equivalent to continuous view
          rewriter.replaceOp(createOp, adaptor.getSource());
          return success();
@@ -3757,6 +4052,55 @@ class OffsetReferenceByLowering : public SubOpTupleStreamConsumerConversionPatte
       return success();
    }
 };
+class BinarySearchLowering : public SubOpTupleStreamConsumerConversionPattern<subop::BinarySearchOp> {
+   public:
+   using SubOpTupleStreamConsumerConversionPattern<subop::BinarySearchOp>::SubOpTupleStreamConsumerConversionPattern;
+   LogicalResult matchAndRewrite(subop::BinarySearchOp op, OpAdaptor adaptor, SubOpRewriter& rewriter, ColumnMapping& mapping) const override {
+      auto loc = op->getLoc();
+      auto viewType = mlir::cast<subop::ContinuousViewType>(op.getState().getType());
+      EntryStorageHelper storageHelper(op, viewType.getMembers(), viewType.hasLock(), typeConverter);
+      auto ptrType = storageHelper.getRefType();
+      auto indexType = rewriter.getIndexType();
+      auto keys = mapping.resolve(op, op.getKeys());
+      Value baseRef = rewriter.create<util::BufferGetRef>(loc, ptrType, adaptor.getState());
+      Value len = rewriter.create<util::BufferGetLen>(loc, indexType, adaptor.getState());
+      Value zero = rewriter.create<mlir::arith::ConstantIndexOp>(loc, 0);
+      Value one = rewriter.create<mlir::arith::ConstantIndexOp>(loc, 1);
+      //invariant: all entries before lower sort before the keys, no entry from upper on does
+      auto whileOp = rewriter.create<scf::WhileOp>(loc, TypeRange{indexType, indexType}, ValueRange{zero, len});
+      Block* before = new Block;
+      whileOp.getBefore().push_back(before);
+      before->addArguments(TypeRange{indexType, indexType}, {loc, loc});
+      Block* after = new Block;
+      whileOp.getAfter().push_back(after);
+      after->addArguments(TypeRange{indexType, indexType}, {loc, loc});
+      rewriter.atStartOf(before, [&](SubOpRewriter& rewriter) {
+         Value notEmpty = rewriter.create<arith::CmpIOp>(loc, arith::CmpIPredicate::ult, before->getArgument(0), before->getArgument(1));
+         rewriter.create<scf::ConditionOp>(loc, notEmpty, before->getArguments());
+      });
+      rewriter.atStartOf(after, [&](SubOpRewriter& rewriter) {
+         Value lower = after->getArgument(0);
+         Value upper = after->getArgument(1);
+         Value half = rewriter.create<arith::ShRUIOp>(loc, rewriter.create<arith::SubIOp>(loc, upper, lower), one);
+         Value middle = rewriter.create<arith::AddIOp>(loc, lower, half);
+         Value elementRef = rewriter.create<util::ArrayElementPtrOp>(loc, ptrType, baseRef, middle);
+         auto values = storageHelper.getValueMap(elementRef, rewriter, loc, op.getMembers());
+         std::vector<mlir::Value> arguments(values.begin(), values.end());
+         arguments.insert(arguments.end(), keys.begin(), keys.end());
+         Value sortsBefore = inlineBlock(&op.getFn().front(), rewriter, arguments)[0];
+         Value newLower = rewriter.create<arith::SelectOp>(loc, sortsBefore, rewriter.create<arith::AddIOp>(loc, middle, one), lower);
+         Value newUpper = rewriter.create<arith::SelectOp>(loc, sortsBefore, upper, middle);
+         rewriter.create<scf::YieldOp>(loc, ValueRange{newLower, newUpper});
+      });
+      Value pos = whileOp.getResult(0);
+      if (!op.getPos().getColumn().type.isIndex()) {
+         pos = rewriter.create<mlir::arith::IndexCastOp>(loc, op.getPos().getColumn().type, pos);
+      }
+      mapping.define(op.getPos(), pos);
+      rewriter.replaceTupleStream(op, mapping);
+      return success();
+   }
+};
 class UnwrapOptionalHashmapRefLowering : public SubOpTupleStreamConsumerConversionPattern<subop::UnwrapOptionalRefOp> {
    public:
    using SubOpTupleStreamConsumerConversionPattern<subop::UnwrapOptionalRefOp>::SubOpTupleStreamConsumerConversionPattern;
@@ -4167,7 +4511,16 @@ void handleExecutionStepCPU(subop::ExecutionStepOp step, subop::ExecutionGroupOp
    //HashIndexedView
    rewriter.insertPattern<CreateHashIndexedViewLowering>(typeConverter, ctxt);
    rewriter.insertPattern<LookupHashIndexedViewLowering>(typeConverter, ctxt);
+   rewriter.insertPattern<CheckJoinFilterLowering>(typeConverter, ctxt);
    rewriter.insertPattern<ScanListLowering>(typeConverter, ctxt);
+   //GraceJoinView
+   rewriter.insertPattern<CreateGraceJoinViewLowering>(typeConverter, ctxt);
+   rewriter.insertPattern<ScanRefsGraceJoinViewLowering>(typeConverter, ctxt);
+   rewriter.insertPattern<GraceJoinRefGatherOpLowering>(typeConverter, ctxt);
+   //NestedLoopJoinView
+   rewriter.insertPattern<CreateNestedLoopJoinViewLowering>(typeConverter, ctxt);
+   rewriter.insertPattern<ScanRefsNestedLoopJoinViewLowering>(typeConverter, ctxt);
+   rewriter.insertPattern<NestedLoopJoinRefGatherOpLowering>(typeConverter, ctxt);
    //ContinuousView
    rewriter.insertPattern<CreateContinuousViewLowering>(typeConverter, ctxt);
    rewriter.insertPattern<ScanRefsContinuousViewLowering>(typeConverter, ctxt);
@@ -4180,6 +4533,7 @@ void handleExecutionStepCPU(subop::ExecutionStepOp step, subop::ExecutionGroupOp
    rewriter.insertPattern<CreateHeapLowering>(typeConverter, ctxt);
    rewriter.insertPattern<ScanRefsHeapLowering>(typeConverter, ctxt);
    rewriter.insertPattern<MaterializeHeapLowering>(typeConverter, ctxt);
+   rewriter.insertPattern<CheckHeapBoundLowering>(typeConverter, ctxt);
    //SegmentTreeView
    rewriter.insertPattern<CreateSegmentTreeViewLowering>(typeConverter, ctxt);
    rewriter.insertPattern<LookupSegmentTreeViewLowering>(typeConverter, ctxt);
@@ -4209,6 +4563,7 @@ void handleExecutionStepCPU(subop::ExecutionStepOp step, subop::ExecutionGroupOp
    rewriter.insertPattern<UnwrapOptionalHashmapRefLowering>(typeConverter, ctxt);
    rewriter.insertPattern<OffsetReferenceByLowering>(typeConverter, ctxt);
    rewriter.insertPattern<GetBeginLowering>(typeConverter, ctxt);
+   rewriter.insertPattern<BinarySearchLowering>(typeConverter, ctxt);
    rewriter.insertPattern<GetEndLowering>(typeConverter, ctxt);
    rewriter.insertPattern<EntriesBetweenLowering>(typeConverter, ctxt);
    rewriter.insertPattern<InFlightLowering>(typeConverter, ctxt);
@@ -4276,6 +4631,9 @@ void SubOpToControlFlowLoweringPass::runOnOperation() {
       return util::RefType::get(t.getContext(), mlir::IntegerType::get(ctxt, 8));
    });
    typeConverter.addConversion([&](subop::SortedViewType t) -> Type {
+      if (t.getExternal()) {
+         return util::RefType::get(t.getContext(), mlir::IntegerType::get(ctxt, 8));
+      }
       return util::BufferType::get(t.getContext(), EntryStorageHelper(nullptr, t.getBasedOn().getMembers(), t.hasLock(), &typeConverter).getStorageType());
    });
    typeConverter.addConversion([&](subop::ArrayType t) -> Type {
@@ -4308,6 +4666,12 @@ void SubOpToControlFlowLoweringPass::runOnOperation() {
    typeConverter.addConversion([&](subop::HashIndexedViewType t) -> Type {
       return util::RefType::get(t.getContext(), mlir::IntegerType::get(ctxt, 8));
    });
+   typeConverter.addConversion([&](subop::GraceJoinViewType t) -> Type {
+      return util::RefType::get(t.getContext(), mlir::IntegerType::get(ctxt, 8));
+   });
+   typeConverter.addConversion([&](subop::NestedLoopJoinViewType t) -> Type {
+      return util::RefType::get(t.getContext(), mlir::IntegerType::get(ctxt, 8));
+   });
    typeConverter.addConversion([&](subop::HeapType t) -> Type {
       return util::RefType::get(t.getContext(), mlir::IntegerType::get(ctxt, 8));
    });
@@ -4325,6 +4689,10 @@ void SubOpToControlFlowLoweringPass::runOnOperation() {
          if (auto externalHashIndexRefType = mlir::dyn_cast_or_null<subop::ExternalHashIndexType>(t.getT())) {
             return util::RefType::get(t.getContext(), mlir::IntegerType::get(ctxt, 8));
          }
+         if (mlir::isa<subop::HashIndexedViewType>(lookupEntryRefType.getState())) {
+            //slots of the bucket, number of slots, hash value and whether the bloom tag matched
+            return mlir::TupleType::get(t.getContext(), {util::RefType::get(t.getContext(), mlir::IntegerType::get(ctxt, 8)), mlir::IndexType::get(t.getContext()), mlir::IndexType::get(t.getContext()), mlir::IntegerType::get(ctxt, 1)});
+         }
          return mlir::TupleType::get(t.getContext(), {util::RefType::get(t.getContext(), mlir::IntegerType::get(ctxt, 8)), mlir::IndexType::get(t.getContext())});
       }
       if (auto hashMapEntryRefType = mlir::dyn_cast_or_null<subop::HashMapEntryRefType>(t.getT())) {
@@ -4349,6 +4717,14 @@ void SubOpToControlFlowLoweringPass::runOnOperation() {
       auto hashMapType = t.getHashMap();
       return util::RefType::get(t.getContext(), getHtKVType(hashMapType, typeConverter));
    });
+   typeConverter.addConversion([&](subop::GraceJoinEntryRefType t) -> Type {
+      auto i8PtrType = util::RefType::get(t.getContext(), mlir::IntegerType::get(ctxt, 8));
+      return util::RefType::get(t.getContext(), mlir::TupleType::get(t.getContext(), {i8PtrType, i8PtrType}));
+   });
+   typeConverter.addConversion([&](subop::NestedLoopJoinEntryRefType t) -> Type {
+      auto i8PtrType = util::RefType::get(t.getContext(), mlir::IntegerType::get(ctxt, 8));
+      return mlir::TupleType::get(t.getContext(), {i8PtrType, i8PtrType});
+   });
    typeConverter.addConversion([&](subop::LookupEntryRefType t) -> Type {
       if (mlir::isa<subop::HashMapType, subop::PreAggrHtFragmentType>(t.getState())) {
          return util::RefType::get(t.getContext(), mlir::IntegerType::get(ctxt, 8));
@@ -23,6 +23,10 @@ mlir::Type getBaseType(mlir::Type t) {
    }
    return t;
 }
+bool db::SortKey::isSupported(mlir::Type type) {
+   type = getBaseType(type);
+   return mlir::isa<mlir::IntegerType, mlir::FloatType, db::DateType, db::TimestampType, db::IntervalType, db::DecimalType, db::StringType>(type);
+}
 Type wrapNullableType(MLIRContext* context, Type type, ValueRange values) {
    if (llvm::any_of(values, [](Value v) { return mlir::isa<db::NullableType>(v.getType()); })) {
       return db::NullableType::get(type);
@@ -4,12 +4,15 @@
 #include "lingodb/compiler/Dialect/RelAlg/Transforms/queryopt/QueryGraph.h"
 #include "lingodb/compiler/Dialect/TupleStream/TupleStreamOps.h"
 #include "lingodb/compiler/mlir-support/eval.h"
+#include "lingodb/utility/Setting.h"
 
 #include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/IR/IRMapping.h"
 
 #include "llvm/ADT/TypeSwitch.h"
 
+#include <algorithm>
+#include <optional>
 #include <stack>
 #include <unordered_set>
 
@@ -17,6 +20,21 @@
 
 namespace {
 using namespace lingodb::compiler::dialect;
+//inner hash joins whose estimated build side has at least this many rows use the grace hash join, which can spill to disk (0: never)
+lingodb::utility::GlobalSetting<int64_t> graceJoinMinRows("system.opt.grace_join_min_rows", 0);
+//inner hash joins whose estimated build side has at least this many rows use the grace hash join as well, which radix-partitions large build sides in memory so that every partition is built and probed in cache (0: never)
+//the default corresponds to a build side (entries and table) of several tens of MiB, i.e., beyond the last-level cache
+lingodb::utility::GlobalSetting<int64_t> partitionedJoinMinRows("system.opt.partitioned_join_min_rows", 1 << 20);
+//...but only if the estimated probe side has at most this many times as many rows: materializing and partitioning a much larger probe side
+//costs more than the cache misses it saves, if most probe tuples are rejected by the join filter of the hash-indexed view anyway
+lingodb::utility::GlobalSetting<int64_t> partitionedJoinMaxProbeRatio("system.opt.partitioned_join_max_probe_ratio", 4);
+//inner hash joins whose estimated inputs differ by less than this factor materialize both sides and let the grace hash join
+//build over the input that is actually smaller, as a wrong estimate can otherwise build a huge table from the wrong side (0: never)
+lingodb::utility::GlobalSetting<int64_t> adaptiveJoinRatio("system.opt.adaptive_join_ratio", 2);
+//...if the larger estimated input has at least this many rows: below, building from the wrong side is cheap and the materialization of the probe side dominates
+lingodb::utility::GlobalSetting<int64_t> adaptiveJoinMinRows("system.opt.adaptive_join_min_rows", 1 << 17);
+//inner joins without equality predicates, but with inequality predicates on a column of one side use a sort-based band join instead of nested loops
+lingodb::utility::GlobalSetting<bool> useRangeJoin("system.opt.range_join", true);
 
 class HashJoinUtils {
    public:
@@ -147,6 +165,66 @@ class OptimizeImplementations : public mlir::PassWrapper<OptimizeImplementations
       return res;
    }
 
+   struct RangeJoinBounds {
+      tuples::ColumnRefAttr key;
+      tuples::ColumnRefAttr lower;
+      tuples::ColumnRefAttr upper;
+      bool lowerInclusive = false;
+      bool upperInclusive = false;
+   };
+   //finds anded inequality (or between) predicates that bound a column of keySide by columns of boundSide, prefers keys that are bounded from both sides
+   std::optional<RangeJoinBounds> findRangeJoinBounds(mlir::Block* block, relalg::ColumnSet keySide, relalg::ColumnSet boundSide) {
+      std::vector<RangeJoinBounds> candidates;
+      auto getColumn = [](mlir::Value v) -> tuples::ColumnRefAttr {
+         if (auto getColOp = mlir::dyn_cast_or_null<tuples::GetColumnOp>(v.getDefiningOp())) {
+            return getColOp.getAttr();
+         }
+         return {};
+      };
+      auto addBound = [&](tuples::ColumnRefAttr key, tuples::ColumnRefAttr bound, bool isLower, bool inclusive) {
+         if (!key || !bound || !keySide.contains(&key.getColumn()) || !boundSide.contains(&bound.getColumn())) return;
+         auto it = llvm::find_if(candidates, [&](const RangeJoinBounds& c) { return &c.key.getColumn() == &key.getColumn(); });
+         if (it == candidates.end()) {
+            candidates.push_back({key});
+            it = std::prev(candidates.end());
+         }
+         auto& existing = isLower ? it->lower : it->upper;
+         if (!existing) {
+            existing = bound;
+            (isLower ? it->lowerInclusive : it->upperInclusive) = inclusive;
+         }
+      };
+      block->walk([&](mlir::Operation* op) {
+         if (auto betweenOp = mlir::dyn_cast_or_null<db::BetweenOp>(op)) {
+            if (HashJoinUtils::isAndedResult(op)) {
+               addBound(getColumn(betweenOp.getVal()), getColumn(betweenOp.getLower()), true, betweenOp.getLowerInclusive());
+               addBound(getColumn(betweenOp.getVal()), getColumn(betweenOp.getUpper()), false, betweenOp.getUpperInclusive());
+            }
+         } else if (auto cmpOp = mlir::dyn_cast_or_null<relalg::CmpOpInterface>(op)) {
+            if (HashJoinUtils::isAndedResult(op)) {
+               auto left = getColumn(cmpOp.getLeft());
+               auto right = getColumn(cmpOp.getRight());
+               for (bool eq : {false, true}) {
+                  if (cmpOp.isLessPred(eq)) {
+                     addBound(left, right, false, eq);
+                     addBound(right, left, true, eq);
+                  } else if (cmpOp.isGreaterPred(eq)) {
+                     addBound(left, right, true, eq);
+                     addBound(right, left, false, eq);
+                  }
+               }
+            }
+         }
+      });
+      std::optional<RangeJoinBounds> best;
+      for (auto& candidate : candidates) {
+         if (!best || (candidate.lower && candidate.upper && !(best->lower && best->upper))) {
+            best = candidate;
+         }
+      }
+      return best;
+   }
+
    // Verify that the join predicate in block takes all and only the primary key columns from baseTableOp into consideration
    bool containsExactlyIndexColumns(mlir::MLIRContext* ctxt, mlir::Operation* baseTableOp, mlir::Block* block, std::string& indexName) {
       llvm::DenseMap<mlir::Value, relalg::ColumnSet> columns;
@@ -558,8 +636,36 @@ class OptimizeImplementations : public mlir::PassWrapper<OptimizeImplementations
                   } else {
                      op->setAttr("impl", mlir::StringAttr::get(op.getContext(), "hash"));
                      op->setAttr("useHashJoin", mlir::UnitAttr::get(op.getContext()));
+                     auto exceeds = [&](int64_t minRows) { return minRows > 0 && numRowsLeft >= minRows; };
+                     bool partitioned = exceeds(partitionedJoinMinRows.getValue()) && numRowsRight <= partitionedJoinMaxProbeRatio.getValue() * numRowsLeft;
+                     bool closeCall = adaptiveJoinRatio.getValue() > 0 && right->hasAttr("rows") && std::max(numRowsLeft, numRowsRight) >= adaptiveJoinMinRows.getValue() && std::max(numRowsLeft, numRowsRight) < adaptiveJoinRatio.getValue() * std::min(numRowsLeft, numRowsRight);
+                     if (isInnerJoin && left->hasAttr("rows") && (exceeds(graceJoinMinRows.getValue()) || partitioned || closeCall)) {
+                        op->setAttr("impl", mlir::StringAttr::get(op.getContext(), "gracehash"));
+                        op->setAttr("useGraceHashJoin", mlir::UnitAttr::get(op.getContext()));
+                     }
                      prepareForHash(predicateOperator);
                   }
+               } else if (mlir::isa<relalg::InnerJoinOp>(predicateOperator) && useRangeJoin.getValue()) {
+                  //the build side is sorted by the bounded column, by default the left side is the build side
+                  auto leftBounds = findRangeJoinBounds(&predicateOperator.getPredicateBlock(), left.getAvailableColumns(), right.getAvailableColumns());
+                  auto rightBounds = findRangeJoinBounds(&predicateOperator.getPredicateBlock(), right.getAvailableColumns(), left.getAvailableColumns());
+                  auto isBand = [](const std::optional<RangeJoinBounds>& bounds) { return bounds && bounds->lower && bounds->upper; };
+                  bool buildRight = rightBounds && (!leftBounds || (isBand(rightBounds) && !isBand(leftBounds)));
+                  auto bounds = buildRight ? rightBounds : leftBounds;
+                  if (bounds) {
+                     op->setAttr("impl", mlir::StringAttr::get(op.getContext(), "range"));
+                     op->setAttr("useRangeJoin", mlir::UnitAttr::get(op.getContext()));
+                     op->setAttr("rangeKey", bounds->key);
+                     if (bounds->lower) {
+                        op->setAttr("rangeLower", bounds->lower);
+                        if (bounds->lowerInclusive) op->setAttr("rangeLowerInclusive", mlir::UnitAttr::get(op.getContext()));
+                     }
+                     if (bounds->upper) {
+                        op->setAttr("rangeUpper", bounds->upper);
+                        if (bounds->upperInclusive) op->setAttr("rangeUpperInclusive", mlir::UnitAttr::get(op.getContext()));
+                     }
+                     if (buildRight) op->setAttr("rangeBuildRight", mlir::UnitAttr::get(op.getContext()));
+                  }
                }
             })
             .Case<relalg::SemiJoinOp, relalg::AntiSemiJoinOp, relalg::OuterJoinOp, relalg::MarkJoinOp>([&](PredicateOperator predicateOperator) {
@@ -373,7 +373,8 @@ ParseResult subop::CreateSortedViewOp::parse(::mlir::OpAsmParser& parser, ::mlir
    args.insert(args.end(), rightArgs.begin(), rightArgs.end());
    Region* body = result.addRegion();
    if (parser.parseRegion(*body, args)) return failure();
-   result.types.push_back(subop::SortedViewType::get(parser.getContext(), vecType));
+   bool external = parser.parseOptionalKeyword("external").succeeded();
+   result.types.push_back(subop::SortedViewType::get(parser.getContext(), vecType, external));
    if (parser.parseOptionalAttrDict(result.attributes))
       return ::mlir::failure();
    return success();
@@ -404,6 +405,9 @@ void subop::CreateSortedViewOp::print(OpAsmPrinter& p) {
    }
    p << "])";
    p.printRegion(op.getRegion(), false, true);
+   if (op.getType().getExternal()) {
+      p << " external";
+   }
    p.printOptionalAttrDict(getOperation()->getAttrs(), {"sortBy"});
 }
 ParseResult subop::LookupOrInsertOp::parse(::mlir::OpAsmParser& parser, ::mlir::OperationState& result) {
@@ -1222,11 +1226,23 @@ std::vector<std::string> subop::CreateSortedViewOp::getWrittenMembers() {
    return res;
 }
 std::vector<std::string> subop::CreateHashIndexedView::getWrittenMembers() {
-   return {getLinkMember().str(), getHashMember().str()}; //todo: hack
+   return {getHashMember().str()}; //todo: hack
 }
 std::vector<std::string> subop::CreateHashIndexedView::getReadMembers() {
    return {getHashMember().str()};
 }
+std::vector<std::string> subop::CreateGraceJoinView::getWrittenMembers() {
+   return {};
+}
+std::vector<std::string> subop::CreateGraceJoinView::getReadMembers() {
+   return {getBuildHashMember().str(), getProbeHashMember().str()};
+}
+std::vector<std::string> subop::CreateNestedLoopJoinView::getWrittenMembers() {
+   return {};
+}
+std::vector<std::string> subop::CreateNestedLoopJoinView::getReadMembers() {
+   return {};
+}
 std::vector<std::string> subop::MergeOp::getReadMembers() {
    auto names = getThreadLocal().getType().getWrapped().getMembers().getNames();
    std::vector<std::string> res;
@@ -1407,6 +1423,20 @@ mlir::Operation* subop::MaterializeOp::cloneSubOp(mlir::OpBuilder& builder, mlir
    mapResults(mapping, this->getOperation(), newOp.getOperation());
    return newOp;
 }
+mlir::LogicalResult subop::CheckHeapBoundOp::foldColumns(subop::ColumnMapping& columnInfo) {
+   setMappingAttr(columnInfo.remap(getMapping()));
+   return mlir::success();
+}
+mlir::Operation* subop::CheckHeapBoundOp::cloneSubOp(mlir::OpBuilder& builder, mlir::IRMapping& mapping, subop::ColumnMapping& columnMapping) {
+   auto newOp = builder.create<CheckHeapBoundOp>(this->getLoc(), mapping.lookupOrDefault(getStream()), mapping.lookupOrDefault(getState()), columnMapping.remap(getMapping()));
+   mapResults(mapping, this->getOperation(), newOp.getOperation());
+   return newOp;
+}
+mlir::Operation* subop::CheckJoinFilterOp::cloneSubOp(mlir::OpBuilder& builder, mlir::IRMapping& mapping, subop::ColumnMapping& columnMapping) {
+   auto newOp = builder.create<CheckJoinFilterOp>(this->getLoc(), mapping.lookupOrDefault(getStream()), mapping.lookupOrDefault(getState()), columnMapping.remap(getHash()));
+   mapResults(mapping, this->getOperation(), newOp.getOperation());
+   return newOp;
+}
 mlir::LogicalResult subop::InsertOp::foldColumns(subop::ColumnMapping& columnInfo) {
    setMappingAttr(columnInfo.remap(getMapping()));
    return mlir::success();
@@ -1565,6 +1595,33 @@ void subop::MaterializeOp::updateStateType(subop::SubOpStateUsageTransformer& tr
    }
 }
 
+void subop::CheckHeapBoundOp::replaceColumns(subop::SubOpStateUsageTransformer& transformer, tuples::Column* oldColumn, tuples::Column* newColumn) {
+   assert(false && "should not happen");
+}
+void subop::CheckHeapBoundOp::updateStateType(subop::SubOpStateUsageTransformer& transformer, mlir::Value state, mlir::Type newType) {
+   if (state == getState() && newType != state.getType()) {
+      setMappingAttr(transformer.updateMapping(getMapping()));
+   }
+}
+
+void subop::CheckJoinFilterOp::replaceColumns(subop::SubOpStateUsageTransformer& transformer, tuples::Column* oldColumn, tuples::Column* newColumn) {
+   if (&getHash().getColumn() == oldColumn) {
+      setHashAttr(transformer.getColumnManager().createRef(newColumn));
+   }
+}
+void subop::CheckJoinFilterOp::updateStateType(subop::SubOpStateUsageTransformer& transformer, mlir::Value state, mlir::Type newType) {
+   //only the bloom filter of the view is accessed
+}
+
+void subop::BinarySearchOp::replaceColumns(subop::SubOpStateUsageTransformer& transformer, tuples::Column* oldColumn, tuples::Column* newColumn) {
+   assert(false && "should not happen");
+}
+void subop::BinarySearchOp::updateStateType(subop::SubOpStateUsageTransformer& transformer, mlir::Value state, mlir::Type newType) {
+   if (state == getState() && newType != state.getType()) {
+      setMembersAttr(transformer.updateMembers(getMembers()));
+   }
+}
+
 void subop::ExecutionStepOp::replaceColumns(subop::SubOpStateUsageTransformer& transformer, tuples::Column* oldColumn, tuples::Column* newColumn) {
    assert(false && "should not happen");
 }
@@ -1655,6 +1712,19 @@ mlir::Operation* subop::OffsetReferenceBy::cloneSubOp(mlir::OpBuilder& builder,
    mapResults(mapping, this->getOperation(), newOp.getOperation());
    return newOp;
 }
+std::vector<std::string> subop::BinarySearchOp::getReadMembers() {
+   std::vector<std::string> res;
+   for (auto x : getMembers()) {
+      res.push_back(mlir::cast<mlir::StringAttr>(x).str());
+   }
+   return res;
+}
+mlir::Operation* subop::BinarySearchOp::cloneSubOp(mlir::OpBuilder& builder, mlir::IRMapping& mapping, subop::ColumnMapping& columnMapping) {
+   auto newOp = builder.create<BinarySearchOp>(this->getLoc(), mapping.lookupOrDefault(getStream()), mapping.lookupOrDefault(getState()), getMembers(), columnMapping.remap(getKeys()), columnMapping.clone(getPos()));
+   builder.cloneRegionBefore(getFn(), newOp.getFn(), newOp.getFn().begin(), mapping);
+   mapResults(mapping, this->getOperation(), newOp.getOperation());
+   return newOp;
+}
 mlir::Operation* subop::GenerateOp::cloneSubOp(mlir::OpBuilder& builder, mlir::IRMapping& mapping, subop::ColumnMapping& columnMapping) {
    auto newOp = builder.create<GenerateOp>(this->getLoc(), getResultTypes(), columnMapping.clone(getGeneratedColumns()));
    builder.cloneRegionBefore(getRegion(), newOp.getRegion(), newOp.getRegion().begin(), mapping);
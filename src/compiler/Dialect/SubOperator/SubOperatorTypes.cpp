@@ -128,6 +128,24 @@ subop::StateMembersAttr subop::HashIndexedViewType::getMembers() {
    types.insert(types.end(), getValueMembers().getTypes().begin(), getValueMembers().getTypes().end());
    return subop::StateMembersAttr::get(this->getContext(), mlir::ArrayAttr::get(this->getContext(), names), mlir::ArrayAttr::get(this->getContext(), types));
 }
+subop::StateMembersAttr subop::GraceJoinViewType::getMembers() {
+   std::vector<mlir::Attribute> names;
+   std::vector<mlir::Attribute> types;
+   names.insert(names.end(), getBuildMembers().getNames().begin(), getBuildMembers().getNames().end());
+   names.insert(names.end(), getProbeMembers().getNames().begin(), getProbeMembers().getNames().end());
+   types.insert(types.end(), getBuildMembers().getTypes().begin(), getBuildMembers().getTypes().end());
+   types.insert(types.end(), getProbeMembers().getTypes().begin(), getProbeMembers().getTypes().end());
+   return subop::StateMembersAttr::get(this->getContext(), mlir::ArrayAttr::get(this->getContext(), names), mlir::ArrayAttr::get(this->getContext(), types));
+}
+subop::StateMembersAttr subop::NestedLoopJoinViewType::getMembers() {
+   std::vector<mlir::Attribute> names;
+   std::vector<mlir::Attribute> types;
+   names.insert(names.end(), getBuildMembers().getNames().begin(), getBuildMembers().getNames().end());
+   names.insert(names.end(), getProbeMembers().getNames().begin(), getProbeMembers().getNames().end());
+   types.insert(types.end(), getBuildMembers().getTypes().begin(), getBuildMembers().getTypes().end());
+   types.insert(types.end(), getProbeMembers().getTypes().begin(), getProbeMembers().getTypes().end());
+   return subop::StateMembersAttr::get(this->getContext(), mlir::ArrayAttr::get(this->getContext(), names), mlir::ArrayAttr::get(this->getContext(), types));
+}
 subop::StateMembersAttr subop::SegmentTreeViewType::getMembers() {
    std::vector<mlir::Attribute> names;
    std::vector<mlir::Attribute> types;
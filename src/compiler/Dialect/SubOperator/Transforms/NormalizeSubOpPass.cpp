@@ -93,6 +93,12 @@ class SplitGenericScan : public mlir::RewritePattern {
       if (auto hashMultiMapType = mlir::dyn_cast_or_null<subop::HashMultiMapType>(scanOp.getState().getType())) {
          refType = subop::HashMultiMapEntryRefType::get(rewriter.getContext(), hashMultiMapType);
       }
+      if (auto graceJoinViewType = mlir::dyn_cast_or_null<subop::GraceJoinViewType>(scanOp.getState().getType())) {
+         refType = subop::GraceJoinEntryRefType::get(rewriter.getContext(), graceJoinViewType);
+      }
+      if (auto nestedLoopJoinViewType = mlir::dyn_cast_or_null<subop::NestedLoopJoinViewType>(scanOp.getState().getType())) {
+         refType = subop::NestedLoopJoinEntryRefType::get(rewriter.getContext(), nestedLoopJoinViewType);
+      }
 
       auto [refDef, refRef] = createColumn(refType, "scan", "ref");
       mlir::Value scanRefsOp = rewriter.create<subop::ScanRefsOp>(op->getLoc(), scanOp.getState(), refDef);
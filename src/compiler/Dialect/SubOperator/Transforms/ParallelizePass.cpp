@@ -126,6 +126,12 @@ ExecutionStepAnalyzed analyze(subop::ExecutionStepOp executionStepOp, subop::Col
       if (auto stateUsingSubOp = mlir::dyn_cast_or_null<subop::StateUsingSubOperator>(pipelineOp)) {
          if (mlir::isa<subop::ScanListOp, subop::NestedMapOp>(pipelineOp)) {
             // ignore
+         } else if (mlir::isa<subop::CheckHeapBoundOp>(pipelineOp)) {
+            // only reads the bound of the heap, which the runtime shares between the thread-local heaps
+         } else if (mlir::isa<subop::CheckJoinFilterOp>(pipelineOp)) {
+            // only reads the bloom filter of the view, which is not modified after the view was built
+         } else if (mlir::isa<subop::BinarySearchOp>(pipelineOp)) {
+            // only reads from the view, which is not modified after the view was built
          } else if (auto materializeOp = mlir::dyn_cast_or_null<subop::MaterializeOp>(pipelineOp)) {
             if (!isNested(materializeOp.getState())) {
                addProblematicOp(materializeOp, getCollisions(), {});
@@ -71,14 +71,12 @@ class MultiMapAsHashIndexedView : public mlir::RewritePattern {
       }
 
       auto hashMember = memberManager.getUniqueMember("hash");
-      auto linkMember = memberManager.getUniqueMember("link");
       auto [hashDef, hashRef] = createColumn(rewriter.getIndexType(), "hj", "hash");
-      auto linkType = util::RefType::get(rewriter.getContext(), rewriter.getI8Type());
-      auto [linkDef, linkRef] = createColumn(linkType, "hj", "link");
       auto loc = op->getLoc();
 
-      std::vector<mlir::Attribute> bufferMemberTypes{mlir::TypeAttr::get(linkType), mlir::TypeAttr::get(rewriter.getIndexType())};
-      std::vector<mlir::Attribute> bufferMemberNames{rewriter.getStringAttr(linkMember), rewriter.getStringAttr(hashMember)};
+      //the unchained view references the entries from its slots, so they only start with their hash value
+      std::vector<mlir::Attribute> bufferMemberTypes{mlir::TypeAttr::get(rewriter.getIndexType())};
+      std::vector<mlir::Attribute> bufferMemberNames{rewriter.getStringAttr(hashMember)};
       bufferMemberNames.insert(bufferMemberNames.end(), multiMapType.getMembers().getNames().begin(), multiMapType.getMembers().getNames().end());
       bufferMemberTypes.insert(bufferMemberTypes.end(), multiMapType.getMembers().getTypes().begin(), multiMapType.getMembers().getTypes().end());
       std::vector<mlir::Attribute> hashIndexedViewTypes{multiMapType.getMembers().getTypes().begin(), multiMapType.getMembers().getTypes().end()};
@@ -90,6 +88,9 @@ class MultiMapAsHashIndexedView : public mlir::RewritePattern {
          mlir::OpBuilder::InsertionGuard guard(rewriter);
          rewriter.setInsertionPoint(createOp);
          buffer = rewriter.create<subop::GenericCreateOp>(loc, bufferType);
+         if (auto initialCapacity = createOp->getAttr("initial_capacity")) {
+            buffer.getDefiningOp()->setAttr("initial_capacity", initialCapacity);
+         }
       }
       mlir::Type hashIndexedViewType;
       mlir::Value hashIndexedView;
@@ -102,8 +103,7 @@ class MultiMapAsHashIndexedView : public mlir::RewritePattern {
             values.push_back(buildHashHelper.access(keyColumnAttr, loc));
          }
          mlir::Value hashed = hashKeys(values, rewriter, loc);
-         mlir::Value inValidLink = rewriter.create<util::InvalidRefOp>(loc, linkType);
-         rewriter.create<tuples::ReturnOp>(loc, mlir::ValueRange{hashed, inValidLink});
+         rewriter.create<tuples::ReturnOp>(loc, mlir::ValueRange{hashed});
       });
 
       bool compareHashForLookup = true;
@@ -117,14 +117,13 @@ class MultiMapAsHashIndexedView : public mlir::RewritePattern {
       {
          mlir::OpBuilder::InsertionGuard guard(rewriter);
          rewriter.setInsertionPoint(insertOp);
-         auto mapOp = rewriter.create<subop::MapOp>(loc, insertOp.getStream(), rewriter.getArrayAttr({hashDef, linkDef}), buildHashHelper.getColRefs());
+         auto mapOp = rewriter.create<subop::MapOp>(loc, insertOp.getStream(), rewriter.getArrayAttr({hashDef}), buildHashHelper.getColRefs());
          mapOp.getFn().push_back(buildHashHelper.getMapBlock());
          std::vector<mlir::NamedAttribute> newMapping(insertOp.getMapping().begin(), insertOp.getMapping().end());
          newMapping.push_back(rewriter.getNamedAttr(hashMember, hashRef));
-         newMapping.push_back(rewriter.getNamedAttr(linkMember, linkRef));
          rewriter.create<subop::MaterializeOp>(loc, mapOp.getResult(), buffer, rewriter.getDictionaryAttr(newMapping));
          hashIndexedViewType = subop::HashIndexedViewType::get(rewriter.getContext(), subop::StateMembersAttr::get(rewriter.getContext(), rewriter.getArrayAttr({rewriter.getStringAttr(hashMember)}), rewriter.getArrayAttr({mlir::TypeAttr::get(rewriter.getIndexType())})), subop::StateMembersAttr::get(getContext(), rewriter.getArrayAttr(hashIndexedViewNames), rewriter.getArrayAttr(hashIndexedViewTypes)), compareHashForLookup);
-         hashIndexedView = rewriter.create<subop::CreateHashIndexedView>(loc, hashIndexedViewType, buffer, hashMember, linkMember);
+         hashIndexedView = rewriter.create<subop::CreateHashIndexedView>(loc, hashIndexedViewType, buffer, hashMember);
       }
       auto entryRefType = subop::LookupEntryRefType::get(rewriter.getContext(), mlir::cast<subop::LookupAbleState>(hashIndexedViewType));
       auto entryRefListType = subop::ListType::get(rewriter.getContext(), entryRefType);
@@ -167,8 +166,46 @@ class MultiMapAsHashIndexedView : public mlir::RewritePattern {
             gatheredForEqFn.push_back(rewriter.getNamedAttr(name, lookupKeyMemberDef));
             keyRefsForEqFn.push_back(lookupKeyMemberRef);
          }
-         auto mapOp = rewriter.create<subop::MapOp>(loc, lookupOp.getStream(), rewriter.getArrayAttr({hashDefLookup}), lookupHashHelper.getColRefs());
+         //the bloom filter drops probe tuples without a match, which is only correct if the consumer of the lookup ignores them (marked as filterable)
+         //it only needs the hash value: check it before the preceding maps and filters of the probe pipeline that do not compute a key
+         bool filterable = lookupOp->hasAttr("filterable");
+         std::vector<mlir::Operation*> probeChain;
+         mlir::Value probeStream = lookupOp.getStream();
+         if (filterable) {
+            mlir::Operation* consumer = lookupOp;
+            while (auto* producer = probeStream.getDefiningOp()) {
+               if (producer->getBlock() != lookupOp->getBlock() || !llvm::all_of(producer->getUsers(), [&](mlir::Operation* user) { return user == consumer; })) break;
+               if (auto probeMapOp = mlir::dyn_cast<subop::MapOp>(producer)) {
+                  bool computesKey = llvm::any_of(probeMapOp.getComputedCols(), [&](mlir::Attribute computed) {
+                     return llvm::any_of(lookupKeys, [&](mlir::Attribute key) { return &mlir::cast<tuples::ColumnRefAttr>(key).getColumn() == &mlir::cast<tuples::ColumnDefAttr>(computed).getColumn(); });
+                  });
+                  if (computesKey) break;
+               } else if (!mlir::isa<subop::FilterOp>(producer)) {
+                  break;
+               }
+               probeChain.insert(probeChain.begin(), producer);
+               consumer = producer;
+               probeStream = producer->getOperand(0);
+            }
+         }
+         //the view is created after the probe pipeline started, so the skipped ops are moved behind the check
+         for (auto* chainOp : probeChain) {
+            rewriter.moveOpBefore(chainOp, lookupOp);
+         }
+         if (!probeChain.empty()) {
+            rewriter.setInsertionPoint(probeChain.front());
+         }
+         auto mapOp = rewriter.create<subop::MapOp>(loc, probeStream, rewriter.getArrayAttr({hashDefLookup}), lookupHashHelper.getColRefs());
          mapOp.getFn().push_back(lookupHashHelper.getMapBlock());
+         mlir::Value probed = mapOp.getResult();
+         if (filterable) {
+            probed = rewriter.create<subop::CheckJoinFilterOp>(loc, mapOp.getResult(), hashIndexedView, hashRefLookup);
+         }
+         if (!probeChain.empty()) {
+            rewriter.modifyOpInPlace(probeChain.front(), [&]() { probeChain.front()->setOperand(0, probed); });
+            probed = lookupOp.getStream();
+            rewriter.setInsertionPoint(lookupOp);
+         }
          subop::MapCreationHelper predFnHelper(rewriter.getContext());
          predFnHelper.buildBlock(rewriter, [&](mlir::PatternRewriter& rewriter) {
             mlir::IRMapping mapping;
@@ -184,7 +221,7 @@ class MultiMapAsHashIndexedView : public mlir::RewritePattern {
                rewriter.clone(op, mapping);
             }
          });
-         rewriter.replaceOpWithNewOp<subop::LookupOp>(lookupOp, tuples::TupleStreamType::get(rewriter.getContext()), mapOp.getResult(), hashIndexedView, rewriter.getArrayAttr({hashRefLookup}), listDef);
+         rewriter.replaceOpWithNewOp<subop::LookupOp>(lookupOp, tuples::TupleStreamType::get(rewriter.getContext()), probed, hashIndexedView, rewriter.getArrayAttr({hashRefLookup}), listDef);
 
          mlir::Value currentTuple;
          transformer.setCallBeforeFn([&](mlir::Operation* op) {
@@ -248,7 +285,11 @@ class MapAsHashMap : public mlir::RewritePattern {
          return typeConverter.convertType(type);
       });
       transformer.updateValue(createOp.getRes(), hashMapType);
-      rewriter.replaceOpWithNewOp<subop::GenericCreateOp>(op, hashMapType);
+      auto initialCapacity = createOp->getAttr("initial_capacity");
+      auto newCreateOp = rewriter.replaceOpWithNewOp<subop::GenericCreateOp>(op, hashMapType);
+      if (initialCapacity) {
+         newCreateOp->setAttr("initial_capacity", initialCapacity);
+      }
 
       return mlir::success();
    }
@@ -287,7 +328,11 @@ class MultiMapAsHashMultiMap : public mlir::RewritePattern {
          return typeConverter.convertType(type);
       });
       transformer.updateValue(createOp.getRes(), hashMapType);
-      rewriter.replaceOpWithNewOp<subop::GenericCreateOp>(op, hashMapType);
+      auto initialCapacity = createOp->getAttr("initial_capacity");
+      auto newCreateOp = rewriter.replaceOpWithNewOp<subop::GenericCreateOp>(op, hashMapType);
+      if (initialCapacity) {
+         newCreateOp->setAttr("initial_capacity", initialCapacity);
+      }
 
       return mlir::success();
    }
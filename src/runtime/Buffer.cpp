@@ -122,6 +122,13 @@ class FlexibleBufferIteratorTask : public lingodb::scheduler::TaskWithImplicitCo
       workExhausted.store(true);
       return false;
    }
+   size_t maxParallelism() override {
+      size_t units = 0;
+      for (auto& buffer : buffers) {
+         units += (buffer.numElements + splitSize - 1) / splitSize;
+      }
+      return units;
+   }
    void performWork() override {
       auto* state = workerResvs[lingodb::scheduler::currentWorkerId()].get();
       if (state->stealWorkerId != std::numeric_limits<size_t>::max()) {
@@ -157,6 +164,9 @@ class BufferIteratorTask : public lingodb::scheduler::TaskWithImplicitContext {
       workerResvs[lingodb::scheduler::currentWorkerId()] = localStartIndex;
       return true;
    }
+   size_t maxParallelism() override {
+      return (bufferLen + splitSize - 1) / splitSize;
+   }
    void performWork() override {
       auto localStartIndex = workerResvs[lingodb::scheduler::currentWorkerId()];
       auto begin = localStartIndex * splitSize;
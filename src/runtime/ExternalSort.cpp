@@ -0,0 +1,247 @@
+#include "lingodb/runtime/ExternalSort.h"
+#include "lingodb/runtime/ExecutionContext.h"
+#include "lingodb/runtime/GrowingBuffer.h"
+#include "lingodb/runtime/Sorting.h"
+#include "lingodb/scheduler/Tasks.h"
+#include "lingodb/utility/Tracer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+
+namespace {
+static lingodb::utility::Tracer::Event createEvent("ExternalSort", "create");
+static lingodb::utility::Tracer::Event createRunEvent("ExternalSort", "createRun");
+static lingodb::utility::Tracer::Event mergeEvent("ExternalSort", "merge");
+
+//upper bound for the fan-in of the final merge
+constexpr size_t maxRuns = 1024;
+constexpr size_t minRunElements = 1024;
+constexpr size_t entriesPerChunk = 1024;
+
+struct RunRange {
+   lingodb::runtime::Buffer buffer;
+   size_t begin;
+   size_t end;
+};
+
+//reads a spilled run block by block
+class RunCursor {
+   const lingodb::runtime::SpillFile& spillFile;
+   const std::vector<lingodb::runtime::ExternalSort::Segment>& segments;
+   size_t typeSize;
+   size_t blockBytes;
+   size_t segment;
+   size_t segmentOffset;
+   std::vector<uint8_t> block;
+   size_t pos;
+
+   public:
+   RunCursor(const lingodb::runtime::SpillFile& spillFile, const std::vector<lingodb::runtime::ExternalSort::Segment>& segments, size_t typeSize, size_t blockBytes) : spillFile(spillFile), segments(segments), typeSize(typeSize), blockBytes(blockBytes), segment(0), segmentOffset(0), pos(0) {
+      block.reserve(blockBytes);
+      refill();
+   }
+   bool isValid() const {
+      return pos < block.size();
+   }
+   uint8_t* current() {
+      return &block[pos];
+   }
+   void next() {
+      pos += typeSize;
+      if (pos == block.size()) {
+         refill();
+      }
+   }
+
+   private:
+   void refill() {
+      pos = 0;
+      block.clear();
+      while (segment < segments.size() && segmentOffset == segments[segment].len) {
+         segment++;
+         segmentOffset = 0;
+      }
+      if (segment == segments.size()) {
+         return;
+      }
+      size_t len = std::min(blockBytes, segments[segment].len - segmentOffset);
+      block.resize(len);
+      spillFile.read(segments[segment].offset + segmentOffset, block.data(), len);
+      segmentOffset += len;
+   }
+};
+} // end namespace
+
+namespace lingodb::runtime {
+class ExternalSortIterator : public BufferIterator {
+   ExternalSort& sort;
+
+   public:
+   ExternalSortIterator(ExternalSort& sort) : sort(sort) {}
+   bool isValid() override {
+      return false;
+   }
+   void next() override {}
+   Buffer getCurrentBuffer() override {
+      return Buffer{0, nullptr};
+   }
+   //only the sequential iteration preserves the order: in parallel, the spilled runs are not merged and the chunks are processed concurrently
+   void iterateEfficient(bool parallel, void (*forEachChunk)(Buffer, void*), void* contextPtr) override {
+      if (sort.spillFile) {
+         if (parallel) {
+            sort.scanRunsParallel(forEachChunk, contextPtr);
+         } else {
+            sort.merge(forEachChunk, contextPtr);
+         }
+         return;
+      }
+      size_t chunkBytes = entriesPerChunk * sort.typeSize;
+      size_t numChunks = (sort.sorted.numElements + chunkBytes - 1) / chunkBytes;
+      auto produceChunk = [&](size_t chunk) {
+         size_t begin = chunk * chunkBytes;
+         forEachChunk(Buffer{std::min(chunkBytes, sort.sorted.numElements - begin), &sort.sorted.ptr[begin]}, contextPtr);
+      };
+      if (parallel) {
+         lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(numChunks, produceChunk));
+      } else {
+         for (size_t chunk = 0; chunk < numChunks; chunk++) {
+            produceChunk(chunk);
+         }
+      }
+   }
+};
+} // end namespace lingodb::runtime
+
+lingodb::runtime::ExternalSort::ExternalSort(GrowingBuffer* input, bool (*compareFn)(uint8_t*, uint8_t*), uint64_t (*keyFn)(uint8_t*), MemoryBudget* memoryBudget) : input(input), compareFn(compareFn), keyFn(keyFn), typeSize(input->getTypeSize()), memoryBudget(memoryBudget), sorted{0, nullptr} {}
+
+lingodb::runtime::ExternalSort* lingodb::runtime::ExternalSort::create(GrowingBuffer* input, bool (*compareFn)(uint8_t*, uint8_t*)) {
+   return createByKey(input, compareFn, nullptr);
+}
+
+lingodb::runtime::ExternalSort* lingodb::runtime::ExternalSort::createByKey(GrowingBuffer* input, bool (*compareFn)(uint8_t*, uint8_t*), uint64_t (*keyFn)(uint8_t*)) {
+   utility::Tracer::Trace trace(createEvent);
+   auto* executionContext = runtime::getCurrentExecutionContext();
+   auto& memoryBudget = executionContext->getMemoryBudget();
+   auto* sort = new ExternalSort(input, compareFn, keyFn, &memoryBudget);
+   executionContext->registerState({sort, [](void* ptr) { delete reinterpret_cast<ExternalSort*>(ptr); }});
+   //the in-memory sort needs a sorted copy of the input and a pointer (comparison sort) or two keyed entries (radix sort) per entry
+   size_t inMemoryBytes = input->getLen() * (sort->getSortBytesPerEntry() + sort->typeSize);
+   if (!memoryBudget.getLimit() || memoryBudget.getUsed() + inMemoryBytes <= memoryBudget.getLimit()) {
+      sort->sorted = keyFn ? input->sortByKey(compareFn, keyFn) : input->sort(compareFn);
+      return sort;
+   }
+   sort->spillFile = SpillFile::create();
+   sort->createRuns();
+   trace.stop();
+   return sort;
+}
+
+void lingodb::runtime::ExternalSort::createRuns() {
+   size_t numWorkers = lingodb::scheduler::getNumWorkers();
+   //the sort state of all runs that are sorted concurrently should stay within half of the budget
+   size_t runElements = std::max(memoryBudget->getLimit() / (2 * numWorkers * getSortBytesPerEntry()), minRunElements);
+   runElements = std::max(runElements, (input->getLen() + maxRuns - 1) / maxRuns);
+   size_t stageBytes = std::max(std::clamp<size_t>(memoryBudget->getLimit() / (4 * numWorkers), 4096, 1 << 20) / typeSize, static_cast<size_t>(1)) * typeSize;
+   std::vector<RunRange> ranges;
+   for (auto buffer : input->getValues().getBuffers()) {
+      for (size_t begin = 0; begin < buffer.numElements; begin += runElements) {
+         ranges.push_back({buffer, begin, std::min(begin + runElements, buffer.numElements)});
+      }
+   }
+   runs.resize(ranges.size());
+   //sorts every range into its own run
+   lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(ranges.size(), [&](size_t runId) {
+      utility::Tracer::Trace trace(createRunEvent);
+      auto& range = ranges[runId];
+      size_t accounted = (range.end - range.begin) * getSortBytesPerEntry() + stageBytes;
+      memoryBudget->allocate(accounted);
+      std::vector<uint8_t*> toSort;
+      toSort.reserve(range.end - range.begin);
+      for (size_t i = range.begin; i < range.end; i++) {
+         toSort.push_back(&range.buffer.ptr[i * typeSize]);
+      }
+      if (keyFn) {
+         radixSortPointers(toSort, compareFn, keyFn);
+      } else {
+         std::sort(toSort.begin(), toSort.end(), compareFn);
+      }
+      std::vector<uint8_t> stage;
+      stage.reserve(stageBytes);
+      for (auto* entry : toSort) {
+         stage.insert(stage.end(), entry, entry + typeSize);
+         if (stage.size() >= stageBytes) {
+            runs[runId].push_back({spillFile->append(stage.data(), stage.size()), stage.size()});
+            stage.clear();
+         }
+      }
+      if (!stage.empty()) {
+         runs[runId].push_back({spillFile->append(stage.data(), stage.size()), stage.size()});
+      }
+      memoryBudget->release(accounted);
+      trace.stop();
+   }));
+   //the entries now live in the spill file
+   input->getValues().clear();
+}
+
+void lingodb::runtime::ExternalSort::merge(void (*forEachChunk)(Buffer, void*), void* contextPtr) {
+   utility::Tracer::Trace trace(mergeEvent);
+   size_t blockBytes = std::max(std::clamp<size_t>(memoryBudget->getLimit() / (2 * std::max<size_t>(runs.size(), 1)), 4096, 1 << 20) / typeSize, static_cast<size_t>(1)) * typeSize;
+   size_t accounted = runs.size() * blockBytes + entriesPerChunk * typeSize;
+   memoryBudget->allocate(accounted);
+   std::vector<std::unique_ptr<RunCursor>> cursors;
+   auto greater = [&](RunCursor* left, RunCursor* right) { return compareFn(right->current(), left->current()); };
+   std::priority_queue<RunCursor*, std::vector<RunCursor*>, decltype(greater)> heap(greater);
+   for (auto& run : runs) {
+      cursors.push_back(std::make_unique<RunCursor>(*spillFile, run, typeSize, blockBytes));
+      if (cursors.back()->isValid()) {
+         heap.push(cursors.back().get());
+      }
+   }
+   //merged entries are copied into a chunk, as the blocks of the cursors are replaced while merging
+   std::vector<uint8_t> chunk(entriesPerChunk * typeSize);
+   size_t chunkBytes = 0;
+   while (!heap.empty()) {
+      auto* cursor = heap.top();
+      heap.pop();
+      memcpy(&chunk[chunkBytes], cursor->current(), typeSize);
+      chunkBytes += typeSize;
+      if (chunkBytes == chunk.size()) {
+         forEachChunk(Buffer{chunkBytes, chunk.data()}, contextPtr);
+         chunkBytes = 0;
+      }
+      cursor->next();
+      if (cursor->isValid()) {
+         heap.push(cursor);
+      }
+   }
+   if (chunkBytes) {
+      forEachChunk(Buffer{chunkBytes, chunk.data()}, contextPtr);
+   }
+   memoryBudget->release(accounted);
+   trace.stop();
+}
+
+void lingodb::runtime::ExternalSort::scanRunsParallel(void (*forEachChunk)(Buffer, void*), void* contextPtr) {
+   //every run is read segment by segment, as the order does not matter there is no need to merge
+   lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(runs.size(), [&](size_t runId) {
+      size_t maxSegmentBytes = 0;
+      for (auto segment : runs[runId]) {
+         maxSegmentBytes = std::max(maxSegmentBytes, segment.len);
+      }
+      memoryBudget->allocate(maxSegmentBytes);
+      std::vector<uint8_t> data;
+      data.reserve(maxSegmentBytes);
+      for (auto segment : runs[runId]) {
+         data.resize(segment.len);
+         spillFile->read(segment.offset, data.data(), segment.len);
+         forEachChunk(Buffer{segment.len, data.data()}, contextPtr);
+      }
+      memoryBudget->release(maxSegmentBytes);
+   }));
+}
+
+lingodb::runtime::BufferIterator* lingodb::runtime::ExternalSort::createIterator(ExternalSort* sort) {
+   return new ExternalSortIterator(*sort);
+}
@@ -0,0 +1,462 @@
+#include "lingodb/runtime/GraceHashJoin.h"
+#include "lingodb/runtime/ExecutionContext.h"
+#include "lingodb/runtime/GrowingBuffer.h"
+#include "lingodb/scheduler/Tasks.h"
+#include "lingodb/utility/Setting.h"
+#include "lingodb/utility/Tracer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+
+namespace {
+//number of partitions used once the build side has to be spilled (0: derive from the budget and the number of workers)
+lingodb::utility::GlobalSetting<int64_t> graceJoinPartitions("system.grace_join.partitions", 0);
+//target size of a build partition if the join stays in memory, should fit into the L2 cache (0: never partition in memory)
+lingodb::utility::GlobalSetting<int64_t> graceJoinCachePartitionBytes("system.grace_join.cache_partition_bytes", 1 << 18);
+//build the hash tables over the input that turned out to be smaller, instead of the one chosen at compile time from estimates
+lingodb::utility::GlobalSetting<bool> graceJoinAdaptiveSides("system.grace_join.adaptive_sides", true);
+static lingodb::utility::Tracer::Event createEvent("GraceHashJoin", "create");
+static lingodb::utility::Tracer::Event partitionEvent("GraceHashJoin", "partition");
+static lingodb::utility::Tracer::Event partitionInMemoryEvent("GraceHashJoin", "partitionInMemory");
+static lingodb::utility::Tracer::Event joinPartitionEvent("GraceHashJoin", "joinPartition");
+
+//upper bound of the fan-out of a single partitioning pass: with more partitions, the scatter writes to more pages than the TLB covers
+//build sides above maxPartitions * cache_partition_bytes therefore get partitions above the target size instead of a second pass
+constexpr size_t maxPartitions = 1024;
+constexpr size_t matchesPerChunk = 1024;
+//number of probe entries whose buckets are prefetched together before their chains are walked
+constexpr size_t probeGroupSize = 16;
+
+size_t getHash(uint8_t* entry) {
+   return *reinterpret_cast<size_t*>(entry);
+}
+
+//chained hash table over the entries of the build side, links are stored next to the table instead of inside the entries
+//Index is the type of the links: 32 bit links keep the table small, 64 bit links are only needed for build sides with more than 2^32-1 entries
+template <class Index>
+class LocalTable {
+   std::vector<uint8_t*> entries;
+   std::vector<Index> heads;
+   std::vector<Index> next;
+   size_t mask;
+
+   public:
+   explicit LocalTable(size_t numEntries) : heads(std::bit_ceil(std::max<size_t>(numEntries * 2, 2)), 0), mask(heads.size() - 1) {
+      entries.reserve(numEntries);
+      next.reserve(numEntries);
+   }
+   static size_t getBytes(size_t numEntries) {
+      return std::bit_ceil(std::max<size_t>(numEntries * 2, 2)) * sizeof(Index) + numEntries * (sizeof(uint8_t*) + sizeof(Index));
+   }
+   void insert(uint8_t* entry) {
+      auto& head = heads[getHash(entry) & mask];
+      entries.push_back(entry);
+      next.push_back(head);
+      head = entries.size();
+   }
+   //probes count entries (stride bytes apart) in groups: the heads of a whole group are prefetched, then the first chain entries, and only then the chains are walked
+   //this overlaps the cache misses of independent probes instead of paying for them one after another
+   template <class Fn>
+   void lookupBatch(uint8_t* probeEntries, size_t count, size_t stride, const Fn& fn) {
+      size_t hashes[probeGroupSize];
+      Index firsts[probeGroupSize];
+      for (size_t groupStart = 0; groupStart < count; groupStart += probeGroupSize) {
+         size_t groupSize = std::min(probeGroupSize, count - groupStart);
+         for (size_t i = 0; i < groupSize; i++) {
+            hashes[i] = getHash(&probeEntries[(groupStart + i) * stride]);
+            __builtin_prefetch(&heads[hashes[i] & mask]);
+         }
+         for (size_t i = 0; i < groupSize; i++) {
+            firsts[i] = heads[hashes[i] & mask];
+            if (firsts[i]) {
+               __builtin_prefetch(entries[firsts[i] - 1]);
+            }
+         }
+         for (size_t i = 0; i < groupSize; i++) {
+            auto* probeEntry = &probeEntries[(groupStart + i) * stride];
+            for (Index pos = firsts[i]; pos; pos = next[pos - 1]) {
+               auto* entry = entries[pos - 1];
+               if (getHash(entry) == hashes[i]) {
+                  fn(entry, probeEntry);
+               }
+            }
+         }
+      }
+   }
+};
+//positions are stored +1 (0 terminates a chain), so a 32 bit table holds at most 2^32-2 entries
+bool needsWideTable(size_t numEntries) {
+   return numEntries >= std::numeric_limits<uint32_t>::max();
+}
+size_t getTableBytes(size_t numEntries) {
+   return needsWideTable(numEntries) ? LocalTable<uint64_t>::getBytes(numEntries) : LocalTable<uint32_t>::getBytes(numEntries);
+}
+//calls fn with an empty table for numEntries entries, using the narrowest links that can address all of them
+template <class Fn>
+void withLocalTable(size_t numEntries, const Fn& fn) {
+   if (needsWideTable(numEntries)) {
+      LocalTable<uint64_t> table(numEntries);
+      fn(table);
+   } else {
+      LocalTable<uint32_t> table(numEntries);
+      fn(table);
+   }
+}
+
+//collects matching pairs and hands them to the consuming pipeline in chunks
+class MatchEmitter {
+   std::vector<std::pair<uint8_t*, uint8_t*>> matches;
+   void (*forEachChunk)(lingodb::runtime::Buffer, void*);
+   void* contextPtr;
+   bool swapped;
+
+   public:
+   MatchEmitter(void (*forEachChunk)(lingodb::runtime::Buffer, void*), void* contextPtr, bool swapped) : forEachChunk(forEachChunk), contextPtr(contextPtr), swapped(swapped) {
+      matches.reserve(matchesPerChunk);
+   }
+   void emit(uint8_t* buildEntry, uint8_t* probeEntry) {
+      if (swapped) {
+         matches.push_back({probeEntry, buildEntry});
+      } else {
+         matches.push_back({buildEntry, probeEntry});
+      }
+      if (matches.size() == matchesPerChunk) {
+         flush();
+      }
+   }
+   void flush() {
+      if (!matches.empty()) {
+         forEachChunk(lingodb::runtime::Buffer{matches.size() * sizeof(std::pair<uint8_t*, uint8_t*>), reinterpret_cast<uint8_t*>(matches.data())}, contextPtr);
+         matches.clear();
+      }
+   }
+};
+} // end namespace
+
+namespace lingodb::runtime {
+class GraceHashJoinIterator : public BufferIterator {
+   using Match = std::pair<uint8_t*, uint8_t*>;
+   GraceHashJoin& join;
+   //the sequential interface produces the matches of one partition at a time (all matches at once if the join is not partitioned)
+   size_t nextPartition;
+   std::vector<Match> matches;
+   //a partition loaded from the spill file is released after the join, so its matching entries are copied here
+   std::vector<uint8_t> copies;
+   size_t accountedBytes;
+
+   void collect(Buffer buffer) {
+      auto* chunk = reinterpret_cast<Match*>(buffer.ptr);
+      size_t numMatches = buffer.numElements / sizeof(Match);
+      if (!join.spillFile) {
+         matches.insert(matches.end(), chunk, chunk + numMatches);
+         return;
+      }
+      size_t firstSize = join.swapped ? join.probeTypeSize : join.buildTypeSize;
+      size_t secondSize = join.swapped ? join.buildTypeSize : join.probeTypeSize;
+      for (size_t i = 0; i < numMatches; i++) {
+         copies.insert(copies.end(), chunk[i].first, chunk[i].first + firstSize);
+         copies.insert(copies.end(), chunk[i].second, chunk[i].second + secondSize);
+      }
+   }
+   void loadNextPartition() {
+      matches.clear();
+      copies.clear();
+      size_t numPartitions = std::max<size_t>(join.numPartitions, 1);
+      auto collectChunk = [](Buffer buffer, void* contextPtr) { reinterpret_cast<GraceHashJoinIterator*>(contextPtr)->collect(buffer); };
+      while (matches.empty() && copies.empty() && nextPartition < numPartitions) {
+         size_t partition = nextPartition++;
+         if (!join.numPartitions) {
+            join.joinInMemory(false, collectChunk, this);
+         } else if (join.spillFile) {
+            join.joinPartition(partition, collectChunk, this);
+         } else {
+            join.joinCachePartition(partition, collectChunk, this);
+         }
+      }
+      if (!copies.empty()) {
+         //the copies are only complete now, so the matches can point into them
+         size_t firstSize = join.swapped ? join.probeTypeSize : join.buildTypeSize;
+         size_t stride = join.buildTypeSize + join.probeTypeSize;
+         for (size_t offset = 0; offset < copies.size(); offset += stride) {
+            matches.push_back({&copies[offset], &copies[offset + firstSize]});
+         }
+      }
+      size_t bytes = copies.capacity() + matches.capacity() * sizeof(Match);
+      join.memoryBudget->allocate(bytes);
+      join.memoryBudget->release(accountedBytes);
+      accountedBytes = bytes;
+   }
+
+   public:
+   GraceHashJoinIterator(GraceHashJoin& join) : join(join), nextPartition(0), accountedBytes(0) {}
+   bool isValid() override {
+      if (matches.empty() && nextPartition == 0) {
+         loadNextPartition();
+      }
+      return !matches.empty();
+   }
+   void next() override {
+      loadNextPartition();
+   }
+   Buffer getCurrentBuffer() override {
+      return Buffer{matches.size() * sizeof(Match), reinterpret_cast<uint8_t*>(matches.data())};
+   }
+   void iterateEfficient(bool parallel, void (*forEachChunk)(Buffer, void*), void* contextPtr) override {
+      if (!join.numPartitions) {
+         join.joinInMemory(parallel, forEachChunk, contextPtr);
+         return;
+      }
+      auto joinPartition = [&](size_t partition) {
+         if (join.spillFile) {
+            join.joinPartition(partition, forEachChunk, contextPtr);
+         } else {
+            join.joinCachePartition(partition, forEachChunk, contextPtr);
+         }
+      };
+      if (parallel) {
+         lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(join.numPartitions, joinPartition));
+      } else {
+         for (size_t i = 0; i < join.numPartitions; i++) {
+            joinPartition(i);
+         }
+      }
+   }
+   ~GraceHashJoinIterator() {
+      join.memoryBudget->release(accountedBytes);
+   }
+};
+} // end namespace lingodb::runtime
+
+lingodb::runtime::GraceHashJoin::GraceHashJoin(GrowingBuffer* build, GrowingBuffer* probe, MemoryBudget* memoryBudget, bool swapped) : build(build), probe(probe), buildTypeSize(build->getTypeSize()), probeTypeSize(probe->getTypeSize()), memoryBudget(memoryBudget), swapped(swapped), numPartitions(0), partitionShift(0), partitionBytes(0) {}
+lingodb::runtime::GraceHashJoin::~GraceHashJoin() {
+   memoryBudget->release(partitionBytes);
+}
+
+lingodb::runtime::GraceHashJoin* lingodb::runtime::GraceHashJoin::create(GrowingBuffer* build, GrowingBuffer* probe) {
+   utility::Tracer::Trace trace(createEvent);
+   auto* executionContext = runtime::getCurrentExecutionContext();
+   auto& memoryBudget = executionContext->getMemoryBudget();
+   //both inputs are fully materialized, so the actual sizes can correct a wrong estimate
+   auto tableBytes = [](GrowingBuffer* input) { return input->getLen() * input->getTypeSize() + getTableBytes(input->getLen()); };
+   bool swapped = graceJoinAdaptiveSides.getValue() && tableBytes(probe) < tableBytes(build);
+   if (swapped) {
+      std::swap(build, probe);
+   }
+   auto* join = new GraceHashJoin(build, probe, &memoryBudget, swapped);
+   executionContext->registerState({join, [](void* ptr) { delete reinterpret_cast<GraceHashJoin*>(ptr); }});
+   size_t buildBytes = build->getLen() * join->buildTypeSize + getTableBytes(build->getLen());
+   if (!memoryBudget.getLimit() || memoryBudget.getUsed() + buildBytes <= memoryBudget.getLimit()) {
+      //a build side that exceeds the cache is radix-partitioned in memory, so that every partition is built and probed while it is cache resident
+      size_t cachePartitionBytes = graceJoinCachePartitionBytes.getValue();
+      size_t copyBytes = build->getLen() * join->buildTypeSize + probe->getLen() * join->probeTypeSize;
+      if (cachePartitionBytes && buildBytes > cachePartitionBytes && (!memoryBudget.getLimit() || memoryBudget.getUsed() + buildBytes + copyBytes <= memoryBudget.getLimit())) {
+         size_t numPartitions = std::clamp<size_t>(std::bit_ceil((buildBytes + cachePartitionBytes - 1) / cachePartitionBytes), 2, maxPartitions);
+         join->numPartitions = numPartitions;
+         join->partitionShift = 64 - std::countr_zero(numPartitions);
+         join->partitionInMemory(build, join->buildPartitions);
+         join->partitionInMemory(probe, join->probePartitions);
+      }
+      return join;
+   }
+   size_t numPartitions = graceJoinPartitions.getValue();
+   if (!numPartitions) {
+      //every partition of the build side should use at most half of the budget, and every worker should get some partitions
+      size_t budgetPartitions = (2 * buildBytes + memoryBudget.getLimit() - 1) / memoryBudget.getLimit();
+      numPartitions = std::max(budgetPartitions, 2 * lingodb::scheduler::getNumWorkers());
+   }
+   numPartitions = std::clamp<size_t>(std::bit_ceil(numPartitions), 2, maxPartitions);
+   join->numPartitions = numPartitions;
+   join->partitionShift = 64 - std::countr_zero(numPartitions);
+   join->spillFile = SpillFile::create();
+   join->partition(build, join->buildSegments);
+   join->partition(probe, join->probeSegments);
+   trace.stop();
+   return join;
+}
+
+void lingodb::runtime::GraceHashJoin::partition(GrowingBuffer* input, std::vector<std::vector<Segment>>& segments) {
+   utility::Tracer::Trace trace(partitionEvent);
+   size_t typeSize = input->getTypeSize();
+   size_t numWorkers = lingodb::scheduler::getNumWorkers();
+   //the staging area of all workers should stay well below the budget
+   size_t stageBytes = std::clamp<size_t>(memoryBudget->getLimit() / (4 * numWorkers * numPartitions), 4096, 65536);
+   stageBytes = std::max(stageBytes / typeSize, static_cast<size_t>(1)) * typeSize;
+   //every worker may fill a staging area for every partition
+   size_t accounted = numWorkers * numPartitions * stageBytes;
+   memoryBudget->allocate(accounted);
+   std::vector<std::vector<std::vector<uint8_t>>> staging(numWorkers);
+   std::vector<std::vector<std::vector<Segment>>> workerSegments(numWorkers);
+   auto flush = [&](size_t worker, size_t partition) {
+      auto& stage = staging[worker][partition];
+      if (!stage.empty()) {
+         workerSegments[worker][partition].push_back({spillFile->append(stage.data(), stage.size()), stage.size()});
+         stage.clear();
+      }
+   };
+   input->getValues().iterateBuffersParallel([&](Buffer buffer) {
+      size_t worker = lingodb::scheduler::currentWorkerId();
+      if (staging[worker].empty()) {
+         staging[worker].resize(numPartitions);
+         for (auto& stage : staging[worker]) {
+            stage.reserve(stageBytes);
+         }
+         workerSegments[worker].resize(numPartitions);
+      }
+      for (size_t i = 0; i < buffer.numElements; i++) {
+         auto* entry = &buffer.ptr[i * typeSize];
+         size_t partition = getHash(entry) >> partitionShift;
+         auto& stage = staging[worker][partition];
+         stage.insert(stage.end(), entry, entry + typeSize);
+         if (stage.size() >= stageBytes) {
+            flush(worker, partition);
+         }
+      }
+   });
+   segments.resize(numPartitions);
+   for (size_t worker = 0; worker < numWorkers; worker++) {
+      for (size_t partition = 0; partition < staging[worker].size(); partition++) {
+         flush(worker, partition);
+         auto& local = workerSegments[worker][partition];
+         segments[partition].insert(segments[partition].end(), local.begin(), local.end());
+      }
+   }
+   memoryBudget->release(accounted);
+   //the entries now live in the spill file
+   input->getValues().clear();
+}
+
+void lingodb::runtime::GraceHashJoin::partitionInMemory(GrowingBuffer* input, MemoryPartitions& partitions) {
+   utility::Tracer::Trace trace(partitionInMemoryEvent);
+   size_t typeSize = input->getTypeSize();
+   auto buffers = input->getValues().getBuffers();
+   //first pass: count the entries of every partition per buffer
+   std::vector<std::vector<size_t>> histograms(buffers.size());
+   lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(buffers.size(), [&](size_t bufferId) {
+      auto& histogram = histograms[bufferId];
+      histogram.resize(numPartitions, 0);
+      auto buffer = buffers[bufferId];
+      for (size_t i = 0; i < buffer.numElements; i++) {
+         histogram[getHash(&buffer.ptr[i * typeSize]) >> partitionShift]++;
+      }
+   }));
+   //every buffer gets its own range inside every partition, the histograms are turned into the write positions of these ranges
+   partitions.offsets.assign(numPartitions + 1, 0);
+   size_t offset = 0;
+   for (size_t partition = 0; partition < numPartitions; partition++) {
+      partitions.offsets[partition] = offset;
+      for (auto& histogram : histograms) {
+         size_t count = histogram[partition];
+         histogram[partition] = offset;
+         offset += count;
+      }
+   }
+   partitions.offsets[numPartitions] = offset;
+   //the partitions are charged until the join is destroyed
+   memoryBudget->allocate(offset * typeSize);
+   partitionBytes += offset * typeSize;
+   partitions.data = std::make_unique_for_overwrite<uint8_t[]>(offset * typeSize);
+   //second pass: scatter the entries, without any synchronization as the ranges are disjoint
+   lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(buffers.size(), [&](size_t bufferId) {
+      auto& positions = histograms[bufferId];
+      auto buffer = buffers[bufferId];
+      for (size_t i = 0; i < buffer.numElements; i++) {
+         auto* entry = &buffer.ptr[i * typeSize];
+         memcpy(&partitions.data[positions[getHash(entry) >> partitionShift]++ * typeSize], entry, typeSize);
+      }
+   }));
+   //the entries now live in the partitions
+   input->getValues().clear();
+   trace.stop();
+}
+
+void lingodb::runtime::GraceHashJoin::joinCachePartition(size_t partition, void (*forEachChunk)(Buffer, void*), void* contextPtr) {
+   size_t buildBegin = buildPartitions.offsets[partition];
+   size_t numBuildEntries = buildPartitions.offsets[partition + 1] - buildBegin;
+   if (!numBuildEntries) {
+      return;
+   }
+   size_t tableBytes = getTableBytes(numBuildEntries);
+   memoryBudget->allocate(tableBytes);
+   withLocalTable(numBuildEntries, [&](auto& table) {
+      for (size_t i = 0; i < numBuildEntries; i++) {
+         table.insert(&buildPartitions.data[(buildBegin + i) * buildTypeSize]);
+      }
+      size_t probeBegin = probePartitions.offsets[partition];
+      size_t numProbeEntries = probePartitions.offsets[partition + 1] - probeBegin;
+      MatchEmitter emitter(forEachChunk, contextPtr, swapped);
+      table.lookupBatch(&probePartitions.data[probeBegin * probeTypeSize], numProbeEntries, probeTypeSize, [&](uint8_t* buildEntry, uint8_t* probeEntry) { emitter.emit(buildEntry, probeEntry); });
+      emitter.flush();
+   });
+   memoryBudget->release(tableBytes);
+}
+
+void lingodb::runtime::GraceHashJoin::joinInMemory(bool parallel, void (*forEachChunk)(Buffer, void*), void* contextPtr) {
+   size_t tableBytes = getTableBytes(build->getLen());
+   memoryBudget->allocate(tableBytes);
+   withLocalTable(build->getLen(), [&](auto& table) {
+      build->getValues().iterate([&](uint8_t* entry) {
+         table.insert(entry);
+      });
+      auto probeChunk = [&](Buffer buffer) {
+         MatchEmitter emitter(forEachChunk, contextPtr, swapped);
+         table.lookupBatch(buffer.ptr, buffer.numElements, probeTypeSize, [&](uint8_t* buildEntry, uint8_t* probeEntry) { emitter.emit(buildEntry, probeEntry); });
+         emitter.flush();
+      };
+      if (parallel) {
+         probe->getValues().iterateBuffersParallel(probeChunk);
+      } else {
+         for (auto buffer : probe->getValues().getBuffers()) {
+            probeChunk(buffer);
+         }
+      }
+   });
+   memoryBudget->release(tableBytes);
+}
+
+void lingodb::runtime::GraceHashJoin::joinPartition(size_t partition, void (*forEachChunk)(Buffer, void*), void* contextPtr) {
+   utility::Tracer::Trace trace(joinPartitionEvent);
+   size_t buildBytes = 0;
+   for (auto segment : buildSegments[partition]) {
+      buildBytes += segment.len;
+   }
+   if (!buildBytes) {
+      return;
+   }
+   size_t numBuildEntries = buildBytes / buildTypeSize;
+   size_t maxProbeBytes = 0;
+   for (auto segment : probeSegments[partition]) {
+      maxProbeBytes = std::max(maxProbeBytes, segment.len);
+   }
+   //the build side, its table and the largest probe segment are held at the same time
+   size_t accounted = buildBytes + getTableBytes(numBuildEntries) + maxProbeBytes;
+   memoryBudget->allocate(accounted);
+   std::vector<uint8_t> buildData(buildBytes);
+   size_t loaded = 0;
+   for (auto segment : buildSegments[partition]) {
+      spillFile->read(segment.offset, &buildData[loaded], segment.len);
+      loaded += segment.len;
+   }
+   withLocalTable(numBuildEntries, [&](auto& table) {
+      for (size_t i = 0; i < numBuildEntries; i++) {
+         table.insert(&buildData[i * buildTypeSize]);
+      }
+      //the probe side is streamed segment by segment, matches have to be consumed before the segment is replaced
+      std::vector<uint8_t> probeData;
+      probeData.reserve(maxProbeBytes);
+      MatchEmitter emitter(forEachChunk, contextPtr, swapped);
+      for (auto segment : probeSegments[partition]) {
+         probeData.resize(segment.len);
+         spillFile->read(segment.offset, probeData.data(), segment.len);
+         table.lookupBatch(probeData.data(), segment.len / probeTypeSize, probeTypeSize, [&](uint8_t* buildEntry, uint8_t* probeEntry) { emitter.emit(buildEntry, probeEntry); });
+         emitter.flush();
+      }
+   });
+   memoryBudget->release(accounted);
+   trace.stop();
+}
+
+lingodb::runtime::BufferIterator* lingodb::runtime::GraceHashJoin::createIterator(GraceHashJoin* join) {
+   return new GraceHashJoinIterator(*join);
+}
@@ -41,7 +41,7 @@ class GroupAllocator : public lingodb::runtime::GrowingBufferAllocator {
 
 lingodb::runtime::GrowingBuffer* lingodb::runtime::GrowingBuffer::create(lingodb::runtime::GrowingBufferAllocator* allocator, size_t sizeOfType, size_t initialCapacity) {
    lingodb::runtime::ExecutionContext* executionContext = runtime::getCurrentExecutionContext();
-   return allocator->create(executionContext, sizeOfType, initialCapacity);
+   return allocator->create(executionContext, sizeOfType, clampInitialCapacity(initialCapacity, sizeOfType));
 }
 
 uint8_t* lingodb::runtime::GrowingBuffer::insert() {
@@ -79,6 +79,12 @@ lingodb::runtime::Buffer lingodb::runtime::GrowingBuffer::sort(bool (*compareFn)
 
    return Buffer{typeSize * len, sorted};
 }
+lingodb::runtime::Buffer lingodb::runtime::GrowingBuffer::sortByKey(bool (*compareFn)(uint8_t*, uint8_t*), uint64_t (*keyFn)(uint8_t*)) {
+   utility::Tracer::Trace trace(sortEvent);
+   lingodb::runtime::Buffer result = radixSort(values, compareFn, keyFn);
+   trace.stop();
+   return result;
+}
 lingodb::runtime::Buffer lingodb::runtime::GrowingBuffer::asContinuous() {
    auto* executionContext = runtime::getCurrentExecutionContext();
    //todo make more performant...
@@ -102,15 +108,9 @@ void lingodb::runtime::GrowingBuffer::destroy(GrowingBuffer* vec) {
 
 lingodb::runtime::GrowingBuffer* lingodb::runtime::GrowingBuffer::merge(lingodb::runtime::ThreadLocal* threadLocal) {
    utility::Tracer::Trace trace(mergeEvent);
-   GrowingBuffer* first = nullptr;
-   for (auto* current : threadLocal->getThreadLocalValues<GrowingBuffer>()) {
-      if (!current) continue;
-      if (!first) {
-         first = current;
-      } else {
-         first->values.merge(current->values); //todo: cleanup
-      }
-   }
+   auto* first = threadLocal->reduce<GrowingBuffer>([](GrowingBuffer* first, GrowingBuffer* current) {
+      first->values.merge(current->values); //todo: cleanup
+   });
    trace.stop();
    return first;
 }
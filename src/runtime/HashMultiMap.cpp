@@ -1,8 +1,10 @@
 #include "lingodb/runtime/HashMultiMap.h"
 
+#include <bit>
+
 lingodb::runtime::HashMultiMap* lingodb::runtime::HashMultiMap::create(size_t entryTypeSize, size_t valueTypeSize, size_t initialCapacity) {
    lingodb::runtime::ExecutionContext* executionContext = runtime::getCurrentExecutionContext();
-   auto* hmm = new HashMultiMap(initialCapacity, entryTypeSize, valueTypeSize);
+   auto* hmm = new HashMultiMap(std::bit_ceil(clampInitialCapacity(initialCapacity, entryTypeSize)), entryTypeSize, valueTypeSize);
    executionContext->registerState({hmm, [](void* ptr) { delete reinterpret_cast<lingodb::runtime::HashMultiMap*>(ptr); }});
    return hmm;
 }
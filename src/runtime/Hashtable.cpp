@@ -1,15 +1,23 @@
 #include "lingodb/runtime/Hashtable.h"
+#include "lingodb/scheduler/Tasks.h"
 #include "lingodb/utility/Tracer.h"
+#include <algorithm>
 #include <atomic>
+#include <bit>
 #include <cstring>
 #include <iostream>
+#include <mutex>
 
 namespace {
 static lingodb::utility::Tracer::Event mergeEvent("Hashtable", "merge");
+static lingodb::utility::Tracer::Event mergeScatterEvent("Hashtable", "mergeScatter");
+static lingodb::utility::Tracer::Event mergePartitionEvent("Hashtable", "mergePartition");
+//below this number of entries, the thread-local tables are merged pairwise
+constexpr size_t minPartitionedMergeEntries = 1 << 15;
 } // end namespace
 lingodb::runtime::Hashtable* lingodb::runtime::Hashtable::create(size_t typeSize, size_t initialCapacity) {
    lingodb::runtime::ExecutionContext* executionContext = runtime::getCurrentExecutionContext();
-   auto* ht = new Hashtable(initialCapacity, typeSize);
+   auto* ht = new Hashtable(std::bit_ceil(clampInitialCapacity(initialCapacity, typeSize)), typeSize);
    executionContext->registerState({ht, [](void* ptr) { delete reinterpret_cast<lingodb::runtime::Hashtable*>(ptr); }});
    return ht;
 }
@@ -48,16 +56,80 @@ lingodb::runtime::BufferIterator* lingodb::runtime::Hashtable::createIterator()
 
 lingodb::runtime::Hashtable* lingodb::runtime::Hashtable::merge(lingodb::runtime::ThreadLocal* threadLocal, bool (*isEq)(uint8_t*, uint8_t*), void (*merge)(uint8_t*, uint8_t*)) {
    utility::Tracer::Trace mergeHt(mergeEvent);
-   lingodb::runtime::Hashtable* first = nullptr;
-   for (auto* current : threadLocal->getThreadLocalValues<lingodb::runtime::Hashtable>()) {
-      if (!current) continue;
-      if (!first) {
-         first = current;
-      } else {
-         first->mergeEntries(isEq, merge, current);
+   std::vector<Hashtable*> tables;
+   size_t totalEntries = 0;
+   for (auto* table : threadLocal->getThreadLocalValues<Hashtable>()) {
+      if (table) {
+         tables.push_back(table);
+         totalEntries += table->values.getLen();
       }
    }
-   return first;
+   if (tables.size() <= 1 || totalEntries < minPartitionedMergeEntries) {
+      return threadLocal->reduce<lingodb::runtime::Hashtable>([&](lingodb::runtime::Hashtable* first, lingodb::runtime::Hashtable* current) {
+         first->mergeEntries(isEq, merge, current);
+      });
+   }
+   auto* executionContext = runtime::getCurrentExecutionContext();
+   size_t typeSize = tables[0]->typeSize;
+   //every group is an entry of at least one table: the merged table never has to be resized
+   size_t htSize = 2 * std::bit_ceil(totalEntries);
+   //the highest bits of the slot select the partition: every partition owns a contiguous range of slots and is merged without synchronization or false sharing
+   size_t numPartitions = std::min(std::clamp<size_t>(std::bit_ceil(4 * lingodb::scheduler::getNumWorkers()), 16, 1024), htSize);
+   size_t partitionShift = std::countr_zero(htSize) - std::countr_zero(numPartitions);
+   auto* res = new Hashtable(1, typeSize);
+   executionContext->registerState({res, [](void* ptr) { delete reinterpret_cast<lingodb::runtime::Hashtable*>(ptr); }});
+   res->ht.setNewSize(htSize);
+   res->hashMask = htSize - 1;
+
+   //entries of table t and partition p are in scattered[t * numPartitions + p]
+   std::vector<std::vector<Entry*>> scattered(tables.size() * numPartitions);
+   lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(tables.size(), [&](size_t tableId) {
+      utility::Tracer::Trace trace(mergeScatterEvent);
+      tables[tableId]->values.iterate([&](uint8_t* entryRawPtr) {
+         auto* entry = reinterpret_cast<Entry*>(entryRawPtr);
+         scattered[tableId * numPartitions + ((entry->hashValue & (htSize - 1)) >> partitionShift)].push_back(entry);
+      });
+      trace.stop();
+   }));
+   std::mutex mutex;
+   lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(numPartitions, [&](size_t partition) {
+      utility::Tracer::Trace trace(mergePartitionEvent);
+      size_t maxEntries = 0;
+      for (size_t tableId = 0; tableId < tables.size(); tableId++) {
+         maxEntries = std::max(maxEntries, scattered[tableId * numPartitions + partition].size());
+      }
+      FlexibleBuffer localValues(std::max<size_t>(maxEntries, 1), typeSize);
+      //tables are merged in order, i.e., merge is always called with an entry of a preceding table first
+      for (size_t tableId = 0; tableId < tables.size(); tableId++) {
+         auto& entries = scattered[tableId * numPartitions + partition];
+         for (auto* otherEntry : entries) {
+            auto otherHash = otherEntry->hashValue;
+            auto pos = otherHash & res->hashMask;
+            auto* candidate = lingodb::runtime::filterTagged(res->ht.at(pos), otherHash);
+            bool matchFound = false;
+            while (candidate) {
+               if (candidate->hashValue == otherHash && isEq(candidate->content, otherEntry->content)) {
+                  merge(candidate->content, otherEntry->content);
+                  matchFound = true;
+                  break;
+               }
+               candidate = candidate->next;
+            }
+            if (!matchFound) {
+               auto* newEntry = reinterpret_cast<Entry*>(localValues.insert());
+               std::memcpy(newEntry, otherEntry, typeSize);
+               auto* previousPtr = res->ht.at(pos);
+               res->ht.at(pos) = lingodb::runtime::tag(newEntry, previousPtr, otherHash);
+               newEntry->next = lingodb::runtime::untag(previousPtr);
+            }
+         }
+         std::vector<Entry*>().swap(entries);
+      }
+      std::unique_lock<std::mutex> lock(mutex);
+      res->values.merge(localValues);
+      trace.stop();
+   }));
+   return res;
 }
 void lingodb::runtime::Hashtable::mergeEntries(bool (*isEq)(uint8_t*, uint8_t*), void (*merge)(uint8_t*, uint8_t*), lingodb::runtime::Hashtable* other) {
    utility::Tracer::Trace trace(mergeEvent);
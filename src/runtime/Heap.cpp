@@ -3,6 +3,8 @@
 #include <cstring>
 namespace {
 lingodb::utility::Tracer::Event mergeHeapEvent("Heap", "merge");
+//a full heap publishes its root again only after this many replacements, which bounds the number of published copies
+constexpr size_t publishInterval = 64;
 } //end namespace
 
 void lingodb::runtime::Heap::bubbleDown(size_t idx, size_t end) {
@@ -24,24 +26,76 @@ void lingodb::runtime::Heap::buildHeap() {
    }
 }
 
+bool lingodb::runtime::Heap::passesThreshold(uint8_t* currData) {
+   auto* bound = threshold->bound.load(std::memory_order_acquire);
+   return !bound || cmpFn(currData, bound->value);
+}
+void lingodb::runtime::Heap::publishThreshold() {
+   unpublished = 0;
+   auto* root = entry(slots[1]);
+   auto* current = threshold->bound.load(std::memory_order_acquire);
+   if (current && !cmpFn(root, current->value)) {
+      //another heap already published a tighter bound
+      return;
+   }
+   auto* bound = static_cast<HeapThreshold::Bound*>(malloc(sizeof(HeapThreshold::Bound) + typeSize));
+   memcpy(bound->value, root, typeSize);
+   //atomic minimum: retry until the bound is installed or a tighter one was published concurrently
+   do {
+      if (current && !cmpFn(root, current->value)) {
+         free(bound);
+         return;
+      }
+      bound->previous = current;
+   } while (!threshold->bound.compare_exchange_weak(current, bound, std::memory_order_release, std::memory_order_acquire));
+}
+
 void lingodb::runtime::Heap::insert(uint8_t* currData) {
+   if (threshold && !passesThreshold(currData)) {
+      return;
+   }
+   add(currData);
+}
+void lingodb::runtime::Heap::add(uint8_t* currData) {
+   if (!maxElements) {
+      return;
+   }
    if (currElements < maxElements) {
-      memcpy(&data[typeSize * (currElements + 1)], currData, typeSize);
+      memcpy(entry(currElements), currData, typeSize);
+      slots[currElements + 1] = currElements;
       currElements++;
       if (currElements == maxElements) {
          buildHeap();
+         if (threshold) {
+            publishThreshold();
+         }
       }
       return;
    }
-   auto* lastData = &data[typeSize];
+   auto* lastData = entry(slots[1]);
    if (cmpFn(currData, lastData)) {
-      memcpy(&data[typeSize], currData, typeSize);
+      memcpy(lastData, currData, typeSize);
       bubbleDown(1, currElements);
+      if (threshold && ++unpublished == publishInterval) {
+         publishThreshold();
+      }
+   }
+}
+bool lingodb::runtime::Heap::isCandidate(uint8_t* currData) {
+   if (!maxElements || (threshold && !passesThreshold(currData))) {
+      return false;
    }
+   return currElements < maxElements || cmpFn(currData, entry(slots[1]));
 }
 lingodb::runtime::Heap* lingodb::runtime::Heap::create(size_t maxElements, size_t typeSize, bool (*cmpFn)(unsigned char*, unsigned char*)) {
    auto* executionContext = runtime::getCurrentExecutionContext();
-   auto* heap = new Heap(maxElements, typeSize, cmpFn);
+   auto* heap = new Heap(maxElements, typeSize, cmpFn, nullptr);
+   executionContext->registerState({heap, [](void* ptr) { delete reinterpret_cast<Heap*>(ptr); }});
+   return heap;
+}
+lingodb::runtime::Heap* lingodb::runtime::Heap::createShared(size_t maxElements, size_t typeSize, bool (*cmpFn)(unsigned char*, unsigned char*), ThreadLocal* threadLocal) {
+   auto* executionContext = runtime::getCurrentExecutionContext();
+   auto* heap = new Heap(maxElements, typeSize, cmpFn, threadLocal->getShared<HeapThreshold>());
    executionContext->registerState({heap, [](void* ptr) { delete reinterpret_cast<Heap*>(ptr); }});
    return heap;
 }
@@ -53,8 +107,33 @@ lingodb::runtime::Buffer lingodb::runtime::Heap::getBuffer() {
       swap(1, currElements - i);
       bubbleDown(1, currElements - i - 1);
    }
+   //slots are now sorted, move the entries into the same order by following the cycles of the permutation
+   std::vector<uint8_t> tmp(typeSize);
+   for (size_t i = 0; i < currElements; i++) {
+      if (slots[i + 1] == i) continue;
+      memcpy(tmp.data(), entry(i), typeSize);
+      size_t curr = i;
+      while (slots[curr + 1] != i) {
+         size_t next = slots[curr + 1];
+         memcpy(entry(curr), entry(next), typeSize);
+         slots[curr + 1] = curr;
+         curr = next;
+      }
+      memcpy(entry(curr), tmp.data(), typeSize);
+      slots[curr + 1] = curr;
+   }
 
-   return lingodb::runtime::Buffer{currElements * std::max(1ul, typeSize), &data[typeSize]};
+   return lingodb::runtime::Buffer{currElements * std::max(1ul, typeSize), data};
+}
+void lingodb::runtime::Heap::mergeWithOther(Heap* other) {
+   //entries that sort after the shared bound can not be part of the result, the entry defining the bound itself is kept
+   auto* bound = threshold ? threshold->bound.load(std::memory_order_acquire) : nullptr;
+   for (size_t i = 0; i < other->currElements; i++) {
+      auto* currData = other->entry(i);
+      if (!bound || !cmpFn(bound->value, currData)) {
+         add(currData);
+      }
+   }
 }
 void lingodb::runtime::Heap::destroy(Heap* h) {
    delete h;
@@ -62,14 +141,8 @@ void lingodb::runtime::Heap::destroy(Heap* h) {
 
 lingodb::runtime::Heap* lingodb::runtime::Heap::merge(lingodb::runtime::ThreadLocal* threadLocal) {
    utility::Tracer::Trace trace(mergeHeapEvent);
-   Heap* first = nullptr;
-   for (auto* current : threadLocal->getThreadLocalValues<Heap>()) {
-      if (!current) continue;
-      if (!first) {
-         first = current;
-      } else {
-         first->mergeWithOther(current);
-      }
-   }
-   return first;
-}
\ No newline at end of file
+   //pairwise merges run in parallel (log2(#workers) rounds), each heap holds at most maxElements entries that beat the shared bound
+   return threadLocal->reduce<Heap>([](Heap* first, Heap* current) {
+      first->mergeWithOther(current);
+   });
+}
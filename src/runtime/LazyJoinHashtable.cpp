@@ -1,9 +1,11 @@
 #include "lingodb/runtime/LazyJoinHashtable.h"
 #include "lingodb/runtime/GrowingBuffer.h"
+#include "lingodb/scheduler/Tasks.h"
 #include "lingodb/utility/Tracer.h"
 
 #include <algorithm>
 #include <atomic>
+#include <functional>
 #include <iostream>
 
 namespace {
@@ -15,19 +17,53 @@ lingodb::runtime::HashIndexedView* lingodb::runtime::HashIndexedView::build(ling
    auto& values = buffer->getValues();
    size_t htSize = std::max(nextPow2(values.getLen() * 1.25), static_cast<uint64_t>(1));
    size_t htMask = htSize - 1;
-   auto* htView = new HashIndexedView(htSize, htMask);
+   //8-16 bits per entry
+   size_t filterSize = std::max(nextPow2(values.getLen()) / 8, static_cast<uint64_t>(1));
+   size_t filterMask = filterSize - 1;
+   auto* htView = new HashIndexedView(htSize, htMask, filterSize, filterMask, values.getLen());
    executionContext->registerState({htView, [](void* ptr) { delete reinterpret_cast<lingodb::runtime::HashIndexedView*>(ptr); }});
+   auto* ht = htView->ht;
+   constexpr uint64_t slotStep = sizeof(Slot) << 16;
+   //1. count the slots of every bucket (in the pointer bits) and collect the bloom tags (in the lower 16 bits)
    values.iterateParallel([&](uint8_t* ptr) {
       auto* entry = (Entry*) ptr;
       size_t hash = (size_t) entry->hashValue;
-      auto pos = hash & htMask;
-      std::atomic_ref<Entry*> slot(htView->ht[pos]);
-      Entry* current = slot.load();
-      Entry* newEntry;
-      do {
-         entry->next = lingodb::runtime::untag(current);
-         newEntry = lingodb::runtime::tag(entry, current, hash);
-      } while (!slot.compare_exchange_weak(current, newEntry));
+      std::atomic_ref<uint64_t> bucket(ht[hash & htMask]);
+      bucket.fetch_add(slotStep, std::memory_order_relaxed);
+      bucket.fetch_or(bloomMasks[hash >> (64 - 11)], std::memory_order_relaxed);
+      std::atomic_ref<uint64_t>(htView->filter[filterWord(hash, filterMask)]).fetch_or(filterBits(hash), std::memory_order_relaxed);
+   });
+   //2. turn the counts into the end of every bucket's slot range (prefix sum over blocks of buckets)
+   size_t numBlocks = std::min(htSize, lingodb::scheduler::getNumWorkers() * 4);
+   size_t blockSize = (htSize + numBlocks - 1) / numBlocks;
+   std::vector<uint64_t> blockOffsets(numBlocks + 1, 0);
+   lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(numBlocks, [&](size_t block) {
+      uint64_t sum = 0;
+      for (size_t i = block * blockSize; i < std::min(htSize, (block + 1) * blockSize); i++) {
+         sum += ht[i] >> 16;
+      }
+      blockOffsets[block + 1] = sum;
+   }));
+   blockOffsets[0] = reinterpret_cast<uint64_t>(htView->slots);
+   for (size_t block = 0; block < numBlocks; block++) {
+      blockOffsets[block + 1] += blockOffsets[block];
+   }
+   lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(numBlocks, [&](size_t block) {
+      uint64_t end = blockOffsets[block];
+      for (size_t i = block * blockSize; i < std::min(htSize, (block + 1) * blockSize); i++) {
+         end += ht[i] >> 16;
+         ht[i] = (end << 16) | (ht[i] & 0xffff);
+      }
+   }));
+   ht[htSize] = blockOffsets[numBlocks] << 16;
+   //3. fill the slot ranges from their ends, afterwards ht[b] points to the begin of bucket b
+   values.iterateParallel([&](uint8_t* ptr) {
+      auto* entry = (Entry*) ptr;
+      size_t hash = (size_t) entry->hashValue;
+      uint64_t end = std::atomic_ref<uint64_t>(ht[hash & htMask]).fetch_sub(slotStep, std::memory_order_relaxed);
+      auto* slot = reinterpret_cast<Slot*>(end >> 16) - 1;
+      slot->hashValue = hash;
+      slot->entry = entry;
    });
    trace.stop();
    return htView;
@@ -35,7 +71,9 @@ lingodb::runtime::HashIndexedView* lingodb::runtime::HashIndexedView::build(ling
 void lingodb::runtime::HashIndexedView::destroy(lingodb::runtime::HashIndexedView* ht) {
    delete ht;
 }
-lingodb::runtime::HashIndexedView::HashIndexedView(size_t htSize, size_t htMask) : ht(lingodb::runtime::FixedSizedBuffer<Entry*>::createZeroed(htSize)), htMask(htMask) {}
+lingodb::runtime::HashIndexedView::HashIndexedView(size_t htSize, size_t htMask, size_t filterSize, size_t filterMask, size_t numSlots) : ht(lingodb::runtime::FixedSizedBuffer<uint64_t>::createZeroed(htSize + 1)), htMask(htMask), filter(lingodb::runtime::FixedSizedBuffer<uint64_t>::createZeroed(filterSize)), filterMask(filterMask), slots(lingodb::runtime::FixedSizedBuffer<Slot>::createZeroed(std::max(numSlots, static_cast<size_t>(1)))), numSlots(std::max(numSlots, static_cast<size_t>(1))) {}
 lingodb::runtime::HashIndexedView::~HashIndexedView() {
-   lingodb::runtime::FixedSizedBuffer<Entry*>::deallocate(ht, htMask + 1);
+   lingodb::runtime::FixedSizedBuffer<uint64_t>::deallocate(ht, htMask + 2);
+   lingodb::runtime::FixedSizedBuffer<uint64_t>::deallocate(filter, filterMask + 1);
+   lingodb::runtime::FixedSizedBuffer<Slot>::deallocate(slots, numSlots);
 }
@@ -0,0 +1,97 @@
+#include "lingodb/runtime/NestedLoopJoin.h"
+#include "lingodb/runtime/ExecutionContext.h"
+#include "lingodb/runtime/GrowingBuffer.h"
+#include "lingodb/scheduler/Tasks.h"
+#include "lingodb/utility/Setting.h"
+#include "lingodb/utility/Tracer.h"
+
+#include <algorithm>
+
+namespace {
+//size of a build block, all build entries of a block should stay in the L2 cache while a probe batch is joined against them
+lingodb::utility::GlobalSetting<int64_t> nestedLoopJoinBlockBytes("system.nested_loop_join.block_bytes", 1 << 18);
+//number of probe entries that are joined against one build block at a time
+lingodb::utility::GlobalSetting<int64_t> nestedLoopJoinBatchSize("system.nested_loop_join.batch_size", 1024);
+static lingodb::utility::Tracer::Event createEvent("NestedLoopJoin", "create");
+static lingodb::utility::Tracer::Event joinBatchEvent("NestedLoopJoin", "joinBatch");
+
+//cuts the buffers of an input into pieces of at most maxElements entries
+void split(lingodb::runtime::GrowingBuffer* input, size_t maxElements, std::vector<lingodb::runtime::Buffer>& pieces) {
+   size_t typeSize = input->getTypeSize();
+   for (auto buffer : input->getValues().getBuffers()) {
+      for (size_t begin = 0; begin < buffer.numElements; begin += maxElements) {
+         pieces.push_back({std::min(maxElements, buffer.numElements - begin), &buffer.ptr[begin * typeSize]});
+      }
+   }
+}
+} // end namespace
+
+namespace lingodb::runtime {
+class NestedLoopJoinIterator : public BufferIterator {
+   NestedLoopJoin& join;
+   //sequential iteration: the current pair is (buildBlocks[block], probeBatches[batch])
+   size_t batch;
+   size_t block;
+   NestedLoopJoin::BlockPair current;
+
+   public:
+   NestedLoopJoinIterator(NestedLoopJoin& join) : join(join), batch(0), block(0), current{} {}
+   bool isValid() override {
+      return !join.buildBlocks.empty() && batch < join.probeBatches.size();
+   }
+   void next() override {
+      if (++block == join.buildBlocks.size()) {
+         block = 0;
+         batch++;
+      }
+   }
+   Buffer getCurrentBuffer() override {
+      auto buildBlock = join.buildBlocks[block];
+      auto probeBatch = join.probeBatches[batch];
+      current = {buildBlock.ptr, buildBlock.numElements, probeBatch.ptr, probeBatch.numElements};
+      return Buffer{sizeof(NestedLoopJoin::BlockPair), reinterpret_cast<uint8_t*>(&current)};
+   }
+   void iterateEfficient(bool parallel, void (*forEachChunk)(Buffer, void*), void* contextPtr) override {
+      if (join.buildBlocks.empty()) {
+         return;
+      }
+      auto joinBatch = [&](size_t batch) { join.joinBatch(batch, forEachChunk, contextPtr); };
+      if (parallel) {
+         lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(join.probeBatches.size(), joinBatch));
+      } else {
+         for (size_t i = 0; i < join.probeBatches.size(); i++) {
+            joinBatch(i);
+         }
+      }
+   }
+};
+} // end namespace lingodb::runtime
+
+lingodb::runtime::NestedLoopJoin::NestedLoopJoin(GrowingBuffer* build, GrowingBuffer* probe) : build(build), probe(probe) {}
+
+lingodb::runtime::NestedLoopJoin* lingodb::runtime::NestedLoopJoin::create(GrowingBuffer* build, GrowingBuffer* probe) {
+   utility::Tracer::Trace trace(createEvent);
+   auto* executionContext = runtime::getCurrentExecutionContext();
+   auto* join = new NestedLoopJoin(build, probe);
+   executionContext->registerState({join, [](void* ptr) { delete reinterpret_cast<NestedLoopJoin*>(ptr); }});
+   size_t blockElements = std::max<size_t>(nestedLoopJoinBlockBytes.getValue() / std::max<size_t>(build->getTypeSize(), 1), 1);
+   split(build, blockElements, join->buildBlocks);
+   split(probe, std::max<int64_t>(nestedLoopJoinBatchSize.getValue(), 1), join->probeBatches);
+   trace.stop();
+   return join;
+}
+
+void lingodb::runtime::NestedLoopJoin::joinBatch(size_t batch, void (*forEachChunk)(Buffer, void*), void* contextPtr) {
+   utility::Tracer::Trace trace(joinBatchEvent);
+   auto probeBatch = probeBatches[batch];
+   //the probe batch is small enough to stay cached as well, so it is joined against every build block in turn
+   for (auto buildBlock : buildBlocks) {
+      BlockPair pair{buildBlock.ptr, buildBlock.numElements, probeBatch.ptr, probeBatch.numElements};
+      forEachChunk(Buffer{sizeof(BlockPair), reinterpret_cast<uint8_t*>(&pair)}, contextPtr);
+   }
+   trace.stop();
+}
+
+lingodb::runtime::BufferIterator* lingodb::runtime::NestedLoopJoin::createIterator(NestedLoopJoin* join) {
+   return new NestedLoopJoinIterator(*join);
+}
@@ -1,34 +1,48 @@
 #include "lingodb/runtime/PreAggregationHashtable.h"
 #include "lingodb/runtime/helpers.h"
 #include "lingodb/scheduler/Tasks.h"
+#include "lingodb/utility/Setting.h"
 #include "lingodb/utility/Tracer.h"
 #include <algorithm>
 #include <atomic>
+#include <bit>
+#include <cstring>
 #include <iostream>
 
+#include <unistd.h>
+
 namespace {
+//cache budget (in bytes) for the thread-local pre-aggregation table (0: use the size of the L2 cache)
+lingodb::utility::GlobalSetting<int64_t> preAggCacheBudget("system.preagg.cache_budget", 0);
+//pre-aggregation is bypassed for a while if less than this fraction of lookups find an existing entry
+lingodb::utility::GlobalSetting<double> preAggMinHitRatio("system.preagg.min_hit_ratio", 0.25);
+//number of radix partitions produced by the thread-local fragments (0: derive from the number of workers)
+lingodb::utility::GlobalSetting<int64_t> preAggPartitions("system.preagg.partitions", 0);
+static lingodb::utility::Tracer::Event bypassEvent("OHtFragment", "bypass");
+static lingodb::utility::Tracer::Event spillEvent("OHtFragment", "spill");
 static lingodb::utility::Tracer::Event createEvent("OHtFragment", "create");
 static lingodb::utility::Tracer::Event mergeEvent("Oht", "merge");
+static lingodb::utility::Tracer::Event mergeScatterEvent("Oht", "mergeScatter");
 static lingodb::utility::Tracer::Event mergePartitionEvent("Oht", "mergePartition");
 static lingodb::utility::Tracer::Event mergeAllocate("Oht", "mergeAlloc");
 static lingodb::utility::Tracer::Event mergeDeallocate("Oht", "mergeDealloc");
 
 // https://en.cppreference.com/w/cpp/atomic/atomic_flag
 
+//calls cb once for every partition
 class FragmentOutputsTask : public lingodb::scheduler::TaskWithImplicitContext {
-   std::vector<lingodb::runtime::FlexibleBuffer*>* outputs;
-   std::function<void(std::vector<lingodb::runtime::FlexibleBuffer*>&)> cb;
+   size_t numPartitions;
+   std::function<void(size_t)> cb;
    std::atomic<size_t> startIndex{0};
    std::vector<size_t> workerResvs;
 
    public:
-   FragmentOutputsTask(std::vector<lingodb::runtime::FlexibleBuffer*>* outputs, std::function<void(std::vector<lingodb::runtime::FlexibleBuffer*>&)> cb) : outputs(outputs), cb(cb) {
+   FragmentOutputsTask(size_t numPartitions, std::function<void(size_t)> cb) : numPartitions(numPartitions), cb(cb) {
       for (size_t i = 0; i < lingodb::scheduler::getNumWorkers(); i++) {
          workerResvs.push_back(0);
       }
    }
    bool allocateWork() override {
-      constexpr size_t numPartitions = lingodb::runtime::PreAggregationHashtableFragment::numOutputs;
       size_t localStartIndex = startIndex.fetch_add(1);
       if (localStartIndex >= numPartitions) {
          workExhausted.store(true);
@@ -37,73 +51,244 @@ class FragmentOutputsTask : public lingodb::scheduler::TaskWithImplicitContext {
       workerResvs[lingodb::scheduler::currentWorkerId()] = localStartIndex;
       return true;
    }
+   size_t maxParallelism() override {
+      return numPartitions;
+   }
    void performWork() override {
-      auto& batch = outputs[workerResvs[lingodb::scheduler::currentWorkerId()]];
-      cb(batch);
+      cb(workerResvs[lingodb::scheduler::currentWorkerId()]);
    }
 };
 } // end namespace
+namespace {
+constexpr size_t minSampleLookups = 16384;
+//number of sampling windows pre-aggregation stays disabled before it is tried again
+constexpr size_t bypassWindows = 64;
+size_t getFragmentHtSize(size_t typeSize) {
+   static size_t cacheBudget = [] {
+      int64_t budget = preAggCacheBudget.getValue();
+      if (budget > 0) {
+         return static_cast<size_t>(budget);
+      }
+#ifdef _SC_LEVEL2_CACHE_SIZE
+      long l2Size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+      if (l2Size > 0) {
+         return static_cast<size_t>(l2Size);
+      }
+#endif
+      return static_cast<size_t>(1 << 20);
+   }();
+   //the table itself and the entries it points to should fit into the budget
+   size_t slots = std::bit_floor(std::max<size_t>(1, cacheBudget / (sizeof(void*) + typeSize)));
+   return std::clamp<size_t>(slots, 256, 1 << 16);
+}
+} // end namespace
+
+size_t lingodb::runtime::PreAggregationHashtableFragment::getNumPartitions() {
+   int64_t configured = preAggPartitions.getValue();
+   if (configured > 0) {
+      return std::bit_ceil(static_cast<size_t>(configured));
+   }
+   //enough partitions to keep all workers busy during the merge, but not too many partially filled output buffers per fragment
+   return std::clamp<size_t>(std::bit_ceil(4 * lingodb::scheduler::getNumWorkers()), 64, 512);
+}
+lingodb::runtime::PreAggregationHashtableFragment::PreAggregationHashtableFragment(size_t typeSize, bool withLocks, MemoryBudget* memoryBudget) : numLookups(0), typeSize(typeSize), len(0), numOutputs(getNumPartitions()), withLocks(withLocks), bypassSlot(nullptr), bypass(false), windowLookups(0), windowLen(0), memoryBudget(memoryBudget), accountedBytes(0), spilledLen(0) {
+   outputs = new FlexibleBuffer*[numOutputs]();
+   size_t htSize = getFragmentHtSize(typeSize);
+   localHt = FixedSizedBuffer<Entry*>::createZeroed(htSize);
+   localHtMask = htSize - 1;
+   ht = localHt;
+   htMask = localHtMask;
+}
+void lingodb::runtime::PreAggregationHashtableFragment::adapt() {
+   size_t lookups = numLookups - windowLookups;
+   size_t sampleLookups = std::max(minSampleLookups, 4 * (localHtMask + 1));
+   if (bypass) {
+      if (lookups >= bypassWindows * sampleLookups) {
+         //try pre-aggregation again: the input might have become more local. Old entries are still valid
+         bypass = false;
+         ht = localHt;
+         htMask = localHtMask;
+         windowLookups = numLookups;
+         windowLen = len;
+      }
+      return;
+   }
+   if (lookups < sampleLookups) {
+      return;
+   }
+   size_t inserted = len - windowLen;
+   double hitRatio = 1.0 - static_cast<double>(std::min(inserted, lookups)) / lookups;
+   if (hitRatio < preAggMinHitRatio.getValue()) {
+      utility::Tracer::Trace trace(bypassEvent);
+      //every lookup now misses without polluting the cache
+      bypass = true;
+      ht = &bypassSlot;
+      htMask = 0;
+   }
+   windowLookups = numLookups;
+   windowLen = len;
+}
+void lingodb::runtime::PreAggregationHashtableFragment::spill() {
+   utility::Tracer::Trace trace(spillEvent);
+   if (!spillFile) {
+      spillFile = SpillFile::create();
+      spilledSegments.resize(numOutputs);
+   }
+   for (size_t i = 0; i < numOutputs; i++) {
+      if (!outputs[i]) continue;
+      for (auto& buffer : outputs[i]->getBuffers()) {
+         if (buffer.numElements == 0) continue;
+         size_t offset = spillFile->append(buffer.ptr, buffer.numElements * typeSize);
+         spilledSegments[i].push_back({offset, buffer.numElements});
+      }
+      delete outputs[i];
+      outputs[i] = nullptr;
+   }
+   //all entries are gone: no lookup may find them anymore
+   std::fill(localHt, localHt + localHtMask + 1, nullptr);
+   memoryBudget->release(accountedBytes);
+   accountedBytes = 0;
+   spilledLen = len;
+   trace.stop();
+}
 lingodb::runtime::PreAggregationHashtableFragment::Entry* lingodb::runtime::PreAggregationHashtableFragment::insert(size_t hash) {
-   constexpr size_t outputMask = numOutputs - 1;
-   constexpr size_t htMask = hashtableSize - 1;
+   const size_t outputMask = numOutputs - 1;
    constexpr size_t htShift = 6; //2^6=64
+   if ((len & 1023) == 0 && len) {
+      //entries handed out before are not used anymore (only the returned one is updated by the caller), so spilling is safe here
+      size_t outputBytes = (len - spilledLen) * typeSize;
+      memoryBudget->allocate(outputBytes - std::min(outputBytes, accountedBytes));
+      accountedBytes = std::max(accountedBytes, outputBytes);
+      if (memoryBudget->isExceeded()) {
+         spill();
+      }
+   }
    len++;
    auto outputIdx = hash & outputMask;
    if (!outputs[outputIdx]) {
-      outputs[outputIdx] = new FlexibleBuffer(256, typeSize);
+      outputs[outputIdx] = new FlexibleBuffer(std::max<size_t>(16, 256 * 64 / numOutputs), typeSize);
    }
    auto* newEntry = reinterpret_cast<lingodb::runtime::PreAggregationHashtableFragment::Entry*>(outputs[outputIdx]->insert());
    newEntry->hashValue = hash;
    newEntry->next = nullptr;
-   ht[hash >> htShift & htMask] = newEntry;
+   if (!bypass) {
+      localHt[hash >> htShift & localHtMask] = newEntry;
+   }
+   if ((len & 1023) == 0) {
+      adapt();
+   }
    return newEntry;
 }
 
 lingodb::runtime::PreAggregationHashtableFragment* lingodb::runtime::PreAggregationHashtableFragment::create(size_t typeSize, bool withLocks) {
    utility::Tracer::Trace trace(createEvent);
    auto* context = runtime::getCurrentExecutionContext();
-   auto* fragment = new PreAggregationHashtableFragment(typeSize, withLocks);
+   auto* fragment = new PreAggregationHashtableFragment(typeSize, withLocks, &context->getMemoryBudget());
    context->registerState({fragment, [](void* ptr) { delete reinterpret_cast<PreAggregationHashtableFragment*>(ptr); }});
    return fragment;
 }
 lingodb::runtime::PreAggregationHashtableFragment::~PreAggregationHashtableFragment() {
+   memoryBudget->release(accountedBytes);
+   FixedSizedBuffer<Entry*>::deallocate(localHt, localHtMask + 1);
    for (size_t i = 0; i < numOutputs; i++) {
       if (outputs[i]) {
          delete outputs[i];
       }
    }
+   delete[] outputs;
+}
+lingodb::runtime::PreAggregationHashtable::PreAggregationHashtable(size_t numPartitions, MemoryBudget* memoryBudget) : partitionMask(numPartitions - 1), partitionShift(std::countr_zero(numPartitions)), buffer(1, sizeof(PreAggregationHashtableFragment::Entry*)), sharesHt(numPartitions, false), memoryBudget(memoryBudget), accountedBytes(0) {
+   ht = new PartitionHt[numPartitions]();
 }
 lingodb::runtime::PreAggregationHashtable* lingodb::runtime::PreAggregationHashtable::merge(lingodb::runtime::ThreadLocal* threadLocal, bool (*eq)(uint8_t*, uint8_t*), void (*combine)(uint8_t*, uint8_t*)) {
    utility::Tracer::Trace trace(mergeEvent);
    auto* context = runtime::getCurrentExecutionContext();
-   constexpr size_t htShift = 6; //2^6=64
 
    std::mutex mutex;
    using Entry = lingodb::runtime::PreAggregationHashtableFragment::Entry;
-   constexpr size_t numPartitions = lingodb::runtime::PreAggregationHashtableFragment::numOutputs;
-   std::vector<FlexibleBuffer*> outputs[numPartitions];
+   const size_t numFragmentPartitions = PreAggregationHashtableFragment::getNumPartitions();
+   std::vector<std::vector<FlexibleBuffer*>> outputs(numFragmentPartitions);
+   std::vector<std::vector<std::pair<PreAggregationHashtableFragment*, PreAggregationHashtableFragment::SpilledSegment>>> spilled(numFragmentPartitions);
+   size_t totalEntries = 0;
+   bool anySpilled = false;
    for (auto* fragment : threadLocal->getThreadLocalValues<PreAggregationHashtableFragment>()) {
       if (!fragment) {
          continue;
       }
-      for (size_t i = 0; i < numPartitions; i++) {
+      assert(fragment->numOutputs == numFragmentPartitions);
+      for (size_t i = 0; i < numFragmentPartitions; i++) {
          auto* current = fragment->outputs[i];
          if (current) {
             outputs[i].push_back(current);
+            totalEntries += current->getLen();
+         }
+         if (fragment->spillFile) {
+            for (auto segment : fragment->spilledSegments[i]) {
+               spilled[i].push_back({fragment, segment});
+               anySpilled = true;
+            }
          }
       }
    }
-   auto* res = new PreAggregationHashtable();
+   //second radix pass: split the fragment partitions further if they would not fit into the cache or if there are not enough partitions for all workers
+   constexpr size_t targetPartitionEntries = 1 << 14;
+   constexpr size_t maxPartitions = 1 << 14;
+   size_t subPartitions = std::bit_ceil(std::max<size_t>(1, totalEntries / (numFragmentPartitions * targetPartitionEntries)));
+   if (totalEntries > numFragmentPartitions * 1024) {
+      subPartitions = std::max(subPartitions, std::bit_ceil((4 * lingodb::scheduler::getNumWorkers() + numFragmentPartitions - 1) / numFragmentPartitions));
+   }
+   subPartitions = std::min(subPartitions, maxPartitions / numFragmentPartitions);
+   const size_t numPartitions = numFragmentPartitions * subPartitions;
+   const size_t partitionShift = std::countr_zero(numPartitions);
+   //a fragment partition with spilled entries is not split further: its spilled segments are loaded chunk by chunk into a single table.
+   //This table is shared by all its final partitions, as the position inside a table only depends on the bits above partitionShift.
+   auto isSpilled = [&](size_t fragmentPartition) { return !spilled[fragmentPartition].empty(); };
+
+   auto* res = new PreAggregationHashtable(numPartitions, &context->getMemoryBudget());
    context->registerState({res, [](void* ptr) { delete reinterpret_cast<PreAggregationHashtable*>(ptr); }});
-   auto handleMerge = [&](std::vector<FlexibleBuffer*>& input) {
-      size_t id = &input - &outputs[0];
+   if (anySpilled) {
+      res->loadedEntries.resize(numPartitions);
+   }
+
+   //the final partition of an entry is hash & (numPartitions-1): its lower bits equal the fragment partition
+   std::vector<std::vector<Entry*>> scattered;
+   if (subPartitions > 1) {
+      scattered.resize(numPartitions);
+      auto handleScatter = [&](size_t fragmentPartition) {
+         if (isSpilled(fragmentPartition)) {
+            return;
+         }
+         utility::Tracer::Trace trace(mergeScatterEvent);
+         for (auto* o : outputs[fragmentPartition]) {
+            o->iterate([&](uint8_t* entryRawPtr) {
+               Entry* curr = reinterpret_cast<Entry*>(entryRawPtr);
+               scattered[curr->hashValue & (numPartitions - 1)].push_back(curr);
+            });
+         }
+         trace.stop();
+      };
+      lingodb::scheduler::awaitChildTask(std::make_unique<FragmentOutputsTask>(numFragmentPartitions, handleScatter));
+   }
+   auto handleMerge = [&](size_t id) {
+      const size_t fragmentPartition = id & (numFragmentPartitions - 1);
+      if (isSpilled(fragmentPartition) && id != fragmentPartition) {
+         //uses the table of the fragment partition
+         return;
+      }
+      const bool fromScattered = subPartitions > 1 && !isSpilled(fragmentPartition);
       utility::Tracer::Trace trace(mergePartitionEvent);
       size_t totalValues = 0;
       size_t minValues = 0;
-
-      for (auto* o : input) {
-         totalValues += o->getLen();
-         minValues = std::max((size_t) 0, o->getLen());
+      if (fromScattered) {
+         totalValues = scattered[id].size();
+      } else {
+         for (auto* o : outputs[fragmentPartition]) {
+            totalValues += o->getLen();
+            minValues = std::max((size_t) 0, o->getLen());
+         }
+         for (auto& s : spilled[fragmentPartition]) {
+            totalValues += s.second.numEntries;
+         }
       }
       lingodb::runtime::FlexibleBuffer localBuffer(minValues, sizeof(Entry*));
       auto nextPow2 = [](uint64_t v) {
@@ -123,54 +308,102 @@ lingodb::runtime::PreAggregationHashtable* lingodb::runtime::PreAggregationHasht
       utility::Tracer::Trace allocTrace(mergeAllocate);
       Entry** ht = lingodb::runtime::FixedSizedBuffer<Entry*>::createZeroed(htSize);
       allocTrace.stop();
-      for (auto* o : input) {
-         o->iterate([&](uint8_t* entryRawPtr) {
-            Entry* curr = reinterpret_cast<Entry*>(entryRawPtr);
-            auto pos = curr->hashValue >> htShift & htMask;
-            auto* currCandidate = lingodb::runtime::untag(ht[pos]);
-            bool merged = false;
-            while (currCandidate) {
-               if (currCandidate->hashValue == curr->hashValue && eq(currCandidate->content, curr->content)) {
-                  combine(currCandidate->content, curr->content);
-                  merged = true;
-                  break;
-               }
-               currCandidate = currCandidate->next;
+      //entries that are not merged into an existing one are copied to copyTo if it is set
+      auto insertEntry = [&](Entry* curr, FlexibleBuffer* copyTo) {
+         auto pos = curr->hashValue >> partitionShift & htMask;
+         auto* currCandidate = lingodb::runtime::untag(ht[pos]);
+         bool merged = false;
+         while (currCandidate) {
+            if (currCandidate->hashValue == curr->hashValue && eq(currCandidate->content, curr->content)) {
+               combine(currCandidate->content, curr->content);
+               merged = true;
+               break;
             }
-            if (!merged) {
-               auto* loc = reinterpret_cast<Entry**>(localBuffer.insert());
-               *loc = curr;
-               auto* previousPtr = ht[pos];
-               ht[pos] = lingodb::runtime::tag(curr, previousPtr, curr->hashValue);
-               curr->next = lingodb::runtime::untag(previousPtr);
+            currCandidate = currCandidate->next;
+         }
+         if (!merged) {
+            if (copyTo) {
+               auto* copy = reinterpret_cast<Entry*>(copyTo->insert());
+               std::memcpy(copy, curr, copyTo->getTypeSize());
+               curr = copy;
             }
-         });
+            auto* loc = reinterpret_cast<Entry**>(localBuffer.insert());
+            *loc = curr;
+            auto* previousPtr = ht[pos];
+            ht[pos] = lingodb::runtime::tag(curr, previousPtr, curr->hashValue);
+            curr->next = lingodb::runtime::untag(previousPtr);
+         }
+      };
+      if (fromScattered) {
+         for (auto* curr : scattered[id]) {
+            insertEntry(curr, nullptr);
+         }
+         std::vector<Entry*>().swap(scattered[id]);
+      } else {
+         for (auto* o : outputs[fragmentPartition]) {
+            o->iterate([&](uint8_t* entryRawPtr) {
+               insertEntry(reinterpret_cast<Entry*>(entryRawPtr), nullptr);
+            });
+         }
+         //load spilled entries chunk by chunk: only the entries of new groups are kept in memory
+         std::vector<uint8_t> chunk;
+         for (auto& [fragment, segment] : spilled[fragmentPartition]) {
+            auto typeSize = fragment->typeSize;
+            auto& loaded = res->loadedEntries[id];
+            if (!loaded) {
+               loaded = std::make_unique<FlexibleBuffer>(256, typeSize);
+            }
+            constexpr size_t chunkEntries = 1 << 14;
+            for (size_t done = 0; done < segment.numEntries; done += chunkEntries) {
+               size_t numEntries = std::min(chunkEntries, segment.numEntries - done);
+               chunk.resize(numEntries * typeSize);
+               fragment->spillFile->read(segment.offset + done * typeSize, chunk.data(), numEntries * typeSize);
+               for (size_t i = 0; i < numEntries; i++) {
+                  insertEntry(reinterpret_cast<Entry*>(&chunk[i * typeSize]), loaded.get());
+               }
+            }
+         }
       }
       utility::Tracer::Trace deallocTrace(mergeDeallocate);
       res->ht[id] = {ht, htMask};
       deallocTrace.stop();
+      size_t mergedBytes = htSize * sizeof(Entry*) + localBuffer.getLen() * sizeof(Entry*);
+      if (anySpilled && res->loadedEntries[id]) {
+         mergedBytes += res->loadedEntries[id]->getLen() * res->loadedEntries[id]->getTypeSize();
+      }
+      res->memoryBudget->allocate(mergedBytes);
+      res->accountedBytes.fetch_add(mergedBytes);
       std::unique_lock<std::mutex> lock(mutex);
       res->buffer.merge(localBuffer);
       trace.stop();
    };
-   lingodb::scheduler::awaitChildTask(std::make_unique<FragmentOutputsTask>(outputs, handleMerge));
+   lingodb::scheduler::awaitChildTask(std::make_unique<FragmentOutputsTask>(numPartitions, handleMerge));
+   for (size_t id = numFragmentPartitions; id < numPartitions; id++) {
+      if (isSpilled(id & (numFragmentPartitions - 1))) {
+         res->ht[id] = res->ht[id & (numFragmentPartitions - 1)];
+         res->sharesHt[id] = true;
+      }
+   }
    return res;
 }
 lingodb::runtime::BufferIterator* lingodb::runtime::PreAggregationHashtable::createIterator() {
    return buffer.createIterator();
 }
 lingodb::runtime::PreAggregationHashtable::Entry* lingodb::runtime::PreAggregationHashtable::lookup(size_t hash) {
-   constexpr size_t partitionMask = lingodb::runtime::PreAggregationHashtableFragment::numOutputs - 1;
    auto partition = hash & partitionMask;
    if (!ht[partition].ht) {
       return nullptr;
    } else {
-      return lingodb::runtime::filterTagged(ht[partition].ht[ht[partition].hashMask & hash >> 6], hash);
+      return lingodb::runtime::filterTagged(ht[partition].ht[ht[partition].hashMask & hash >> partitionShift], hash);
    }
 }
 
 lingodb::runtime::PreAggregationHashtable::~PreAggregationHashtable() {
-   for (auto p : ht) {
-      lingodb::runtime::FixedSizedBuffer<Entry*>::deallocate(p.ht, p.hashMask + 1);
+   memoryBudget->release(accountedBytes.load());
+   for (size_t i = 0; i <= partitionMask; i++) {
+      if (!sharesHt[i]) {
+         lingodb::runtime::FixedSizedBuffer<Entry*>::deallocate(ht[i].ht, ht[i].hashMask + 1);
+      }
    }
+   delete[] ht;
 }
@@ -1,107 +1,119 @@
 #include "lingodb/runtime/SegmentTreeView.h"
 #include "lingodb/runtime/helpers.h"
+#include "lingodb/scheduler/Tasks.h"
+#include "lingodb/utility/Setting.h"
 #include "lingodb/utility/Tracer.h"
+#include <array>
 #include <cassert>
 #include <cstring>
+#include <functional>
 #include <iostream>
 namespace {
+//number of children of each inner node
+lingodb::utility::GlobalSetting<int64_t> segmentTreeFanout("system.segment_tree.fanout", 16);
 lingodb::utility::Tracer::Event buildEvent("SegmentTree", "build");
+lingodb::utility::Tracer::Event buildLevelEvent("SegmentTree", "buildLevel");
+
+//number of states of one level that are computed by one unit of work
+constexpr size_t statesPerTask = 2048;
+constexpr size_t maxLevels = 64;
 } // end namespace
 namespace lingodb::runtime {
-SegmentTreeView::TreeNode* SegmentTreeView::allocate() {
-   assert(storageCntr < numEntries);
-   return &storage[storageCntr++];
-}
-uint8_t* SegmentTreeView::allocateState() {
-   assert(stateCntr < numEntries);
-   return &stateStorage[stateTypeSize * stateCntr++];
-}
-//from: inclusive,to: inclusive
-SegmentTreeView::TreeNode* SegmentTreeView::buildRecursively(std::vector<uint8_t*>& entryPointers, size_t from, size_t to) {
-   if (from == to) {
-      TreeNode* leaf = allocate();
-      leaf->leftMin = from;
-      leaf->rightMax = to;
-      leaf->state = allocateState();
-      createInitialStateFn(leaf->state, entryPointers[from]);
-      uint64_t init = 0;
-      memcpy(&init, leaf->state, sizeof(init));
-      return leaf;
+void SegmentTreeView::buildLevel(size_t level, uint8_t* entries, size_t typeSize) {
+   utility::Tracer::Trace trace(buildLevelEvent);
+   size_t levelSize = levelSizes[level];
+   std::function<void(size_t)> buildBlock = [&](size_t block) {
+      size_t end = std::min((block + 1) * statesPerTask, levelSize);
+      for (size_t i = block * statesPerTask; i < end; i++) {
+         auto* state = getState(level, i);
+         if (level == 0) {
+            createInitialStateFn(state, &entries[i * typeSize]);
+         } else {
+            size_t childEnd = std::min((i + 1) * fanout, levelSizes[level - 1]);
+            memcpy(state, getState(level - 1, i * fanout), stateTypeSize);
+            for (size_t child = i * fanout + 1; child < childEnd; child++) {
+               combineStatesFn(state, state, getState(level - 1, child));
+            }
+         }
+      }
+   };
+   size_t numBlocks = (levelSize + statesPerTask - 1) / statesPerTask;
+   if (numBlocks == 1) {
+      buildBlock(0);
    } else {
-      size_t mid = from + (to - from) / 2;
-      TreeNode* left = buildRecursively(entryPointers, from, mid);
-      TreeNode* right = buildRecursively(entryPointers, mid + 1, to);
-      TreeNode* inner = allocate();
-      inner->leftMin = from;
-      inner->rightMax = to;
-      inner->left = left;
-      inner->right = right;
-      inner->state = allocateState();
-      combineStatesFn(inner->state, left->state, right->state);
-      return inner;
+      lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(numBlocks, buildBlock));
    }
+   trace.stop();
 }
-void SegmentTreeView::destroyNode(lingodb::runtime::SegmentTreeView::TreeNode* node) {
-   if (node == nullptr) {
-      return;
+void SegmentTreeView::aggregate(uint8_t* result, size_t level, size_t from, size_t to, bool& first) {
+   for (size_t i = from; i < to; i++) {
+      if (first) {
+         memcpy(result, getState(level, i), stateTypeSize);
+         first = false;
+      } else {
+         combineStatesFn(result, result, getState(level, i));
+      }
    }
-   destroyNode(node->left);
-   destroyNode(node->right);
-   delete node;
 }
 void SegmentTreeView::lookup(uint8_t* result, size_t from, size_t to) {
    if (from > to) {
       throw std::runtime_error("from must be <= to");
    }
-   if (!root) {
+   if (!numStates) {
       throw std::runtime_error("can not perform lookup on empty segment tree");
    }
    bool first = true;
-   lookupRecursively(root, result, from, to, first);
-}
-void SegmentTreeView::lookupRecursively(lingodb::runtime::SegmentTreeView::TreeNode* t, uint8_t* result, size_t from, size_t to, bool& first) {
-   if (from <= t->leftMin && to >= t->rightMax) {
-      //direct match
-      if (first) {
-         memcpy(result, t->state, stateTypeSize);
-         first = false;
-      } else {
-         combineStatesFn(result, result, t->state);
+   size_t begin = from;
+   size_t end = std::min(to + 1, levelSizes[0]);
+   //partial groups on the right are aggregated last, in reverse order, to keep the order of the states
+   std::array<std::pair<size_t, size_t>, maxLevels> rightRanges;
+   size_t level = 0;
+   while (begin < end) {
+      size_t parentBegin = (begin + fanout - 1) / fanout;
+      size_t parentEnd = end / fanout;
+      if (level + 1 == levelSizes.size() || parentBegin >= parentEnd) {
+         aggregate(result, level, begin, end, first);
+         break;
       }
-   } else if (from <= t->rightMax && to >= t->leftMin) {
-      //partial match
-      lookupRecursively(t->left, result, from, to, first);
-      lookupRecursively(t->right, result, from, to, first);
+      aggregate(result, level, begin, parentBegin * fanout, first);
+      rightRanges[level] = {parentEnd * fanout, end};
+      begin = parentBegin;
+      end = parentEnd;
+      level++;
+   }
+   for (size_t i = level; i > 0; i--) {
+      aggregate(result, i - 1, rightRanges[i - 1].first, rightRanges[i - 1].second, first);
    }
 }
 SegmentTreeView* SegmentTreeView::build(Buffer buffer, size_t typeSize, void (*createInitialStateFn)(unsigned char*, unsigned char*), void (*combineStatesFn)(unsigned char*, unsigned char*, unsigned char*), size_t stateTypeSize) {
    utility::Tracer::Trace trace(buildEvent);
    auto* executionContext = runtime::getCurrentExecutionContext();
-   std::vector<uint8_t*> entryPointers;
    auto numElements = buffer.numElements / typeSize;
-   for (size_t i = 0; i < numElements; i++) {
-      entryPointers.push_back(&buffer.ptr[i * typeSize]);
-   }
    if (stateTypeSize % 8 != 0) {
       stateTypeSize += 8 - stateTypeSize % 8;
    }
    auto* view = new SegmentTreeView;
    executionContext->registerState({view, [](void* ptr) { delete reinterpret_cast<SegmentTreeView*>(ptr); }});
    view->stateTypeSize = stateTypeSize;
-   view->numEntries = numElements * 2 - 1;
-   view->storage = lingodb::runtime::FixedSizedBuffer<TreeNode>::createZeroed(view->numEntries);
-   view->stateStorage = lingodb::runtime::FixedSizedBuffer<uint8_t>::createZeroed(view->numEntries * stateTypeSize);
+   view->fanout = std::max<int64_t>(segmentTreeFanout.getValue(), 2);
    view->combineStatesFn = combineStatesFn;
    view->createInitialStateFn = createInitialStateFn;
-
-   if (entryPointers.empty()) {
-      view->root = nullptr;
-   } else {
-      view->root = view->buildRecursively(entryPointers, 0, entryPointers.size() - 1);
+   view->numStates = 0;
+   for (size_t levelSize = numElements; levelSize; levelSize = levelSize == 1 ? 0 : (levelSize + view->fanout - 1) / view->fanout) {
+      view->levelOffsets.push_back(view->numStates);
+      view->levelSizes.push_back(levelSize);
+      view->numStates += levelSize;
+   }
+   assert(view->levelSizes.size() <= maxLevels);
+   view->stateStorage = lingodb::runtime::FixedSizedBuffer<uint8_t>::createZeroed(view->numStates * stateTypeSize);
+   //every level only depends on the one below, the states of one level are computed in parallel
+   for (size_t level = 0; level < view->levelSizes.size(); level++) {
+      view->buildLevel(level, buffer.ptr, typeSize);
    }
+   trace.stop();
    return view;
 }
 SegmentTreeView::~SegmentTreeView() {
-   FixedSizedBuffer<TreeNode>::deallocate(storage, numEntries);
+   FixedSizedBuffer<uint8_t>::deallocate(stateStorage, numStates * stateTypeSize);
 }
-} // namespace lingodb::runtime
\ No newline at end of file
+} // namespace lingodb::runtime
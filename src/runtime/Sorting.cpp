@@ -3,7 +3,10 @@
 #include "lingodb/scheduler/Tasks.h"
 #include "lingodb/utility/Tracer.h"
 
+#include <array>
+#include <bit>
 #include <cstring>
+#include <limits>
 #include <queue>
 
 namespace {
@@ -13,6 +16,10 @@ static lingodb::utility::Tracer::Event sortLocalEvent("GrowingBuffer", "sortLoca
 static lingodb::utility::Tracer::Event sortSepSearchEvent("GrowingBuffer", "sortSepSearch");
 static lingodb::utility::Tracer::Event sortOutputRangeEvent("GrowingBuffer", "sortOutputRange");
 static lingodb::utility::Tracer::Event sortMergeEvent("GrowingBuffer", "sortMerge");
+static lingodb::utility::Tracer::Event radixSortKeysEvent("GrowingBuffer", "radixSortKeys");
+static lingodb::utility::Tracer::Event radixSortPartitionEvent("GrowingBuffer", "radixSortPartition");
+static lingodb::utility::Tracer::Event radixSortBucketEvent("GrowingBuffer", "radixSortBucket");
+static lingodb::utility::Tracer::Event radixSortCopyEvent("GrowingBuffer", "radixSortCopy");
 
 struct SortSplitState {
    size_t begin{0};
@@ -61,6 +68,9 @@ class SortCopyTask : public lingodb::scheduler::TaskWithImplicitContext {
       workerResvs[lingodb::scheduler::currentWorkerId()] = localStartIndex;
       return true;
    }
+   size_t maxParallelism() override {
+      return buffers.size();
+   }
    void performWork() override {
       lingodb::utility::Tracer::Trace trace(sortCopyEvent);
       auto localStartIndex = workerResvs[lingodb::scheduler::currentWorkerId()];
@@ -102,6 +112,9 @@ class SortLocalTask : public lingodb::scheduler::TaskWithImplicitContext {
       workerResvs[lingodb::scheduler::currentWorkerId()] = localStartIndex;
       return true;
    }
+   size_t maxParallelism() override {
+      return sctx.splitCnt;
+   }
    void performWork() override {
       lingodb::utility::Tracer::Trace trace1(sortLocalEvent);
       auto localStartIndex = workerResvs[lingodb::scheduler::currentWorkerId()];
@@ -157,6 +170,9 @@ class SortSepSearchTask : public lingodb::scheduler::TaskWithImplicitContext {
       workerResvs[lingodb::scheduler::currentWorkerId()] = localStartIndex;
       return true;
    }
+   size_t maxParallelism() override {
+      return sctx.seperatorCnt;
+   }
    void performWork() override {
       lingodb::utility::Tracer::Trace trace3(sortSepSearchEvent);
       auto workerId = lingodb::scheduler::currentWorkerId();
@@ -236,6 +252,9 @@ class SortMergeTask : public lingodb::scheduler::TaskWithImplicitContext {
       workerResvs[lingodb::scheduler::currentWorkerId()] = localStartIndex;
       return true;
    }
+   size_t maxParallelism() override {
+      return sctx.seperatorCnt + 1;
+   }
 
    void performWork() override {
       lingodb::utility::Tracer::Trace trace5(sortMergeEvent);
@@ -334,6 +353,69 @@ void calcSplitSeperator(size_t inputSize, size_t workerNum, size_t& splitCnt, si
    seperatorCnt = workerNum * 2;
    normalizeSepCnt();
 }
+
+// normalized key (prefix) of an entry together with the entry
+struct KeyedEntry {
+   uint64_t key;
+   uint8_t* ptr;
+};
+
+
+const size_t radixBuckets = 256;
+// below this size, ranges are sorted with std::sort on the keys
+const size_t minRadixSortSize = 64;
+
+// entries with equal keys are ordered by the comparator
+void sortTies(KeyedEntry* begin, KeyedEntry* end, bool (*compareFn)(uint8_t*, uint8_t*)) {
+   while (begin < end) {
+      auto* tieEnd = begin + 1;
+      while (tieEnd < end && tieEnd->key == begin->key) {
+         tieEnd++;
+      }
+      if (tieEnd - begin > 1) {
+         std::sort(begin, tieEnd, [&](const KeyedEntry& l, const KeyedEntry& r) { return compareFn(l.ptr, r.ptr); });
+      }
+      begin = tieEnd;
+   }
+}
+
+// MSD radix sort on the bytes of the key, starting with the byte at `shift`. `tmp` must have the same size as the range.
+void msdRadixSort(KeyedEntry* begin, KeyedEntry* end, KeyedEntry* tmp, int shift, bool (*compareFn)(uint8_t*, uint8_t*)) {
+   size_t n = end - begin;
+   if (shift < 0) {
+      // all keys are equal
+      std::sort(begin, end, [&](const KeyedEntry& l, const KeyedEntry& r) { return compareFn(l.ptr, r.ptr); });
+      return;
+   }
+   if (n < minRadixSortSize) {
+      std::sort(begin, end, [](const KeyedEntry& l, const KeyedEntry& r) { return l.key < r.key; });
+      sortTies(begin, end, compareFn);
+      return;
+   }
+   size_t offsets[radixBuckets + 1] = {0};
+   for (auto* it = begin; it < end; it++) {
+      offsets[((it->key >> shift) & 0xff) + 1]++;
+   }
+   for (size_t i = 0; i < radixBuckets; i++) {
+      if (offsets[i + 1] == n) {
+         // the byte does not distinguish any entries
+         msdRadixSort(begin, end, tmp, shift - 8, compareFn);
+         return;
+      }
+      offsets[i + 1] += offsets[i];
+   }
+   size_t positions[radixBuckets];
+   std::copy(offsets, offsets + radixBuckets, positions);
+   for (auto* it = begin; it < end; it++) {
+      tmp[positions[(it->key >> shift) & 0xff]++] = *it;
+   }
+   std::copy(tmp, tmp + n, begin);
+   for (size_t i = 0; i < radixBuckets; i++) {
+      if (offsets[i + 1] - offsets[i] > 1) {
+         msdRadixSort(begin + offsets[i], begin + offsets[i + 1], tmp + offsets[i], shift - 8, compareFn);
+      }
+   }
+}
 } //end namespace
 
 namespace lingodb::runtime {
@@ -348,7 +430,7 @@ lingodb::runtime::Buffer parallelSort(lingodb::runtime::FlexibleBuffer& values,
 
    // Step 1 local sort and calculate local seperators
    size_t splitCnt, seperatorCnt;
-   calcSplitSeperator(values.getLen(), lingodb::scheduler::getNumWorkers(), splitCnt, seperatorCnt);
+   calcSplitSeperator(values.getLen(), lingodb::scheduler::getNumActiveWorkers(), splitCnt, seperatorCnt);
    std::vector<SortSplitState> localStates;
    localStates.reserve(splitCnt);
    SortContext sctx = SortContext(toSort, splitCnt, seperatorCnt, values.getTypeSize(), compareFn, localStates);
@@ -391,4 +473,141 @@ lingodb::runtime::Buffer parallelSort(lingodb::runtime::FlexibleBuffer& values,
 
    return lingodb::runtime::Buffer{typeSize * len, sorted};
 }
+lingodb::runtime::Buffer radixSort(lingodb::runtime::FlexibleBuffer& values, bool (*compareFn)(uint8_t*, uint8_t*), uint64_t (*keyFn)(uint8_t*)) {
+   size_t len = values.getLen();
+   size_t typeSize = values.getTypeSize();
+   const auto& buffers = values.getBuffers();
+   bool parallel = canParallelSort(len);
+
+   // Step 1 compute the keys, and the smallest and largest key of every buffer
+   utility::Tracer::Trace trace1(sortAllocEvent);
+   std::vector<KeyedEntry> entries(len);
+   std::vector<KeyedEntry> tmp(len);
+   trace1.stop();
+   std::vector<size_t> bufferOffsets;
+   size_t cnt = 0;
+   for (auto buffer : buffers) {
+      bufferOffsets.push_back(cnt);
+      cnt += buffer.numElements;
+   }
+   std::vector<std::pair<uint64_t, uint64_t>> minMax(buffers.size(), {std::numeric_limits<uint64_t>::max(), 0});
+   std::function<void(size_t)> computeKeys = [&](size_t bufferId) {
+      utility::Tracer::Trace trace(radixSortKeysEvent);
+      auto buffer = buffers[bufferId];
+      auto* out = &entries[bufferOffsets[bufferId]];
+      auto& [min, max] = minMax[bufferId];
+      for (size_t i = 0; i < buffer.numElements; i++) {
+         auto* ptr = &buffer.ptr[i * typeSize];
+         uint64_t key = keyFn(ptr);
+         out[i] = {key, ptr};
+         min = std::min(min, key);
+         max = std::max(max, key);
+      }
+      trace.stop();
+   };
+   if (parallel) {
+      lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(buffers.size(), computeKeys));
+   } else {
+      for (size_t i = 0; i < buffers.size(); i++) {
+         computeKeys(i);
+      }
+   }
+   uint64_t min = std::numeric_limits<uint64_t>::max();
+   uint64_t max = 0;
+   for (auto [bufferMin, bufferMax] : minMax) {
+      min = std::min(min, bufferMin);
+      max = std::max(max, bufferMax);
+   }
+   // all keys share the bytes above the highest bit in which the smallest and the largest key differ
+   int shift = min < max ? (63 - std::countl_zero(min ^ max)) / 8 * 8 : -8;
+
+   // Step 2 partition by the first distinguishing byte, then sort every bucket on its own
+   if (!parallel || shift < 0) {
+      msdRadixSort(entries.data(), entries.data() + len, tmp.data(), shift, compareFn);
+   } else {
+      utility::Tracer::Trace trace2(radixSortPartitionEvent);
+      size_t numChunks = std::min(lingodb::scheduler::getNumWorkers() * 4, (len + minSplitSize - 1) / minSplitSize);
+      size_t chunkSize = (len + numChunks - 1) / numChunks;
+      std::vector<std::array<size_t, radixBuckets>> histograms(numChunks);
+      std::function<void(size_t)> countChunk = [&](size_t chunk) {
+         auto& histogram = histograms[chunk];
+         histogram.fill(0);
+         for (size_t i = chunk * chunkSize; i < std::min(len, (chunk + 1) * chunkSize); i++) {
+            histogram[(entries[i].key >> shift) & 0xff]++;
+         }
+      };
+      lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(numChunks, countChunk));
+      // turn the histograms into the start position of every chunk in every bucket
+      std::vector<size_t> bucketOffsets(radixBuckets + 1);
+      size_t pos = 0;
+      for (size_t bucket = 0; bucket < radixBuckets; bucket++) {
+         bucketOffsets[bucket] = pos;
+         for (auto& histogram : histograms) {
+            auto count = histogram[bucket];
+            histogram[bucket] = pos;
+            pos += count;
+         }
+      }
+      bucketOffsets[radixBuckets] = pos;
+      std::function<void(size_t)> scatterChunk = [&](size_t chunk) {
+         auto& positions = histograms[chunk];
+         for (size_t i = chunk * chunkSize; i < std::min(len, (chunk + 1) * chunkSize); i++) {
+            tmp[positions[(entries[i].key >> shift) & 0xff]++] = entries[i];
+         }
+      };
+      lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(numChunks, scatterChunk));
+      trace2.stop();
+      std::swap(entries, tmp);
+      std::function<void(size_t)> sortBucket = [&](size_t bucket) {
+         utility::Tracer::Trace trace(radixSortBucketEvent);
+         auto begin = bucketOffsets[bucket];
+         auto end = bucketOffsets[bucket + 1];
+         if (end - begin > 1) {
+            msdRadixSort(&entries[begin], &entries[end], &tmp[begin], shift - 8, compareFn);
+         }
+         trace.stop();
+      };
+      lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(radixBuckets, sortBucket));
+   }
+
+   // Step 3 copy the entries to the output in sorted order
+   utility::Tracer::Trace trace3(sortAllocEvent);
+   uint8_t* sorted = new uint8_t[typeSize * len];
+   trace3.stop();
+   auto* executionContext = lingodb::runtime::getCurrentExecutionContext();
+   executionContext->registerState({sorted, [](void* ptr) { delete[] reinterpret_cast<uint8_t*>(ptr); }});
+   size_t numCopyChunks = parallel ? lingodb::scheduler::getNumWorkers() * 4 : 1;
+   size_t copyChunkSize = (len + numCopyChunks - 1) / numCopyChunks;
+   std::function<void(size_t)> copyChunk = [&](size_t chunk) {
+      utility::Tracer::Trace trace(radixSortCopyEvent);
+      for (size_t i = chunk * copyChunkSize; i < std::min(len, (chunk + 1) * copyChunkSize); i++) {
+         memcpy(&sorted[i * typeSize], entries[i].ptr, typeSize);
+      }
+      trace.stop();
+   };
+   if (parallel) {
+      lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(numCopyChunks, copyChunk));
+   } else {
+      copyChunk(0);
+   }
+   return lingodb::runtime::Buffer{typeSize * len, sorted};
+}
+void radixSortPointers(std::vector<uint8_t*>& entries, bool (*compareFn)(uint8_t*, uint8_t*), uint64_t (*keyFn)(uint8_t*)) {
+   size_t len = entries.size();
+   std::vector<KeyedEntry> keyed(len);
+   std::vector<KeyedEntry> tmp(len);
+   uint64_t min = std::numeric_limits<uint64_t>::max();
+   uint64_t max = 0;
+   for (size_t i = 0; i < len; i++) {
+      uint64_t key = keyFn(entries[i]);
+      keyed[i] = {key, entries[i]};
+      min = std::min(min, key);
+      max = std::max(max, key);
+   }
+   int shift = min < max ? (63 - std::countl_zero(min ^ max)) / 8 * 8 : -8;
+   msdRadixSort(keyed.data(), keyed.data() + len, tmp.data(), shift, compareFn);
+   for (size_t i = 0; i < len; i++) {
+      entries[i] = keyed[i].ptr;
+   }
+}
 } // end namespace lingodb::runtime
\ No newline at end of file
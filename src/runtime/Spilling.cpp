@@ -0,0 +1,73 @@
+#include "lingodb/runtime/Spilling.h"
+#include "lingodb/utility/Setting.h"
+#include "lingodb/utility/Tracer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+namespace {
+//memory (in bytes) a single query may use for spillable operator state before it is written to disk (0: unlimited)
+lingodb::utility::GlobalSetting<int64_t> memoryBudgetSetting("system.memory_budget", 0);
+//directory for temporary spill files (empty: system temp directory)
+lingodb::utility::GlobalSetting<std::string> spillDirSetting("system.spill_dir", "");
+static lingodb::utility::Tracer::Event spillWriteEvent("Spilling", "write");
+static lingodb::utility::Tracer::Event spillReadEvent("Spilling", "read");
+} // end namespace
+
+std::unique_ptr<lingodb::runtime::SpillFile> lingodb::runtime::SpillFile::create() {
+   std::string dir = spillDirSetting.getValue();
+   if (dir.empty()) {
+      dir = std::filesystem::temp_directory_path().string();
+   }
+   std::string path = dir + "/lingodb-spill-XXXXXX";
+   int fd = mkstemp(path.data());
+   if (fd < 0) {
+      throw std::runtime_error("could not create spill file in " + dir + ": " + std::strerror(errno));
+   }
+   //the file is removed as soon as it is closed
+   unlink(path.c_str());
+   return std::unique_ptr<SpillFile>(new SpillFile(fd));
+}
+size_t lingodb::runtime::SpillFile::append(const void* data, size_t len) {
+   utility::Tracer::Trace trace(spillWriteEvent);
+   size_t offset = size.fetch_add(len);
+   const auto* ptr = reinterpret_cast<const uint8_t*>(data);
+   size_t written = 0;
+   while (written < len) {
+      auto res = pwrite(fd, ptr + written, len - written, offset + written);
+      if (res < 0) {
+         if (errno == EINTR) continue;
+         throw std::runtime_error(std::string("writing spill file failed: ") + std::strerror(errno));
+      }
+      written += res;
+   }
+   trace.stop();
+   return offset;
+}
+void lingodb::runtime::SpillFile::read(size_t offset, void* data, size_t len) const {
+   utility::Tracer::Trace trace(spillReadEvent);
+   auto* ptr = reinterpret_cast<uint8_t*>(data);
+   size_t read = 0;
+   while (read < len) {
+      auto res = pread(fd, ptr + read, len - read, offset + read);
+      if (res < 0) {
+         if (errno == EINTR) continue;
+         throw std::runtime_error(std::string("reading spill file failed: ") + std::strerror(errno));
+      }
+      if (res == 0) {
+         throw std::runtime_error("reading spill file failed: unexpected end of file");
+      }
+      read += res;
+   }
+   trace.stop();
+}
+lingodb::runtime::SpillFile::~SpillFile() {
+   close(fd);
+}
+lingodb::runtime::MemoryBudget::MemoryBudget() : limit(std::max<int64_t>(0, memoryBudgetSetting.getValue())), used(0) {}
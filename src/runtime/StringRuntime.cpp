@@ -328,6 +328,9 @@ size_t lingodb::runtime::StringRuntime::findNext(VarLen32 str, VarLen32 needle,
    if (found == std::string::npos) return invalidPos;
    return found;
 }
+uint64_t lingodb::runtime::StringRuntime::sortKey(VarLen32 str) {
+   return __builtin_bswap64(read8PadZero(reinterpret_cast<const uint8_t*>(str.data()), std::min<uint32_t>(str.getLen(), 8)));
+}
 namespace {
 void toUpper(char* str, size_t len) {
    for (auto i = 0ul; i < len; i++) {
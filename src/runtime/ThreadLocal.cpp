@@ -1,8 +1,11 @@
 #include "lingodb/runtime/ThreadLocal.h"
+#include "lingodb/scheduler/Tasks.h"
 #include "lingodb/utility/Tracer.h"
+
 namespace {
 static lingodb::utility::Tracer::Event getLocalEvent("ThreadLocal", "getLocal");
 static lingodb::utility::Tracer::Event mergeEvent("ThreadLocal", ",merge");
+static lingodb::utility::Tracer::Event mergePairEvent("ThreadLocal", "mergePair");
 } // end namespace
 uint8_t* lingodb::runtime::ThreadLocal::getLocal() {
    utility::Tracer::Trace trace(getLocalEvent);
@@ -16,19 +19,43 @@ lingodb::runtime::ThreadLocal* lingodb::runtime::ThreadLocal::create(uint8_t* (*
    return new ThreadLocal(initFn, initArg);
 }
 
-uint8_t* lingodb::runtime::ThreadLocal::merge(void (*mergeFn)(uint8_t*, uint8_t*)) {
-   utility::Tracer::Trace trace(mergeEvent);
-   uint8_t* first = nullptr;
-   for (auto* ptr : getThreadLocalValues<uint8_t>()) {
+uint8_t* lingodb::runtime::ThreadLocal::reduceParallel(std::span<uint8_t*> values, const std::function<void(uint8_t*, uint8_t*)>& mergeFn) {
+   std::vector<uint8_t*> current;
+   for (auto* ptr : values) {
       if (ptr) {
-         auto* current = ptr;
-         if (!first) {
-            first = current;
-         } else {
-            mergeFn(first, current);
+         current.push_back(ptr);
+      }
+   }
+   if (current.empty()) {
+      return nullptr;
+   }
+   //pairwise merging keeps the order of the values, i.e., merge(a,b) is always called with a preceding b
+   while (current.size() > 1) {
+      if (current.size() <= 3) {
+         //not worth spawning a task
+         for (size_t i = 1; i < current.size(); i++) {
+            mergeFn(current[0], current[i]);
          }
+         break;
       }
+      //one round of the tree reduction: merges current[2*i+1] into current[2*i] for all pairs
+      lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(current.size() / 2, [&](size_t pair) {
+         utility::Tracer::Trace trace(mergePairEvent);
+         mergeFn(current[2 * pair], current[2 * pair + 1]);
+         trace.stop();
+      }));
+      std::vector<uint8_t*> next;
+      for (size_t i = 0; i < current.size(); i += 2) {
+         next.push_back(current[i]);
+      }
+      current = std::move(next);
    }
+   return current[0];
+}
+
+uint8_t* lingodb::runtime::ThreadLocal::merge(void (*mergeFn)(uint8_t*, uint8_t*)) {
+   utility::Tracer::Trace trace(mergeEvent);
+   auto* first = reduceParallel(getThreadLocalValues<uint8_t>(), mergeFn);
    trace.stop();
    return first;
 }
@@ -1,4 +1,18 @@
 #include "lingodb/runtime/helpers.h"
+#include "lingodb/scheduler/Scheduler.h"
+#include "lingodb/utility/Setting.h"
+
+#include <algorithm>
+namespace {
+//upper bound for the memory that all workers together reserve for presized states up front
+lingodb::utility::GlobalSetting<int64_t> presizeMaxBytes("system.presize.max_bytes", 64 << 20);
+//initial capacity that is always granted, matches the former default of the generated code
+constexpr size_t minInitialCapacity = 1024;
+} // end namespace
+size_t lingodb::runtime::clampInitialCapacity(size_t initialCapacity, size_t typeSize) {
+   size_t maxCapacity = presizeMaxBytes.getValue() / (lingodb::scheduler::getNumWorkers() * std::max(typeSize, static_cast<size_t>(1)));
+   return std::max(std::min(initialCapacity, std::max(maxCapacity, minInitialCapacity)), static_cast<size_t>(1));
+}
 alignas(4096) uint16_t lingodb::runtime::bloomMasks[2048] = {
    // The 1820 distinct bit-patterns
    15, 23, 27, 29, 30, 39, 43, 45, 46, 51, 53, 54, 57, 58, 60, 71, 75, 77, 78, 83, 85, 86, 89, 90, 92, 99, 101, 102, 105, 106, 108, 113, 114, 116, 120, 135, 139, 141, 142, 147, 149, 150, 153, 154, 156, 163, 165, 166, 169, 170, 172, 177, 178, 180, 184, 195, 197, 198, 201, 202, 204, 209, 210, 212, 216, 225, 226, 228, 232, 240, 263, 267, 269, 270, 275, 277, 278, 281, 282, 284, 291, 293, 294, 297, 298, 300, 305, 306, 308, 312, 323, 325, 326, 329, 330, 332, 337, 338, 340, 344, 353, 354, 356, 360, 368, 387, 389, 390, 393, 394, 396, 401, 402, 404, 408, 417, 418, 420, 424, 432, 449, 450, 452, 456, 464, 480, 519, 523,
@@ -482,6 +482,9 @@ class ScanBatchesSingleThreadedTask : public lingodb::scheduler::TaskWithImplici
       }
       return false;
    }
+   size_t maxParallelism() override {
+      return 1;
+   }
    void performWork() override {
       BatchView batchView;
       std::vector<const ArrayView*> arrayViewPtrs(colIds.size());
@@ -1,4 +1,6 @@
+#include "lingodb/utility/Setting.h"
 #include "lingodb/utility/Tracer.h"
+#include <algorithm>
 #include <atomic>
 #include <boost/context/fiber.hpp>
 #include <condition_variable>
@@ -8,39 +10,196 @@
 #include <memory>
 #include <thread>
 
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "lingodb/scheduler/Parker.h"
 #include "lingodb/scheduler/Scheduler.h"
 #include "lingodb/scheduler/Task.h"
 
 namespace lingodb::scheduler {
 class Worker;
 
+namespace {
+//upper bound for the number of iterations an idle worker spins before it blocks (0: never spin)
+utility::GlobalSetting<int64_t> spinBudgetSetting("system.scheduler.spin_budget", 4096);
+
+uint64_t nowNs() {
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+} // end namespace
+
+//metric counters of one worker: only written by the worker itself, but may be read concurrently
+struct alignas(64) WorkerCounters {
+   std::atomic<uint64_t> tasksExecuted{0};
+   std::atomic<uint64_t> tasksFetched{0};
+   std::atomic<uint64_t> fibersYielded{0};
+   std::atomic<uint64_t> fibersResumed{0};
+   std::atomic<uint64_t> busyNs{0};
+   std::atomic<uint64_t> sleepNs{0};
+   std::atomic<uint64_t> taskQueueLockWaitNs{0};
+   uint64_t startNs = nowNs();
+
+   //single writer -> no need for an atomic read-modify-write
+   static void add(std::atomic<uint64_t>& counter, uint64_t value) {
+      counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+   }
+   WorkerMetrics snapshot(size_t workerId) const {
+      WorkerMetrics metrics;
+      metrics.workerId = workerId;
+      metrics.tasksExecuted = tasksExecuted.load(std::memory_order_relaxed);
+      metrics.tasksFetched = tasksFetched.load(std::memory_order_relaxed);
+      metrics.fibersYielded = fibersYielded.load(std::memory_order_relaxed);
+      metrics.fibersResumed = fibersResumed.load(std::memory_order_relaxed);
+      metrics.busyNs = busyNs.load(std::memory_order_relaxed);
+      metrics.sleepNs = sleepNs.load(std::memory_order_relaxed);
+      metrics.taskQueueLockWaitNs = taskQueueLockWaitNs.load(std::memory_order_relaxed);
+      auto totalNs = nowNs() - startNs;
+      auto accountedNs = metrics.busyNs + metrics.sleepNs;
+      metrics.idleNs = totalNs > accountedNs ? totalNs - accountedNs : 0;
+      return metrics;
+   }
+};
+namespace {
+static thread_local WorkerCounters* currentWorkerCounters = nullptr;
+} // end namespace
+
 struct TaskWrapper;
 
-class Fiber {
+//stack memory for fibers: the address range is only reserved (not committed) when mapped,
+//the OS commits pages lazily on first touch. The lowest page is a guard page, so that a stack overflow crashes instead of corrupting memory.
+struct FiberStack {
+   void* base = nullptr; //start of the mapping (incl. guard page)
+   size_t size = 0; //size of the mapping (incl. guard page)
+};
+
+//process-wide pool of fiber stacks shared by all workers.
+//Released stacks are kept for reuse, but the pool is periodically trimmed down to the high-water mark of stacks in use since the last trim.
+//The pages of a released stack are given back to the OS, except for the top of the stack that is touched by almost every fiber.
+class FiberStackPool {
    static constexpr size_t stackSize = 1 << 20;
+   //bytes at the top of a cached stack that stay committed
+   static constexpr size_t committedTopSize = 64 << 10;
+   std::mutex mutex;
+   std::vector<FiberStack> available;
+   size_t inUse = 0;
+   size_t highWaterMark = 0;
+   size_t pageSize;
+
+   FiberStack map() {
+      size_t mappingSize = stackSize + pageSize;
+      int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+      flags |= MAP_NORESERVE;
+#endif
+#ifdef MAP_STACK
+      flags |= MAP_STACK;
+#endif
+      void* base = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, flags, -1, 0);
+      if (base == MAP_FAILED) {
+         throw std::bad_alloc();
+      }
+      //stack grows downwards -> guard page at the lowest address
+      mprotect(base, pageSize, PROT_NONE);
+      return FiberStack{base, mappingSize};
+   }
+   static void unmap(FiberStack stack) {
+      munmap(stack.base, stack.size);
+   }
+
+   public:
+   FiberStackPool() : pageSize(sysconf(_SC_PAGESIZE)) {}
+   static FiberStackPool& get() {
+      static FiberStackPool pool;
+      return pool;
+   }
+   FiberStack acquire() {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         inUse++;
+         highWaterMark = std::max(highWaterMark, inUse);
+         if (!available.empty()) {
+            auto stack = available.back();
+            available.pop_back();
+            return stack;
+         }
+      }
+      return map();
+   }
+   void release(FiberStack stack) {
+      //the stack grows downwards: everything below the committed top is only used by deep call chains
+      madvise(static_cast<std::byte*>(stack.base) + pageSize, stackSize - committedTopSize, MADV_DONTNEED);
+      std::lock_guard<std::mutex> lock(mutex);
+      inUse--;
+      available.push_back(stack);
+   }
+   //unmaps all cached stacks that exceed the high-water mark since the last trim and starts a new period
+   void trim() {
+      std::vector<FiberStack> toUnmap;
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         size_t keep = highWaterMark > inUse ? highWaterMark - inUse : 0;
+         while (available.size() > keep) {
+            toUnmap.push_back(available.back());
+            available.pop_back();
+         }
+         highWaterMark = inUse;
+      }
+      for (auto stack : toUnmap) {
+         unmap(stack);
+      }
+   }
+   FiberStackStats getStats() {
+      std::lock_guard<std::mutex> lock(mutex);
+      FiberStackStats stats;
+      stats.cachedStacks = available.size();
+      stats.inUse = inUse;
+#ifdef __linux__
+      std::vector<unsigned char> residency(stackSize / pageSize);
+      for (auto stack : available) {
+         if (mincore(static_cast<std::byte*>(stack.base) + pageSize, stackSize, residency.data()) == 0) {
+            for (auto page : residency) {
+               stats.cachedResidentBytes += (page & 1) * pageSize;
+            }
+         }
+      }
+#endif
+      return stats;
+   }
+   boost::context::stack_context toContext(FiberStack stack) {
+      boost::context::stack_context sctx;
+      sctx.size = stack.size - pageSize;
+      sctx.sp = static_cast<std::byte*>(stack.base) + stack.size;
+      return sctx;
+   }
+   ~FiberStackPool() {
+      for (auto stack : available) {
+         unmap(stack);
+      }
+   }
+};
 
+class Fiber {
    struct LocalAllocator {
       Fiber* fiber = nullptr;
 
       boost::context::stack_context allocate() {
-         assert(!fiber->stackAllocated);
-         boost::context::stack_context sctx;
-         sctx.size = stackSize;
-         sctx.sp = fiber->stackSpace + stackSize;
-         fiber->stackAllocated = true;
-         return sctx;
+         assert(!fiber->stack.base);
+         auto& pool = FiberStackPool::get();
+         fiber->stack = pool.acquire();
+         return pool.toContext(fiber->stack);
       }
 
       void deallocate(boost::context::stack_context&) noexcept {
-         assert(fiber->stackAllocated);
-         fiber->stackAllocated = false;
+         assert(fiber->stack.base);
+         FiberStackPool::get().release(fiber->stack);
+         fiber->stack = {};
       }
 
       friend class Fiber;
    };
 
-   alignas(64) std::byte stackSpace[stackSize];
-   bool stackAllocated = false;
+   FiberStack stack;
    std::atomic<bool> isRunning = false;
    bool done = true;
    boost::context::fiber fiber;
@@ -102,6 +261,8 @@ struct TaskWrapper {
    std::unique_ptr<Task> task;
 
    std::atomic<bool> coolingDown = false;
+   //set by the first call to Scheduler::finalizeTask
+   std::atomic<bool> removedFromQueues = false;
    bool finalized = false;
    TaskWrapper* next = nullptr;
    TaskWrapper* prev = nullptr;
@@ -143,12 +304,21 @@ struct TaskWrapper {
 
 class Scheduler {
    size_t numWorkers;
+   //workers with an id >= numActiveWorkers are parked and do not pick up new tasks
+   std::atomic<size_t> numActiveWorkers;
+   //all running workers (protected by taskQueueMutex)
+   std::vector<Worker*> workers;
 
    std::atomic<bool> shutdown{false};
    std::vector<std::thread> workerThreads;
    Worker* idleWorkers = nullptr;
+   size_t numIdleWorkers = 0;
    std::mutex taskQueueMutex;
    std::mutex taskReturnMutex;
+   std::vector<std::unique_ptr<WorkerCounters>> workerCounters;
+   //metrics at the time of the last reset
+   std::mutex metricsMutex;
+   std::vector<WorkerMetrics> metricsBaseline;
    TaskWrapper* taskHead = nullptr;
    TaskWrapper* taskTail = nullptr;
 
@@ -158,11 +328,48 @@ class Scheduler {
    TaskWrapper* coolingDownTail = nullptr;
 
    public:
-   Scheduler(size_t numWorkers = std::thread::hardware_concurrency()) : numWorkers(numWorkers) {
+   Scheduler(size_t numWorkers = std::thread::hardware_concurrency()) : numWorkers(numWorkers), numActiveWorkers(numWorkers), workers(numWorkers, nullptr) {
+      for (size_t i = 0; i < numWorkers; i++) {
+         workerCounters.push_back(std::make_unique<WorkerCounters>());
+      }
    }
    size_t getNumWorkers() {
       return numWorkers;
    }
+   size_t getNumActiveWorkers() {
+      return numActiveWorkers.load();
+   }
+   bool isParked(size_t workerId) {
+      return workerId >= numActiveWorkers.load();
+   }
+   void setNumActiveWorkers(size_t newNumActiveWorkers);
+   void registerWorker(Worker* worker, size_t workerId) {
+      auto lock = lockTaskQueue();
+      workers[workerId] = worker;
+   }
+
+   void parkWorker(Worker* worker);
+   //removes all parked workers from the idle list (requires the task queue lock)
+   void unlinkParkedIdleWorkers();
+
+   WorkerCounters& getWorkerCounters(size_t workerId) {
+      return *workerCounters[workerId];
+   }
+   std::vector<WorkerMetrics> getWorkerMetrics();
+   void resetWorkerMetrics();
+
+   //locks the task queue, and accounts the time spent waiting for the lock to the current worker
+   std::unique_lock<std::mutex> lockTaskQueue() {
+      std::unique_lock<std::mutex> lock(taskQueueMutex, std::try_to_lock);
+      if (!lock.owns_lock()) {
+         auto start = nowNs();
+         lock.lock();
+         if (currentWorkerCounters) {
+            WorkerCounters::add(currentWorkerCounters->taskQueueLockWaitNs, nowNs() - start);
+         }
+      }
+      return lock;
+   }
 
    void putWorkerToSleep(Worker* worker);
 
@@ -204,7 +411,7 @@ class Scheduler {
    }
 
    TaskWrapper* getTask() {
-      std::lock_guard<std::mutex> lock(taskQueueMutex);
+      auto lock = lockTaskQueue();
       auto* potentialTask = taskHead;
       size_t minYieldCount = std::numeric_limits<size_t>::max();
       TaskWrapper* minYieldTask = nullptr;
@@ -259,6 +466,11 @@ class Scheduler {
    }
 
    void finalizeTask(TaskWrapper* task) {
+      // finishFiber() can return true more than once for a task: a worker may pass the hasWork() check in startFiber()
+      // right before the last fiber finishes. The task must only be unlinked once, otherwise the stale prev/next pointers corrupt the queues.
+      if (task->removedFromQueues.exchange(true)) {
+         return;
+      }
       if (task->coolingDown) {
          //simple case: already in cooling down queue
          // -> only need to lock cooling down queue
@@ -278,7 +490,7 @@ class Scheduler {
          // -> need to lock both task queue and cooling down queue
          bool alreadyCoolingDown;
          {
-            std::lock_guard<std::mutex> lock(taskQueueMutex);
+            auto lock = lockTaskQueue();
             alreadyCoolingDown = task->coolingDown;
             if (!alreadyCoolingDown) {
                dequeueTaskLocked(task);
@@ -365,21 +577,23 @@ class Worker {
    //for cheaply collecting idle workers
    Worker* nextIdleWorker = nullptr;
    bool isInIdleList = false;
-   // for sleeping / waking up if there is nothing to do
+   //protects currentTask
    std::mutex mutex;
-   std::condition_variable cv;
+   // for sleeping / waking up if there is nothing to do
+   Parker parker;
    size_t workerId;
-   bool allowedToSleep = true;
+   WorkerCounters& counters;
 
-   Worker(Scheduler& scheduler, size_t id) : scheduler(scheduler), fiberAllocator(64), workerId(id) {
+   bool hasRunnableFibers() {
+      std::lock_guard<std::mutex> lock(fiberMutex);
+      return !runnableFibers.empty();
+   }
+
+   Worker(Scheduler& scheduler, size_t id) : scheduler(scheduler), fiberAllocator(64), parker(std::max<int64_t>(0, spinBudgetSetting.getValue())), workerId(id), counters(scheduler.getWorkerCounters(id)) {
    }
 
    void wakeupWorker() {
-      {
-         std::unique_lock<std::mutex> lock(mutex);
-         allowedToSleep = false;
-         cv.notify_one();
-      }
+      parker.unpark();
    }
 
    void awaitChildTask(std::unique_ptr<Task> task) {
@@ -404,6 +618,7 @@ class Worker {
          };
          scheduler.enqueueTask(taskWrapper);
       }
+      WorkerCounters::add(counters.fibersYielded, 1);
       toYield->yield();
    }
 
@@ -429,7 +644,11 @@ class Worker {
          if (currentFiber) {
             auto* relatedTask = currentFiber->getTask();
             relatedTask->task->setup();
-            if (currentFiber->resume()) {
+            WorkerCounters::add(counters.fibersResumed, 1);
+            auto resumeStart = nowNs();
+            bool resumedFiberDone = currentFiber->resume();
+            WorkerCounters::add(counters.busyNs, nowNs() - resumeStart);
+            if (resumedFiberDone) {
                relatedTask->task->teardown();
                //unyield because it was previously registered as yielded
                if (currentFiber->getTask()) {
@@ -444,6 +663,20 @@ class Worker {
             assert(!currentFiber);
          }
          if (fiberAllocator.canAllocate()) {
+            if (scheduler.isParked(workerId)) {
+               //not part of the active workers: give back the current task and only wake up again for fibers of this worker or when reactivated
+               TaskWrapper* toReturn;
+               {
+                  std::unique_lock<std::mutex> lock(mutex);
+                  toReturn = this->currentTask;
+                  this->currentTask = nullptr;
+               }
+               if (toReturn) {
+                  scheduler.returnTask(toReturn);
+               }
+               scheduler.parkWorker(this);
+               continue;
+            }
             TaskWrapper* currTask = nullptr;
             {
                std::unique_lock<std::mutex> lock(mutex);
@@ -459,6 +692,9 @@ class Worker {
             }
             if (!currTask) {
                currTask = scheduler.getTask();
+               if (currTask) {
+                  WorkerCounters::add(counters.tasksFetched, 1);
+               }
             }
 
             if (currTask) {
@@ -493,9 +729,12 @@ class Worker {
                assert(currentFiber);
                // Step 3. consume reserved work
                currTask->task->setup();
+               WorkerCounters::add(counters.tasksExecuted, 1);
+               auto runStart = nowNs();
                auto fiberDone = currentFiber->run(this, currTask, [&] {
                   currTask->task->performWork();
                });
+               WorkerCounters::add(counters.busyNs, nowNs() - runStart);
                currTask->task->teardown();
                if (fiberDone) {
                   this->startWaitTime = TimePoint::min();
@@ -552,9 +791,13 @@ void Scheduler::start() {
          utility::Tracer::ensureThreadLocalTraceRecordList();
 #endif
          Worker worker(*this, i);
+         registerWorker(&worker, i);
          currentWorker = &worker;
+         currentWorkerCounters = &worker.counters;
          worker.work();
+         currentWorkerCounters = nullptr;
          currentWorker = nullptr;
+         registerWorker(nullptr, i);
       });
    }
 }
@@ -568,13 +811,61 @@ void Scheduler::stop() {
       auto* currWorker = idleWorkers;
       currWorker->isInIdleList = false;
       idleWorkers = currWorker->nextIdleWorker;
-      currWorker->cv.notify_one();
+      numIdleWorkers--;
+      currWorker->wakeupWorker();
+   }
+   //parked workers are not in the idle list
+   for (auto* worker : workers) {
+      if (worker) {
+         worker->wakeupWorker();
+      }
+   }
+}
+
+void Scheduler::setNumActiveWorkers(size_t newNumActiveWorkers) {
+   newNumActiveWorkers = std::clamp<size_t>(newNumActiveWorkers, 1, numWorkers);
+   //the idle list only contains active workers: waking up a parked worker for a new task would lose the wakeup
+   // -> change the number of active workers and unlink the newly parked workers without letting enqueueTask see the list in between
+   auto lock = lockTaskQueue();
+   auto oldNumActiveWorkers = numActiveWorkers.exchange(newNumActiveWorkers);
+   unlinkParkedIdleWorkers();
+   //wake up all workers whose state changed: reactivated workers look for work, newly parked workers give back their task
+   for (size_t i = std::min(oldNumActiveWorkers, newNumActiveWorkers); i < std::max(oldNumActiveWorkers, newNumActiveWorkers); i++) {
+      if (workers[i]) {
+         workers[i]->wakeupWorker();
+      }
+   }
+}
+
+void Scheduler::unlinkParkedIdleWorkers() {
+   Worker** link = &idleWorkers;
+   while (*link) {
+      Worker* worker = *link;
+      if (isParked(worker->workerId)) {
+         *link = worker->nextIdleWorker;
+         worker->isInIdleList = false;
+         numIdleWorkers--;
+      } else {
+         link = &worker->nextIdleWorker;
+      }
+   }
+}
+
+void Scheduler::parkWorker(Worker* worker) {
+   //every event that invalidates one of these conditions unparks the worker afterwards -> no lost wakeups
+   if (!isShutdown() && isParked(worker->workerId) && !worker->hasRunnableFibers()) {
+      auto sleepStart = nowNs();
+      worker->parker.park();
+      WorkerCounters::add(worker->counters.sleepNs, nowNs() - sleepStart);
    }
 }
 
 void Scheduler::enqueueTask(TaskWrapper* wrapper) {
+   //only wake up as many idle workers as can work on the new task concurrently
+   //(read before enqueueing: once the task is in the queue, a busy worker may finish and destroy it)
+   size_t toWake = wrapper->task->maxParallelism();
    {
-      std::lock_guard<std::mutex> lock(taskQueueMutex);
+      auto lock = lockTaskQueue();
       if (taskTail) {
          taskTail->next = wrapper;
          wrapper->prev = taskTail;
@@ -584,36 +875,51 @@ void Scheduler::enqueueTask(TaskWrapper* wrapper) {
          taskTail = wrapper;
       }
    }
-   std::lock_guard<std::mutex> lock(taskQueueMutex);
+   auto lock = lockTaskQueue();
    size_t cntr = 0;
-   while (idleWorkers) {
+   while (idleWorkers && toWake > 0) {
       assert(cntr++ < numWorkers);
       Worker* currWorker = idleWorkers;
-      std::unique_lock<std::mutex> workerLock(currWorker->mutex);
+      assert(!isParked(currWorker->workerId));
       currWorker->isInIdleList = false;
       idleWorkers = idleWorkers->nextIdleWorker;
+      numIdleWorkers--;
+      toWake--;
 
-      currWorker->cv.notify_one();
+      currWorker->wakeupWorker();
    }
 }
 
 void Scheduler::putWorkerToSleep(Worker* worker) {
-   if (isShutdown()) {
+   if (isShutdown() || worker->hasRunnableFibers()) {
+      //several fibers can become runnable with a single wakeup: only sleep once all of them were resumed
       return;
    }
-   std::unique_lock<std::mutex> lock(taskQueueMutex);
-   std::unique_lock<std::mutex> workerLock(worker->mutex);
-   if (worker->allowedToSleep) {
-      if (!worker->isInIdleList) {
-         worker->nextIdleWorker = idleWorkers;
-         idleWorkers = worker;
-         worker->isInIdleList = true;
-      }
-      lock.unlock();
-      worker->cv.wait(workerLock);
-   } else {
-      worker->allowedToSleep = true;
+   auto lock = lockTaskQueue();
+   if (taskHead) {
+      //a task was enqueued after this worker looked for work, but before it was added to the idle list -> it would not be woken up
+      return;
+   }
+   if (isParked(worker->workerId)) {
+      //deactivated after looking for work: parked workers must not be in the idle list, the work loop parks this worker instead
+      return;
+   }
+   if (!worker->isInIdleList) {
+      worker->nextIdleWorker = idleWorkers;
+      idleWorkers = worker;
+      worker->isInIdleList = true;
+      numIdleWorkers++;
+   }
+   bool allIdle = numIdleWorkers >= getNumActiveWorkers();
+   lock.unlock();
+   if (allIdle) {
+      //scheduler became idle: give back fiber stacks that were not needed during the last period
+      FiberStackPool::get().trim();
    }
+   // a wakeup after the idle list was updated is not lost, the parker keeps the token
+   auto sleepStart = nowNs();
+   worker->parker.park();
+   WorkerCounters::add(worker->counters.sleepNs, nowNs() - sleepStart);
 }
 
 void TaskWrapper::finalize() {
@@ -628,13 +934,18 @@ void TaskWrapper::finalize() {
 
 void awaitEntryTask(std::unique_ptr<Task> task) {
    TaskWrapper* taskWrapper = new TaskWrapper{std::move(task)};
+   // do not wait on the task wrapper's mutex: the wrapper may be deleted by a worker as soon as it is finalized
+   std::mutex finishedMutex;
    std::condition_variable finished;
+   bool isFinished = false;
    taskWrapper->onFinalize = [&]() {
+      std::lock_guard<std::mutex> lock(finishedMutex);
+      isFinished = true;
       finished.notify_one();
    };
-   std::unique_lock<std::mutex> lk(taskWrapper->finalizeMutex);
    scheduler->enqueueTask(taskWrapper);
-   finished.wait(lk);
+   std::unique_lock<std::mutex> lk(finishedMutex);
+   finished.wait(lk, [&] { return isFinished; });
 }
 void awaitChildTask(std::unique_ptr<Task> task) {
    currentWorker->awaitChildTask(std::move(task));
@@ -676,6 +987,59 @@ size_t getNumWorkers() {
    }
    return scheduler->getNumWorkers();
 }
+std::vector<WorkerMetrics> Scheduler::getWorkerMetrics() {
+   std::lock_guard<std::mutex> lock(metricsMutex);
+   std::vector<WorkerMetrics> res;
+   for (size_t i = 0; i < workerCounters.size(); i++) {
+      auto current = workerCounters[i]->snapshot(i);
+      if (i < metricsBaseline.size()) {
+         auto& base = metricsBaseline[i];
+         current.tasksExecuted -= base.tasksExecuted;
+         current.tasksFetched -= base.tasksFetched;
+         current.fibersYielded -= base.fibersYielded;
+         current.fibersResumed -= base.fibersResumed;
+         current.busyNs -= base.busyNs;
+         current.sleepNs -= base.sleepNs;
+         current.idleNs = current.idleNs > base.idleNs ? current.idleNs - base.idleNs : 0;
+         current.taskQueueLockWaitNs -= base.taskQueueLockWaitNs;
+      }
+      res.push_back(current);
+   }
+   return res;
+}
+void Scheduler::resetWorkerMetrics() {
+   std::lock_guard<std::mutex> lock(metricsMutex);
+   metricsBaseline.clear();
+   for (size_t i = 0; i < workerCounters.size(); i++) {
+      metricsBaseline.push_back(workerCounters[i]->snapshot(i));
+   }
+}
+std::vector<WorkerMetrics> getWorkerMetrics() {
+   if (scheduler == nullptr) {
+      return {};
+   }
+   return scheduler->getWorkerMetrics();
+}
+void resetWorkerMetrics() {
+   if (scheduler) {
+      scheduler->resetWorkerMetrics();
+   }
+}
+size_t getNumActiveWorkers() {
+   if (scheduler == nullptr) {
+      assert(false);
+      return 0;
+   }
+   return scheduler->getNumActiveWorkers();
+}
+void setNumActiveWorkers(size_t numActiveWorkers) {
+   if (scheduler) {
+      scheduler->setNumActiveWorkers(numActiveWorkers);
+   }
+}
+FiberStackStats getFiberStackStats() {
+   return FiberStackPool::get().getStats();
+}
 size_t currentWorkerId() {
    if (currentWorker) {
       return currentWorker->workerId;
@@ -1,4 +1,5 @@
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <string>
 
@@ -27,14 +28,29 @@ class ConciseTimingPrinter : public execution::TimingProcessor {
       std::cerr << " compilation: " << compilation << " [ms] execution: " << execution << " [ms]" << std::endl;
    }
 };
-void handleQuery(runtime::Session& session, std::string sqlQuery, bool reportTimes) {
+void printSchedulerMetrics(const std::vector<scheduler::WorkerMetrics>& metrics) {
+   auto toMs = [](uint64_t ns) { return ns / 1000000.0; };
+   std::cerr << std::fixed << std::setprecision(3);
+   std::cerr << " worker | tasks | fetched | yielded | resumed | busy [ms] | idle [ms] | sleep [ms] | lock wait [ms]" << std::endl;
+   for (const auto& m : metrics) {
+      std::cerr << " " << m.workerId << " | " << m.tasksExecuted << " | " << m.tasksFetched << " | " << m.fibersYielded << " | " << m.fibersResumed << " | " << toMs(m.busyNs) << " | " << toMs(m.idleNs) << " | " << toMs(m.sleepNs) << " | " << toMs(m.taskQueueLockWaitNs) << std::endl;
+   }
+   std::cerr << std::defaultfloat;
+}
+void handleQuery(runtime::Session& session, std::string sqlQuery, bool reportTimes, bool reportSchedulerMetrics) {
    auto queryExecutionConfig = execution::createQueryExecutionConfig(execution::ExecutionMode::DEFAULT, true);
    if (reportTimes) {
       queryExecutionConfig->timingProcessor = std::make_unique<ConciseTimingPrinter>();
    }
    auto executer = execution::QueryExecuter::createDefaultExecuter(std::move(queryExecutionConfig), session);
    executer->fromData(sqlQuery);
+   if (reportSchedulerMetrics) {
+      scheduler::resetWorkerMetrics();
+   }
    scheduler::awaitEntryTask(std::make_unique<execution::QueryExecutionTask>(std::move(executer)));
+   if (reportSchedulerMetrics) {
+      printSchedulerMetrics(scheduler::getWorkerMetrics());
+   }
 }
 } // namespace
 int main(int argc, char** argv) {
@@ -46,6 +62,10 @@ int main(int argc, char** argv) {
    if (const char* reportTimesEnv = std::getenv("LINGODB_SQL_REPORT_TIMES")) {
       reportTimes = std::stoll(reportTimesEnv);
    }
+   bool reportSchedulerMetrics = false;
+   if (const char* reportSchedulerMetricsEnv = std::getenv("LINGODB_SQL_REPORT_SCHEDULER_METRICS")) {
+      reportSchedulerMetrics = std::stoll(reportSchedulerMetricsEnv);
+   }
    bool prompt = true;
    if (const char* promptEnv = std::getenv("LINGODB_SQL_PROMPT")) {
       prompt = std::stoll(promptEnv);
@@ -75,7 +95,7 @@ int main(int argc, char** argv) {
          }
          std::getline(std::cin, line);
       }
-      handleQuery(*session, query.str(), reportTimes);
+      handleQuery(*session, query.str(), reportTimes, reportSchedulerMetrics);
    }
 
    return 0;
@@ -1,6 +1,7 @@
 #include "lingodb/compiler/mlir-support/eval.h"
 #include "lingodb/execution/Execution.h"
 #include "lingodb/runtime/ArrowTable.h"
+#include "lingodb/utility/Setting.h"
 
 #include <arrow/array.h>
 #include <arrow/pretty_print.h>
@@ -408,6 +409,15 @@ int main(int argc, char** argv) {
       if (parts[0] == "hash-threshold") {
          line += 2;
       }
+      if (parts[0] == "setting") {
+         //e.g., "setting system.opt.window_partitioning hash" applies to the following queries of this test file
+         if (parts.size() != 3) {
+            std::cerr << "usage: setting <key> <value>" << std::endl;
+            exit(1);
+         }
+         utility::setSetting(parts[1], parts[2]);
+         line++;
+      }
    }
 
    return 0;
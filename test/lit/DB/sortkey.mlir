@@ -0,0 +1,93 @@
+// RUN: run-mlir %s | FileCheck %s
+
+//sort keys are unsigned, DumpValue prints them as signed 64-bit integers
+module {
+    func.func @main () {
+         %int_m5 = db.constant ( -5 ) : i32
+         %int_7 = db.constant ( 7 ) : i32
+         %int_0 = db.constant ( 0 ) : i64
+         %int_min = db.constant ( -9223372036854775808 ) : i64
+         %int_max = db.constant ( 9223372036854775807 ) : i64
+         //integers: the sign bit is flipped
+         //CHECK: int(9223372036854775803)
+         //CHECK: int(-9223372036854775801)
+         //CHECK: int(-9223372036854775808)
+         //CHECK: int(0)
+         //CHECK: int(-1)
+         %key_int_m5 = db.sort_key %int_m5 : i32
+         %key_int_7 = db.sort_key %int_7 : i32
+         %key_int_0 = db.sort_key %int_0 : i64
+         %key_int_min = db.sort_key %int_min : i64
+         %key_int_max = db.sort_key %int_max : i64
+         db.runtime_call "DumpValue" (%key_int_m5) : (i64) -> ()
+         db.runtime_call "DumpValue" (%key_int_7) : (i64) -> ()
+         db.runtime_call "DumpValue" (%key_int_0) : (i64) -> ()
+         db.runtime_call "DumpValue" (%key_int_min) : (i64) -> ()
+         db.runtime_call "DumpValue" (%key_int_max) : (i64) -> ()
+
+         %float_m15 = db.constant ( -1.5 ) : f64
+         %float_0 = db.constant ( 0.0 ) : f64
+         %float_2 = db.constant ( 2.0 ) : f64
+         %float_05 = db.constant ( 0.5 ) : f32
+         //floats: all bits of negative values are inverted, positive values get the sign bit, f32 is extended to f64 first
+         //CHECK: int(4613937818241073151)
+         //CHECK: int(-9223372036854775808)
+         //CHECK: int(-4611686018427387904)
+         //CHECK: int(-4620693217682128896)
+         %key_float_m15 = db.sort_key %float_m15 : f64
+         %key_float_0 = db.sort_key %float_0 : f64
+         %key_float_2 = db.sort_key %float_2 : f64
+         %key_float_05 = db.sort_key %float_05 : f32
+         db.runtime_call "DumpValue" (%key_float_m15) : (i64) -> ()
+         db.runtime_call "DumpValue" (%key_float_0) : (i64) -> ()
+         db.runtime_call "DumpValue" (%key_float_2) : (i64) -> ()
+         db.runtime_call "DumpValue" (%key_float_05) : (i64) -> ()
+
+         %dec_small = db.constant ( "12.34" ) : !db.decimal<15,2>
+         %dec_m1234 = db.constant ( "-12.34" ) : !db.decimal<30,2>
+         %dec_1234 = db.constant ( "12.34" ) : !db.decimal<30,2>
+         %dec_2p64 = db.constant ( "184467440737095516.16" ) : !db.decimal<30,2>
+         //decimals: 64-bit decimals are keyed like integers, 128-bit decimals by their (signed) upper 64 bits
+         //CHECK: int(-9223372036854774574)
+         //CHECK: int(9223372036854775807)
+         //CHECK: int(-9223372036854775808)
+         //CHECK: int(-9223372036854775807)
+         %key_dec_small = db.sort_key %dec_small : !db.decimal<15,2>
+         %key_dec_m1234 = db.sort_key %dec_m1234 : !db.decimal<30,2>
+         %key_dec_1234 = db.sort_key %dec_1234 : !db.decimal<30,2>
+         %key_dec_2p64 = db.sort_key %dec_2p64 : !db.decimal<30,2>
+         db.runtime_call "DumpValue" (%key_dec_small) : (i64) -> ()
+         db.runtime_call "DumpValue" (%key_dec_m1234) : (i64) -> ()
+         db.runtime_call "DumpValue" (%key_dec_1234) : (i64) -> ()
+         db.runtime_call "DumpValue" (%key_dec_2p64) : (i64) -> ()
+
+         %null = db.null : !db.nullable<i32>
+         %not_null = db.as_nullable %int_7 : i32 -> !db.nullable<i32>
+         //nullable values: nulls get the largest key, other values the key of the value
+         //CHECK: int(-1)
+         //CHECK: int(-9223372036854775801)
+         %key_null = db.sort_key %null : !db.nullable<i32>
+         %key_not_null = db.sort_key %not_null : !db.nullable<i32>
+         db.runtime_call "DumpValue" (%key_null) : (i64) -> ()
+         db.runtime_call "DumpValue" (%key_not_null) : (i64) -> ()
+
+         %str_empty = db.constant ( "" ) : !db.string
+         %str_ab = db.constant ( "ab" ) : !db.string
+         %str_8 = db.constant ( "abcdefgh" ) : !db.string
+         %str_long = db.constant ( "abcdefghXYZ" ) : !db.string
+         //strings: the first 8 bytes in big-endian order, padded with zeros
+         //CHECK: int(0)
+         //CHECK: int(7017171169396654080)
+         //CHECK: int(7017280452245743464)
+         //CHECK: int(7017280452245743464)
+         %key_str_empty = db.sort_key %str_empty : !db.string
+         %key_str_ab = db.sort_key %str_ab : !db.string
+         %key_str_8 = db.sort_key %str_8 : !db.string
+         %key_str_long = db.sort_key %str_long : !db.string
+         db.runtime_call "DumpValue" (%key_str_empty) : (i64) -> ()
+         db.runtime_call "DumpValue" (%key_str_ab) : (i64) -> ()
+         db.runtime_call "DumpValue" (%key_str_8) : (i64) -> ()
+         db.runtime_call "DumpValue" (%key_str_long) : (i64) -> ()
+        return
+    }
+}
@@ -0,0 +1,23 @@
+// RUN: env LINGODB_OPT_BLOCK_NESTED_LOOP_JOIN=true mlir-db-opt %s -mlir-print-debuginfo -mlir-print-local-scope  --lower-relalg-to-subop | FileCheck %s
+//CHECK: [[LEFT:%.*]], %{{.*}} = subop.generate[@t::@col1({type = i64})]
+//CHECK: [[RIGHT:%.*]], %{{.*}} = subop.generate[@t_u_2::@col1({type = i64})]
+//CHECK: [[PROBE:%.*]] = subop.create !subop.buffer
+//CHECK: subop.materialize [[RIGHT]] {@t_u_2::@col1 => member${{[0-9]+}}}, [[PROBE]] : !subop.buffer
+//CHECK: [[BUILD:%.*]] = subop.create !subop.buffer
+//CHECK: subop.materialize [[LEFT]] {@t::@col1 => member${{[0-9]+}}}, [[BUILD]] : !subop.buffer
+//CHECK: [[VIEW:%.*]] = subop.create_nested_loop_join_view [[BUILD]] : !subop.buffer<{{.*}}>, [[PROBE]] : !subop.buffer<{{.*}}> -> !subop.nested_loop_join_view
+//CHECK: %{{.*}} = subop.scan [[VIEW]] : !subop.nested_loop_join_view
+//CHECK: %{{.*}} = subop.map %{{.*}} computes : [@map::@pred({type = i1})] input : [@t::@col1,@t_u_2::@col1] (%{{.*}}: i64,%{{.*}}: i64){
+//CHECK:   %{{.*}} = db.compare eq %{{.*}} : i64, %{{.*}} : i64
+//CHECK:   tuples.return %{{.*}} : i1
+//CHECK: }
+//CHECK: %{{.*}} = subop.filter %{{.*}} all_true [@map::@pred]
+
+%0 = relalg.const_relation columns : [@t::@col1({type = i64})] values : [[0],[1]]
+%1 = relalg.const_relation columns : [@t_u_2::@col1({type = i64})] values : [[0],[1]]
+%2 = relalg.join %0, %1 (%6: !tuples.tuple) {
+	 %8 = tuples.getcol %6 @t::@col1 : i64
+	 %9 = tuples.getcol %6 @t_u_2::@col1 : i64
+	 %10 = db.compare eq %8 : i64,%9 : i64
+	 tuples.return %10 : i1
+ }
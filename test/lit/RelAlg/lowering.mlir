@@ -206,22 +206,20 @@
 // -----
 //CHECK: [[LEFT:%.*]], %{{.*}} = subop.generate[@t::@col1({type = i64})]
 //CHECK: [[RIGHT:%.*]], %{{.*}} = subop.generate[@t_u_2::@col1({type = i64})]
-//CHECK: %{{.*}} = subop.create !subop.multimap<[member$0 : i64], []>
-//CHECK: subop.insert [[RIGHT]]%{{.*}}  : !subop.multimap<[member$0 : i64], []> {@t_u_2::@col1 => member$0} eq: ([%arg0],[%arg1]) {
-//CHECK:   %{{.*}} = db.compare eq %arg0 : i64, %arg1 : i64
-//CHECK:   tuples.return %{{.*}} : i1
-//CHECK: }
-//CHECK: %{{.*}} = subop.lookup [[LEFT]]%{{.*}} [@t::@col1] : !subop.multimap<[member$0 : i64], []> @lookup::@list({type = !subop.list<!subop.multi_map_entry_ref<<[member$0 : i64], []>>>})eq: ([%arg0],[%arg1]) {
+//CHECK: [[SET:%.*]] = subop.create !subop.map<[member$0 : i64], []
+//CHECK: %{{.*}} = subop.lookup_or_insert [[RIGHT]][[SET]] [@t_u_2::@col1]
+//CHECK: subop.reduce
+//CHECK: %{{.*}} = subop.lookup [[LEFT]][[SET]] [@t::@col1] : !subop.map<{{.*}}> @lookup_u_1::@list({type = !subop.list<!subop.map_entry_ref<{{.*}}>>})eq: ([%arg0],[%arg1]) {
 //CHECK:   %{{.*}} = db.compare eq %arg0 : i64, %arg1 : i64
 //CHECK:   tuples.return %{{.*}} : i1
 //CHECK: }
-//CHECK: %{{.*}} = subop.nested_map %{{.*}} [@lookup::@list] (%arg0, %arg1) {
+//CHECK: %{{.*}} = subop.nested_map %{{.*}} [@lookup_u_1::@list] (%arg0, %arg1) {
 //CHECK:   %{{.*}} = subop.create_simple_state <[marker$0 : i1]> initial : {
 //CHECK:     %{{.*}} = db.constant(false) : i1
 //CHECK:     tuples.return %{{.*}} : i1
 //CHECK:   }
-//CHECK:   %{{.*}} = subop.scan_list %arg1 : !subop.list<!subop.multi_map_entry_ref<<[member$0 : i64], []>>> @lookup_u_1::@entryref({type = !subop.multi_map_entry_ref<<[member$0 : i64], []>>})
-//CHECK:   %{{.*}} = subop.gather %{{.*}} @lookup_u_1::@entryref {member$0 => @t_u_2::@col1({type = i64})}
+//CHECK:   %{{.*}} = subop.scan_list %arg1 : !subop.list<!subop.map_entry_ref<{{.*}}>> @lookup_u_2::@entryref({type = !subop.map_entry_ref<{{.*}}>})
+//CHECK:   %{{.*}} = subop.gather %{{.*}} @lookup_u_2::@entryref {member$0 => @t_u_2::@col1({type = i64})}
 //CHECK:   %{{.*}} = subop.combine_tuple %{{.*}}, %arg0
 //CHECK:   %{{.*}} = subop.map %{{.*}} computes : [@map::@pred({type = i1})] input : [] (){
 //CHECK:     %{{.*}} = db.constant(1 : i64) : i1
@@ -236,8 +234,8 @@
 //CHECK:     %{{.*}} = db.constant(true) : i1
 //CHECK:     tuples.return %{{.*}} : i1
 //CHECK:   }
-//CHECK:   %{{.*}} = subop.lookup %{{.*}}%{{.*}} [] : !subop.simple_state<[marker$1 : i1]> @lookup_u_2::@ref({type = !subop.lookup_entry_ref<!subop.simple_state<[marker$1 : i1]>>})
-//CHECK:   subop.scatter %{{.*}} @lookup_u_2::@ref {@map_u_1::@boolval => marker$1}
+//CHECK:   %{{.*}} = subop.lookup %{{.*}}%{{.*}} [] : !subop.simple_state<[marker$1 : i1]> @lookup_u_3::@ref({type = !subop.lookup_entry_ref<!subop.simple_state<[marker$1 : i1]>>})
+//CHECK:   subop.scatter %{{.*}} @lookup_u_3::@ref {@map_u_1::@boolval => marker$1}
 //CHECK:   %{{.*}} = subop.scan %{{.*}} : !subop.simple_state<[marker$1 : i1]> {marker$1 => @marker::@marker({type = i1})}
 //CHECK:   %{{.*}} = subop.filter %{{.*}} all_true [@marker::@marker]
 //CHECK:   tuples.return %{{.*}} : !tuples.tuplestream
@@ -253,22 +251,20 @@
 // -----
 //CHECK: [[LEFT:%.*]], %{{.*}} = subop.generate[@t::@col1({type = i64})]
 //CHECK: [[RIGHT:%.*]], %{{.*}} = subop.generate[@t_u_2::@col1({type = i64})]
-//CHECK: %{{.*}} = subop.create !subop.multimap<[member$0 : i64], []>
-//CHECK: subop.insert [[RIGHT]]%{{.*}}  : !subop.multimap<[member$0 : i64], []> {@t_u_2::@col1 => member$0} eq: ([%arg0],[%arg1]) {
-//CHECK:   %{{.*}} = db.compare eq %arg0 : i64, %arg1 : i64
-//CHECK:   tuples.return %{{.*}} : i1
-//CHECK: }
-//CHECK: %{{.*}} = subop.lookup [[LEFT]]%{{.*}} [@t::@col1] : !subop.multimap<[member$0 : i64], []> @lookup::@list({type = !subop.list<!subop.multi_map_entry_ref<<[member$0 : i64], []>>>})eq: ([%arg0],[%arg1]) {
+//CHECK: [[SET:%.*]] = subop.create !subop.map<[member$0 : i64], []
+//CHECK: %{{.*}} = subop.lookup_or_insert [[RIGHT]][[SET]] [@t_u_2::@col1]
+//CHECK: subop.reduce
+//CHECK: %{{.*}} = subop.lookup [[LEFT]][[SET]] [@t::@col1] : !subop.map<{{.*}}> @lookup_u_1::@list({type = !subop.list<!subop.map_entry_ref<{{.*}}>>})eq: ([%arg0],[%arg1]) {
 //CHECK:   %{{.*}} = db.compare eq %arg0 : i64, %arg1 : i64
 //CHECK:   tuples.return %{{.*}} : i1
 //CHECK: }
-//CHECK: %{{.*}} = subop.nested_map %{{.*}} [@lookup::@list] (%arg0, %arg1) {
+//CHECK: %{{.*}} = subop.nested_map %{{.*}} [@lookup_u_1::@list] (%arg0, %arg1) {
 //CHECK:   %{{.*}} = subop.create_simple_state <[marker$0 : i1]> initial : {
 //CHECK:     %{{.*}} = db.constant(false) : i1
 //CHECK:     tuples.return %{{.*}} : i1
 //CHECK:   }
-//CHECK:   %{{.*}} = subop.scan_list %arg1 : !subop.list<!subop.multi_map_entry_ref<<[member$0 : i64], []>>> @lookup_u_1::@entryref({type = !subop.multi_map_entry_ref<<[member$0 : i64], []>>})
-//CHECK:   %{{.*}} = subop.gather %{{.*}} @lookup_u_1::@entryref {member$0 => @t_u_2::@col1({type = i64})}
+//CHECK:   %{{.*}} = subop.scan_list %arg1 : !subop.list<!subop.map_entry_ref<{{.*}}>> @lookup_u_2::@entryref({type = !subop.map_entry_ref<{{.*}}>})
+//CHECK:   %{{.*}} = subop.gather %{{.*}} @lookup_u_2::@entryref {member$0 => @t_u_2::@col1({type = i64})}
 //CHECK:   %{{.*}} = subop.combine_tuple %{{.*}}, %arg0
 //CHECK:   %{{.*}} = subop.map %{{.*}} computes : [@map::@pred({type = i1})] input : [] (){
 //CHECK:     %{{.*}} = db.constant(1 : i64) : i1
@@ -283,8 +279,8 @@
 //CHECK:     %{{.*}} = db.constant(true) : i1
 //CHECK:     tuples.return %{{.*}} : i1
 //CHECK:   }
-//CHECK:   %{{.*}} = subop.lookup %{{.*}}%{{.*}} [] : !subop.simple_state<[marker$1 : i1]> @lookup_u_2::@ref({type = !subop.lookup_entry_ref<!subop.simple_state<[marker$1 : i1]>>})
-//CHECK:   subop.scatter %{{.*}} @lookup_u_2::@ref {@map_u_1::@boolval => marker$1}
+//CHECK:   %{{.*}} = subop.lookup %{{.*}}%{{.*}} [] : !subop.simple_state<[marker$1 : i1]> @lookup_u_3::@ref({type = !subop.lookup_entry_ref<!subop.simple_state<[marker$1 : i1]>>})
+//CHECK:   subop.scatter %{{.*}} @lookup_u_3::@ref {@map_u_1::@boolval => marker$1}
 //CHECK:   %{{.*}} = subop.scan %{{.*}} : !subop.simple_state<[marker$1 : i1]> {marker$1 => @marker::@marker({type = i1})}
 //CHECK:   %{{.*}} = subop.filter %{{.*}} none_true [@marker::@marker]
 //CHECK:   tuples.return %{{.*}} : !tuples.tuplestream
@@ -0,0 +1,125 @@
+// RUN: mlir-db-opt %s -split-input-file -mlir-print-debuginfo -mlir-print-local-scope  --relalg-optimize-implementations | FileCheck %s
+
+//build sides beyond the last-level cache use the partitioned (grace) hash join
+//CHECK: relalg.join
+//CHECK-SAME: impl = "gracehash"
+//CHECK-SAME: useGraceHashJoin
+module @querymodule  {
+  func.func @query() {
+    %0 = relalg.const_relation columns : [@build::@k({type = i64})] values : [[1]] {rows = 2.000000e+06 : f64}
+    %1 = relalg.const_relation columns : [@probe::@k({type = i64})] values : [[1]] {rows = 8.000000e+06 : f64}
+    %2 = relalg.join %0, %1 (%arg0: !tuples.tuple) {
+      %3 = tuples.getcol %arg0 @build::@k : i64
+      %4 = tuples.getcol %arg0 @probe::@k : i64
+      %5 = db.compare eq %3 : i64, %4 : i64
+      tuples.return %5 : i1
+    }
+    %res_table = relalg.materialize %2 [] => [] : !subop.local_table<[],[]>
+    subop.set_result 0 %res_table : !subop.local_table<[],[]>
+    return
+  }
+}
+// -----
+//...unless the probe side is so much larger that materializing it costs more than probing the unpartitioned table
+//CHECK: relalg.join
+//CHECK-SAME: impl = "hash"
+//CHECK-NOT: useGraceHashJoin
+//CHECK-SAME: useHashJoin
+module @querymodule  {
+  func.func @query() {
+    %0 = relalg.const_relation columns : [@build::@k({type = i64})] values : [[1]] {rows = 2.000000e+06 : f64}
+    %1 = relalg.const_relation columns : [@probe::@k({type = i64})] values : [[1]] {rows = 2.000000e+07 : f64}
+    %2 = relalg.join %0, %1 (%arg0: !tuples.tuple) {
+      %3 = tuples.getcol %arg0 @build::@k : i64
+      %4 = tuples.getcol %arg0 @probe::@k : i64
+      %5 = db.compare eq %3 : i64, %4 : i64
+      tuples.return %5 : i1
+    }
+    %res_table = relalg.materialize %2 [] => [] : !subop.local_table<[],[]>
+    subop.set_result 0 %res_table : !subop.local_table<[],[]>
+    return
+  }
+}
+// -----
+//build sides that fit into the cache are probed through a hash-indexed view
+//CHECK: relalg.join
+//CHECK-SAME: impl = "hash"
+//CHECK-NOT: useGraceHashJoin
+//CHECK-SAME: useHashJoin
+module @querymodule  {
+  func.func @query() {
+    %0 = relalg.const_relation columns : [@build::@k({type = i64})] values : [[1]] {rows = 1.000000e+04 : f64}
+    %1 = relalg.const_relation columns : [@probe::@k({type = i64})] values : [[1]] {rows = 8.000000e+06 : f64}
+    %2 = relalg.join %0, %1 (%arg0: !tuples.tuple) {
+      %3 = tuples.getcol %arg0 @build::@k : i64
+      %4 = tuples.getcol %arg0 @probe::@k : i64
+      %5 = db.compare eq %3 : i64, %4 : i64
+      tuples.return %5 : i1
+    }
+    %res_table = relalg.materialize %2 [] => [] : !subop.local_table<[],[]>
+    subop.set_result 0 %res_table : !subop.local_table<[],[]>
+    return
+  }
+}
+// -----
+//inputs with close estimates are both materialized, so that the grace hash join can build over the one that is actually smaller
+//CHECK: relalg.join
+//CHECK-SAME: impl = "gracehash"
+//CHECK-SAME: useGraceHashJoin
+module @querymodule  {
+  func.func @query() {
+    %0 = relalg.const_relation columns : [@build::@k({type = i64})] values : [[1]] {rows = 3.000000e+05 : f64}
+    %1 = relalg.const_relation columns : [@probe::@k({type = i64})] values : [[1]] {rows = 2.000000e+05 : f64}
+    %2 = relalg.join %0, %1 (%arg0: !tuples.tuple) {
+      %3 = tuples.getcol %arg0 @build::@k : i64
+      %4 = tuples.getcol %arg0 @probe::@k : i64
+      %5 = db.compare eq %3 : i64, %4 : i64
+      tuples.return %5 : i1
+    }
+    %res_table = relalg.materialize %2 [] => [] : !subop.local_table<[],[]>
+    subop.set_result 0 %res_table : !subop.local_table<[],[]>
+    return
+  }
+}
+// -----
+//estimates that differ by more than the ratio keep the build side
+//CHECK: relalg.join
+//CHECK-SAME: impl = "hash"
+//CHECK-NOT: useGraceHashJoin
+//CHECK-SAME: useHashJoin
+module @querymodule  {
+  func.func @query() {
+    %0 = relalg.const_relation columns : [@build::@k({type = i64})] values : [[1]] {rows = 2.000000e+05 : f64}
+    %1 = relalg.const_relation columns : [@probe::@k({type = i64})] values : [[1]] {rows = 1.000000e+06 : f64}
+    %2 = relalg.join %0, %1 (%arg0: !tuples.tuple) {
+      %3 = tuples.getcol %arg0 @build::@k : i64
+      %4 = tuples.getcol %arg0 @probe::@k : i64
+      %5 = db.compare eq %3 : i64, %4 : i64
+      tuples.return %5 : i1
+    }
+    %res_table = relalg.materialize %2 [] => [] : !subop.local_table<[],[]>
+    subop.set_result 0 %res_table : !subop.local_table<[],[]>
+    return
+  }
+}
+// -----
+//small inputs keep the build side, even if their estimates are close
+//CHECK: relalg.join
+//CHECK-SAME: impl = "hash"
+//CHECK-NOT: useGraceHashJoin
+//CHECK-SAME: useHashJoin
+module @querymodule  {
+  func.func @query() {
+    %0 = relalg.const_relation columns : [@build::@k({type = i64})] values : [[1]] {rows = 1.000000e+03 : f64}
+    %1 = relalg.const_relation columns : [@probe::@k({type = i64})] values : [[1]] {rows = 1.500000e+03 : f64}
+    %2 = relalg.join %0, %1 (%arg0: !tuples.tuple) {
+      %3 = tuples.getcol %arg0 @build::@k : i64
+      %4 = tuples.getcol %arg0 @probe::@k : i64
+      %5 = db.compare eq %3 : i64, %4 : i64
+      tuples.return %5 : i1
+    }
+    %res_table = relalg.materialize %2 [] => [] : !subop.local_table<[],[]>
+    subop.set_result 0 %res_table : !subop.local_table<[],[]>
+    return
+  }
+}
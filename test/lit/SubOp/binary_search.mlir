@@ -0,0 +1,55 @@
+//RUN: run-mlir %s | FileCheck %s
+//CHECK: |                             k  |                             p  |
+//CHECK: -------------------------------------------------------------------
+//CHECK: |                             0  |                             0  |
+//CHECK: |                             1  |                             1  |
+//CHECK: |                             2  |                             1  |
+//CHECK: |                             3  |                             2  |
+//CHECK: |                             4  |                             2  |
+//CHECK: |                             5  |                             3  |
+//CHECK: |                             6  |                             3  |
+//CHECK: |                             7  |                             4  |
+//CHECK: |                             8  |                             4  |
+//CHECK: |                             9  |                             5  |
+!result_table_type = !subop.result_table<[k : index,p : index]>
+!local_table_type = !subop.local_table<[k : index,p : index],["k","p"]>
+module {
+    func.func @main(){
+    	%subop_result = subop.execution_group (){
+			%vals = subop.create !subop.buffer<[val : index]>
+			%generated, %streams = subop.generate [@t::@c1({type=index})] {
+				%n = arith.constant 10 : index
+				%c0 = arith.constant 0 : index
+				%c1 = arith.constant 1 : index
+				%c2 = arith.constant 2 : index
+				scf.for %i = %c0 to %n step %c1 {
+					%v = arith.muli %i, %c2 : index
+					subop.generate_emit %v : index
+				}
+				tuples.return
+			}
+			subop.materialize %generated {@t::@c1 => val}, %vals : !subop.buffer<[val : index]>
+			%result_table = subop.create !result_table_type
+
+			%view = subop.create_continuous_view %vals : !subop.buffer<[val : index]> -> !subop.continuous_view<!subop.buffer<[val : index]>>
+			%keys, %streams2 = subop.generate [@k::@k({type=index})] {
+				%n = arith.constant 10 : index
+				%c0 = arith.constant 0 : index
+				%c1 = arith.constant 1 : index
+				scf.for %i = %c0 to %n step %c1 {
+					subop.generate_emit %i : index
+				}
+				tuples.return
+			}
+			%stream = subop.binary_search %keys %view : !subop.continuous_view<!subop.buffer<[val : index]>> ["val"] [@k::@k] @k::@pos({type=index}) (%entry: index, %key: index) {
+				%lt = arith.cmpi ult, %entry, %key : index
+				tuples.return %lt : i1
+			}
+			subop.materialize %stream {@k::@k => k, @k::@pos => p}, %result_table : !result_table_type
+			%local_table = subop.create_from ["k","p"] %result_table : !result_table_type -> !local_table_type
+			subop.execution_group_return %local_table : !local_table_type
+        } -> !local_table_type
+        subop.set_result 0 %subop_result  : !local_table_type
+        return
+    }
+}
@@ -0,0 +1,46 @@
+//RUN: run-mlir %s | FileCheck %s
+//the values 0,7,4,1,8,5,2,9,6,3 are checked against a heap of the 4 smallest values: once the heap is full, values that do not sort before its worst entry are dropped
+//CHECK: |                        passed  |
+//CHECK-NEXT: ----------------------------------
+//CHECK-NEXT: |                             0  |
+//CHECK-NEXT: |                             7  |
+//CHECK-NEXT: |                             4  |
+//CHECK-NEXT: |                             1  |
+//CHECK-NEXT: |                             5  |
+//CHECK-NEXT: |                             2  |
+//CHECK-NEXT: |                             3  |
+//CHECK-NOT: |                             6  |
+//CHECK-NOT: |                             8  |
+//CHECK-NOT: |                             9  |
+!result_table_type = !subop.result_table<[passed : index]>
+!local_table_type = !subop.local_table<[passed : index],["passed"]>
+module {
+    func.func @main(){
+    	%subop_result = subop.execution_group (){
+			%heap = subop.create_heap ["ih"] -> !subop.heap<4,[ih : index]> ([%left],[%right]){
+				%lt = arith.cmpi ult, %left, %right : index
+				tuples.return %lt : i1
+			}
+			%generated, %streams = subop.generate [@t::@c1({type=index})] {
+				%n = arith.constant 10 : index
+				%c0 = arith.constant 0 : index
+				%c1 = arith.constant 1 : index
+				%c7 = arith.constant 7 : index
+				scf.for %i = %c0 to %n step %c1 {
+					%mul = arith.muli %i, %c7 : index
+					%val = arith.remui %mul, %n : index
+					subop.generate_emit %val : index
+				}
+				tuples.return
+			}
+			%result_table = subop.create !result_table_type
+			%checked = subop.check_heap_bound %generated {@t::@c1 => ih}, %heap : !subop.heap<4,[ih : index]>
+			subop.materialize %checked {@t::@c1 => ih}, %heap : !subop.heap<4,[ih : index]>
+			subop.materialize %checked {@t::@c1 => passed}, %result_table : !result_table_type
+			%local_table = subop.create_from ["passed"] %result_table : !result_table_type -> !local_table_type
+			subop.execution_group_return %local_table : !local_table_type
+        } -> !local_table_type
+        subop.set_result 0 %subop_result  : !local_table_type
+         return
+    }
+}
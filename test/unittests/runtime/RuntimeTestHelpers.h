@@ -0,0 +1,34 @@
+#ifndef LINGODB_TEST_UNITTESTS_RUNTIME_RUNTIMETESTHELPERS_H
+#define LINGODB_TEST_UNITTESTS_RUNTIME_RUNTIMETESTHELPERS_H
+#include "lingodb/runtime/ExecutionContext.h"
+#include "lingodb/runtime/Session.h"
+#include "lingodb/scheduler/Tasks.h"
+
+#include <functional>
+#include <memory>
+
+namespace lingodb::test {
+class JobTask : public lingodb::scheduler::TaskWithContext {
+   std::function<void()> job;
+
+   public:
+   JobTask(lingodb::runtime::ExecutionContext* context, std::function<void()> job) : TaskWithContext(context), job(std::move(job)) {}
+   bool allocateWork() override {
+      if (workExhausted.exchange(true)) {
+         return false;
+      }
+      return true;
+   }
+   void performWork() override {
+      job();
+   }
+};
+//runs job on a worker thread with a fresh execution context, like the runtime functions of a query
+//the memory budget of the context is taken from the system.memory_budget setting at the time of the call
+inline void runInQuery(const std::function<void()>& job) {
+   auto session = lingodb::runtime::Session::createSession();
+   auto context = session->createExecutionContext();
+   lingodb::scheduler::awaitEntryTask(std::make_unique<JobTask>(context.get(), job));
+}
+} // namespace lingodb::test
+#endif //LINGODB_TEST_UNITTESTS_RUNTIME_RUNTIMETESTHELPERS_H
@@ -0,0 +1,96 @@
+#include "catch2/catch_all.hpp"
+#include "lingodb/runtime/ExternalSort.h"
+#include "lingodb/runtime/GrowingBuffer.h"
+#include "lingodb/utility/Setting.h"
+
+#include "RuntimeTestHelpers.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace lingodb::runtime;
+namespace {
+struct Entry {
+   uint64_t key;
+   uint64_t id;
+};
+bool compareEntries(uint8_t* left, uint8_t* right) {
+   auto* l = reinterpret_cast<Entry*>(left);
+   auto* r = reinterpret_cast<Entry*>(right);
+   return l->key < r->key || (l->key == r->key && l->id < r->id);
+}
+//only a prefix of the key, so that the comparator has to order the ties
+uint64_t entryKey(uint8_t* entry) {
+   return reinterpret_cast<Entry*>(entry)->key >> 16;
+}
+struct Collected {
+   std::vector<Entry> entries;
+   std::mutex mutex;
+};
+void collect(Buffer buffer, void* contextPtr) {
+   auto* collected = reinterpret_cast<Collected*>(contextPtr);
+   auto* entries = reinterpret_cast<Entry*>(buffer.ptr);
+   std::lock_guard<std::mutex> lock(collected->mutex);
+   collected->entries.insert(collected->entries.end(), entries, entries + buffer.numElements / sizeof(Entry));
+}
+void checkSort(size_t numEntries, bool byKey) {
+   auto input = std::make_unique<GrowingBuffer>(1024, sizeof(Entry));
+   std::mt19937_64 rng(42);
+   std::vector<Entry> expected;
+   for (size_t id = 0; id < numEntries; id++) {
+      //few distinct key prefixes, many entries with equal prefixes
+      Entry entry{(rng() % 64) << 16 | (rng() & 0xffff), id};
+      *reinterpret_cast<Entry*>(input->insert()) = entry;
+      expected.push_back(entry);
+   }
+   std::sort(expected.begin(), expected.end(), [](const Entry& l, const Entry& r) { return compareEntries((uint8_t*) &l, (uint8_t*) &r); });
+   auto* sort = byKey ? ExternalSort::createByKey(input.get(), compareEntries, entryKey) : ExternalSort::create(input.get(), compareEntries);
+   {
+      //sequential: all entries in order
+      Collected collected;
+      auto* iterator = ExternalSort::createIterator(sort);
+      iterator->iterateEfficient(false, collect, &collected);
+      delete iterator;
+      REQUIRE(collected.entries.size() == expected.size());
+      for (size_t i = 0; i < expected.size(); i++) {
+         REQUIRE(collected.entries[i].id == expected[i].id);
+      }
+   }
+   {
+      //parallel: every entry exactly once
+      Collected collected;
+      auto* iterator = ExternalSort::createIterator(sort);
+      iterator->iterateEfficient(true, collect, &collected);
+      delete iterator;
+      REQUIRE(collected.entries.size() == numEntries);
+      std::vector<bool> seen(numEntries, false);
+      for (auto& entry : collected.entries) {
+         REQUIRE(!seen[entry.id]);
+         seen[entry.id] = true;
+      }
+   }
+   REQUIRE(getCurrentExecutionContext()->getMemoryBudget().getUsed() == 0);
+}
+} // namespace
+
+TEST_CASE("ExternalSort:InMemory") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   lingodb::test::runInQuery([]() {
+      checkSort(100000, false);
+      checkSort(100000, true);
+   });
+}
+
+TEST_CASE("ExternalSort:SpillUnderMemoryBudget") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   lingodb::utility::setSetting("system.memory_budget", std::to_string(256 << 10));
+   lingodb::test::runInQuery([]() {
+      checkSort(200000, false);
+      checkSort(200000, true);
+   });
+   lingodb::utility::setSetting("system.memory_budget", "0");
+}
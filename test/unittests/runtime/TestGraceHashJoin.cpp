@@ -0,0 +1,130 @@
+#include "catch2/catch_all.hpp"
+#include "lingodb/runtime/GraceHashJoin.h"
+#include "lingodb/runtime/GrowingBuffer.h"
+#include "lingodb/utility/Setting.h"
+
+#include "RuntimeTestHelpers.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+using namespace lingodb::runtime;
+namespace {
+//both inputs start with the hash of the key, the sides have different sizes and can be told apart by their marker
+struct BuildEntry {
+   size_t hash;
+   int64_t key;
+   int64_t marker;
+};
+struct ProbeEntry {
+   size_t hash;
+   int64_t key;
+   int64_t marker;
+   int64_t padding;
+};
+constexpr int64_t buildMarker = 1;
+constexpr int64_t probeMarker = 2;
+size_t hashKey(int64_t key) {
+   uint64_t x = static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull;
+   return x ^ (x >> 29);
+}
+using Counts = std::map<int64_t, size_t>;
+//counts the matches per key and checks that every pair is (build entry, probe entry) with equal keys
+void countMatches(Buffer buffer, Counts& counts) {
+   auto* matches = reinterpret_cast<std::pair<uint8_t*, uint8_t*>*>(buffer.ptr);
+   for (size_t i = 0; i < buffer.numElements / sizeof(std::pair<uint8_t*, uint8_t*>); i++) {
+      auto* buildEntry = reinterpret_cast<BuildEntry*>(matches[i].first);
+      auto* probeEntry = reinterpret_cast<ProbeEntry*>(matches[i].second);
+      REQUIRE(buildEntry->marker == buildMarker);
+      REQUIRE(probeEntry->marker == probeMarker);
+      REQUIRE(buildEntry->key == probeEntry->key);
+      counts[buildEntry->key]++;
+   }
+}
+//build contains the keys [0, numBuildKeys) buildCopies times each, probe contains every key of [0, numProbeKeys) once
+//expectPartitioned: the inputs are consumed by partitioning them when the join is created
+//expectInMemoryPartitions: the partitions are kept in memory and charged to the budget until the join is destroyed
+void checkJoin(size_t numBuildKeys, size_t buildCopies, size_t numProbeKeys, bool expectPartitioned, bool expectInMemoryPartitions = false) {
+   auto build = std::make_unique<GrowingBuffer>(1024, sizeof(BuildEntry));
+   auto probe = std::make_unique<GrowingBuffer>(1024, sizeof(ProbeEntry));
+   for (size_t copy = 0; copy < buildCopies; copy++) {
+      for (size_t key = 0; key < numBuildKeys; key++) {
+         *reinterpret_cast<BuildEntry*>(build->insert()) = {hashKey(key), static_cast<int64_t>(key), buildMarker};
+      }
+   }
+   for (size_t key = 0; key < numProbeKeys; key++) {
+      *reinterpret_cast<ProbeEntry*>(probe->insert()) = {hashKey(key), static_cast<int64_t>(key), probeMarker, 0};
+   }
+   Counts expected;
+   for (size_t key = 0; key < std::min(numBuildKeys, numProbeKeys); key++) {
+      expected[key] = buildCopies;
+   }
+   auto& memoryBudget = getCurrentExecutionContext()->getMemoryBudget();
+   size_t inputBytes = build->getLen() * sizeof(BuildEntry) + probe->getLen() * sizeof(ProbeEntry);
+   auto* join = GraceHashJoin::create(build.get(), probe.get());
+   REQUIRE((build->getLen() == 0) == expectPartitioned);
+   REQUIRE((probe->getLen() == 0) == expectPartitioned);
+   size_t usedAfterCreate = memoryBudget.getUsed();
+   REQUIRE(usedAfterCreate == (expectInMemoryPartitions ? inputBytes : 0));
+   {
+      Counts counts;
+      std::mutex mutex;
+      std::pair<Counts*, std::mutex*> context{&counts, &mutex};
+      auto* iterator = GraceHashJoin::createIterator(join);
+      iterator->iterateEfficient(true, [](Buffer buffer, void* contextPtr) {
+         auto* context = reinterpret_cast<std::pair<Counts*, std::mutex*>*>(contextPtr);
+         std::lock_guard<std::mutex> lock(*context->second);
+         countMatches(buffer, *context->first); }, &context);
+      delete iterator;
+      REQUIRE(counts == expected);
+   }
+   {
+      Counts counts;
+      auto* iterator = GraceHashJoin::createIterator(join);
+      for (; iterator->isValid(); iterator->next()) {
+         countMatches(iterator->getCurrentBuffer(), counts);
+      }
+      delete iterator;
+      REQUIRE(counts == expected);
+   }
+   //everything charged while joining is released again
+   REQUIRE(memoryBudget.getUsed() == usedAfterCreate);
+}
+struct Settings {
+   Settings(int64_t memoryBudget, int64_t cachePartitionBytes) {
+      lingodb::utility::setSetting("system.memory_budget", std::to_string(memoryBudget));
+      lingodb::utility::setSetting("system.grace_join.cache_partition_bytes", std::to_string(cachePartitionBytes));
+   }
+   ~Settings() {
+      lingodb::utility::setSetting("system.memory_budget", "0");
+      lingodb::utility::setSetting("system.grace_join.cache_partition_bytes", std::to_string(1 << 18));
+   }
+};
+} // namespace
+
+TEST_CASE("GraceHashJoin:InMemory") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   Settings settings(0, 0);
+   lingodb::test::runInQuery([]() { checkJoin(10000, 2, 15000, false); });
+}
+
+TEST_CASE("GraceHashJoin:CachePartitions") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   Settings settings(0, 4096);
+   lingodb::test::runInQuery([]() { checkJoin(10000, 2, 15000, true, true); });
+}
+
+TEST_CASE("GraceHashJoin:SpillUnderMemoryBudget") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   Settings settings(64 << 10, 1 << 18);
+   lingodb::test::runInQuery([]() { checkJoin(20000, 3, 30000, true); });
+}
+
+TEST_CASE("GraceHashJoin:SpillSwappedSides") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   //the probe side is smaller and becomes the build side, the matches still have to be (build entry, probe entry)
+   Settings settings(16 << 10, 1 << 18);
+   lingodb::test::runInQuery([]() { checkJoin(20000, 4, 5000, true); });
+}
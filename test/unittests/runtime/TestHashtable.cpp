@@ -0,0 +1,163 @@
+#include "catch2/catch_all.hpp"
+#include "lingodb/runtime/Hashtable.h"
+#include "lingodb/runtime/PreAggregationHashtable.h"
+#include "lingodb/runtime/helpers.h"
+#include "lingodb/scheduler/Scheduler.h"
+#include "lingodb/utility/Setting.h"
+
+#include "RuntimeTestHelpers.h"
+
+#include <string>
+#include <unordered_map>
+
+using namespace lingodb::runtime;
+namespace {
+struct Group {
+   int64_t key;
+   int64_t count;
+};
+size_t hashKey(int64_t key) {
+   uint64_t x = static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull;
+   return x ^ (x >> 29) ^ (x << 17);
+}
+bool groupsEqual(uint8_t* left, uint8_t* right) {
+   return reinterpret_cast<Group*>(left)->key == reinterpret_cast<Group*>(right)->key;
+}
+void combineGroups(uint8_t* left, uint8_t* right) {
+   reinterpret_cast<Group*>(left)->count += reinterpret_cast<Group*>(right)->count;
+}
+uint8_t* createFragment(uint8_t*) {
+   return reinterpret_cast<uint8_t*>(PreAggregationHashtableFragment::create(sizeof(PreAggregationHashtableFragment::Entry) + sizeof(Group), false));
+}
+//inserts every key of [0, numKeys) numCopies times without pre-aggregating (as in bypass mode), merges the fragments and checks all groups
+void checkPreAggregation(size_t numKeys, size_t numCopies) {
+   using Entry = PreAggregationHashtableFragment::Entry;
+   auto* threadLocal = ThreadLocal::create(createFragment, nullptr);
+   constexpr size_t numChunks = 64;
+   lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(numChunks, [&](size_t chunk) {
+      auto* fragment = reinterpret_cast<PreAggregationHashtableFragment*>(threadLocal->getLocal());
+      for (size_t copy = 0; copy < numCopies; copy++) {
+         for (size_t key = chunk; key < numKeys; key += numChunks) {
+            auto* entry = fragment->insert(hashKey(key));
+            *reinterpret_cast<Group*>(entry->content) = {static_cast<int64_t>(key), 1};
+         }
+      }
+   }));
+   auto* merged = PreAggregationHashtable::merge(threadLocal, groupsEqual, combineGroups);
+   REQUIRE(getCurrentExecutionContext()->getMemoryBudget().getUsed() > 0);
+   for (size_t key = 0; key < numKeys; key++) {
+      auto hash = hashKey(key);
+      size_t found = 0;
+      for (auto* entry = merged->lookup(hash); entry; entry = entry->next) {
+         auto* group = reinterpret_cast<Group*>(entry->content);
+         if (entry->hashValue == hash && group->key == static_cast<int64_t>(key)) {
+            REQUIRE(group->count == static_cast<int64_t>(numCopies));
+            found++;
+         }
+      }
+      REQUIRE(found == 1);
+   }
+   std::unordered_map<int64_t, int64_t> groups;
+   auto* iterator = merged->createIterator();
+   for (; iterator->isValid(); iterator->next()) {
+      auto buffer = iterator->getCurrentBuffer();
+      auto** entries = reinterpret_cast<Entry**>(buffer.ptr);
+      for (size_t i = 0; i < buffer.numElements / sizeof(Entry*); i++) {
+         auto* group = reinterpret_cast<Group*>(entries[i]->content);
+         groups[group->key] += group->count;
+      }
+   }
+   delete iterator;
+   REQUIRE(groups.size() == numKeys);
+}
+//layout of the entries of Hashtable
+struct HashtableEntry {
+   HashtableEntry* next;
+   size_t hashValue;
+   Group group;
+};
+uint8_t* createHashtable(uint8_t*) {
+   return reinterpret_cast<uint8_t*>(Hashtable::create(sizeof(HashtableEntry), 16));
+}
+void insertGroup(Hashtable* ht, int64_t key, int64_t count) {
+   auto* entry = reinterpret_cast<HashtableEntry*>(ht->insert(hashKey(key)));
+   entry->group = {key, count};
+}
+std::unordered_map<int64_t, int64_t> collectGroups(Hashtable* ht, size_t& numEntries) {
+   std::unordered_map<int64_t, int64_t> groups;
+   numEntries = 0;
+   auto* iterator = ht->createIterator();
+   for (; iterator->isValid(); iterator->next()) {
+      auto buffer = iterator->getCurrentBuffer();
+      auto* entries = reinterpret_cast<HashtableEntry*>(buffer.ptr);
+      for (size_t i = 0; i < buffer.numElements / sizeof(HashtableEntry); i++) {
+         groups[entries[i].group.key] += entries[i].group.count;
+         numEntries++;
+      }
+   }
+   delete iterator;
+   return groups;
+}
+} // namespace
+
+TEST_CASE("Presize:ClampInitialCapacity") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   //every worker may reserve 1MiB up front
+   lingodb::utility::setSetting("system.presize.max_bytes", std::to_string(4 << 20));
+   REQUIRE(clampInitialCapacity(100, 16) == 100);
+   REQUIRE(clampInitialCapacity(1 << 30, 16) == (1 << 20) / 16);
+   REQUIRE(clampInitialCapacity(1 << 30, 0) == (1 << 20));
+   //the former default capacity is always granted
+   REQUIRE(clampInitialCapacity(1 << 30, 1 << 20) == 1024);
+   REQUIRE(clampInitialCapacity(0, 16) == 1);
+   lingodb::utility::setSetting("system.presize.max_bytes", std::to_string(64 << 20));
+}
+
+TEST_CASE("PreAggregation:Merge") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   //large enough for the second radix pass of the merge
+   lingodb::test::runInQuery([]() { checkPreAggregation(1 << 19, 2); });
+}
+
+TEST_CASE("PreAggregation:SpillUnderMemoryBudget") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   //every fragment spills its outputs several times
+   lingodb::utility::setSetting("system.memory_budget", std::to_string(256 << 10));
+   lingodb::test::runInQuery([]() { checkPreAggregation(1 << 16, 4); });
+   lingodb::utility::setSetting("system.memory_budget", "0");
+}
+
+TEST_CASE("Hashtable:Merge") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   lingodb::test::runInQuery([]() {
+      //enough groups for the partitioned merge, every thread-local table sees every key of its chunks twice
+      constexpr size_t numKeys = 1 << 17;
+      constexpr size_t numChunks = 64;
+      auto* threadLocal = ThreadLocal::create(createHashtable, nullptr);
+      lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(numChunks, [&](size_t chunk) {
+         auto* ht = reinterpret_cast<Hashtable*>(threadLocal->getLocal());
+         for (size_t key = chunk; key < numKeys; key += numChunks) {
+            insertGroup(ht, key, 1);
+            insertGroup(ht, (key + numKeys / 2) % numKeys, 1);
+         }
+      }));
+      auto* merged = Hashtable::merge(threadLocal, groupsEqual, combineGroups);
+      size_t numEntries;
+      auto groups = collectGroups(merged, numEntries);
+      REQUIRE(numEntries == numKeys);
+      for (size_t key = 0; key < numKeys; key++) {
+         REQUIRE(groups[key] == 2);
+      }
+      //merging into the merged table finds every group through its slots
+      auto* extra = Hashtable::create(sizeof(HashtableEntry), 16);
+      for (size_t key = 0; key < numKeys; key++) {
+         insertGroup(extra, key, 1);
+      }
+      merged->mergeEntries(groupsEqual, combineGroups, extra);
+      groups = collectGroups(merged, numEntries);
+      REQUIRE(numEntries == numKeys);
+      for (size_t key = 0; key < numKeys; key++) {
+         REQUIRE(groups[key] == 3);
+      }
+   });
+}
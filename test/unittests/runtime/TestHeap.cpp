@@ -0,0 +1,80 @@
+#include "catch2/catch_all.hpp"
+#include "lingodb/runtime/Heap.h"
+
+#include "RuntimeTestHelpers.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace lingodb::runtime;
+namespace {
+constexpr size_t k = 100;
+bool lessThan(uint8_t* left, uint8_t* right) {
+   return *reinterpret_cast<int64_t*>(left) < *reinterpret_cast<int64_t*>(right);
+}
+//like the generated init functions, the argument holds the thread local itself
+uint8_t* createHeap(uint8_t* arg) {
+   return reinterpret_cast<uint8_t*>(Heap::createShared(k, sizeof(int64_t), lessThan, *reinterpret_cast<ThreadLocal**>(arg)));
+}
+std::vector<int64_t> getValues(Heap* heap) {
+   auto buffer = heap->getBuffer();
+   auto* values = reinterpret_cast<int64_t*>(buffer.ptr);
+   return std::vector<int64_t>(values, values + buffer.numElements / sizeof(int64_t));
+}
+} // namespace
+
+TEST_CASE("Heap:SharedBound") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   lingodb::test::runInQuery([]() {
+      ThreadLocal* self = nullptr;
+      auto* threadLocal = ThreadLocal::create(createHeap, reinterpret_cast<uint8_t*>(&self));
+      self = threadLocal;
+      auto* first = reinterpret_cast<Heap*>(createHeap(reinterpret_cast<uint8_t*>(&self)));
+      auto* second = reinterpret_cast<Heap*>(createHeap(reinterpret_cast<uint8_t*>(&self)));
+      //the second heap is filled before the bound exists, so it keeps entries that the merge has to drop
+      for (int64_t value = 1000; value < 1000 + static_cast<int64_t>(k) / 2; value++) {
+         second->insert(reinterpret_cast<uint8_t*>(&value));
+      }
+      for (int64_t value = 0; value < static_cast<int64_t>(k); value++) {
+         first->insert(reinterpret_cast<uint8_t*>(&value));
+      }
+      //the full first heap published its worst entry, which prunes the second heap although it is not full
+      int64_t large = 500;
+      int64_t small = 5;
+      REQUIRE(!second->isCandidate(reinterpret_cast<uint8_t*>(&large)));
+      REQUIRE(second->isCandidate(reinterpret_cast<uint8_t*>(&small)));
+      second->insert(reinterpret_cast<uint8_t*>(&large));
+      first->mergeWithOther(second);
+      auto values = getValues(first);
+      REQUIRE(values.size() == k);
+      for (size_t i = 0; i < k; i++) {
+         REQUIRE(values[i] == static_cast<int64_t>(i));
+      }
+   });
+}
+
+TEST_CASE("Heap:ParallelTopK") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   lingodb::test::runInQuery([]() {
+      ThreadLocal* self = nullptr;
+      auto* threadLocal = ThreadLocal::create(createHeap, reinterpret_cast<uint8_t*>(&self));
+      self = threadLocal;
+      std::vector<int64_t> input(1 << 20);
+      std::mt19937_64 rng(7);
+      for (auto& value : input) {
+         value = static_cast<int64_t>(rng() % (1 << 24));
+      }
+      constexpr size_t numChunks = 64;
+      size_t chunkSize = input.size() / numChunks;
+      lingodb::scheduler::awaitChildTask(std::make_unique<lingodb::scheduler::ParallelForTask>(numChunks, [&](size_t chunk) {
+         auto* heap = reinterpret_cast<Heap*>(threadLocal->getLocal());
+         for (size_t i = chunk * chunkSize; i < (chunk + 1) * chunkSize; i++) {
+            heap->insert(reinterpret_cast<uint8_t*>(&input[i]));
+         }
+      }));
+      auto values = getValues(Heap::merge(threadLocal));
+      std::sort(input.begin(), input.end());
+      REQUIRE(values == std::vector<int64_t>(input.begin(), input.begin() + k));
+   });
+}
@@ -0,0 +1,115 @@
+#include "catch2/catch_all.hpp"
+#include "lingodb/runtime/GrowingBuffer.h"
+#include "lingodb/runtime/LazyJoinHashtable.h"
+#include "lingodb/runtime/helpers.h"
+
+#include "RuntimeTestHelpers.h"
+
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace lingodb::runtime;
+namespace {
+//entries of the buffer start with their hash value, the keys and values follow
+struct Entry {
+   uint64_t hash;
+   int64_t key;
+   int64_t value;
+};
+//the view as it is accessed by the generated code (LookupHashIndexedViewLowering, CheckJoinFilterLowering)
+struct GeneratedView {
+   uint64_t* ht;
+   size_t htMask;
+   uint64_t* filter;
+   size_t filterMask;
+};
+struct Slot {
+   uint64_t hash;
+   Entry* entry;
+};
+//filter check of CheckJoinFilterLowering: the word is selected by the upper half, the bits by the bits 14, 20 and 26 of the hash value
+bool mayMatch(GeneratedView* view, uint64_t hash) {
+   uint64_t bits = (1ull << ((hash >> 14) & 63)) | (1ull << ((hash >> 20) & 63)) | (1ull << ((hash >> 26) & 63));
+   return (view->filter[(hash >> 32) & view->filterMask] & bits) == bits;
+}
+//lookup of the generated code: the slots of a bucket range from its begin to the begin of the next bucket
+std::vector<Entry*> lookup(GeneratedView* view, uint64_t hash, int64_t key) {
+   std::vector<Entry*> res;
+   size_t bucket = hash & view->htMask;
+   auto* tagged = reinterpret_cast<uint8_t*>(view->ht[bucket]);
+   if (!matchesTag(tagged, hash)) return res;
+   auto* begin = reinterpret_cast<Slot*>(untag(tagged));
+   auto* end = reinterpret_cast<Slot*>(view->ht[bucket + 1] >> 16);
+   for (auto* slot = begin; slot < end; slot++) {
+      if (slot->hash == hash && slot->entry->key == key) {
+         res.push_back(slot->entry);
+      }
+   }
+   return res;
+}
+} // namespace
+
+TEST_CASE("HashIndexedView:Collisions") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   lingodb::test::runInQuery([]() {
+      constexpr int64_t numKeys = 20000;
+      auto buffer = std::make_unique<GrowingBuffer>(1024, sizeof(Entry));
+      std::mt19937_64 rng(13);
+      std::map<int64_t, uint64_t> hashes;
+      std::map<int64_t, size_t> copies;
+      for (int64_t key = 0; key < numKeys; key++) {
+         //groups of four keys share their hash value and groups of 64 keys their lower hash bits, so that buckets hold several keys
+         uint64_t hash = key % 4 == 0 ? rng() : hashes[key - 1];
+         if (key % 64 != 0 && key % 4 == 0) {
+            hash = (hash & ~0xffffull) | (hashes[key - 4] & 0xffff);
+         }
+         hashes[key] = hash;
+         copies[key] = 1 + key % 3;
+         for (size_t copy = 0; copy < copies[key]; copy++) {
+            *reinterpret_cast<Entry*>(buffer->insert()) = {hash, key, key * 10 + static_cast<int64_t>(copy)};
+         }
+      }
+      auto* view = reinterpret_cast<GeneratedView*>(HashIndexedView::build(buffer.get()));
+      size_t numSlots = (view->ht[view->htMask + 1] >> 16) - (view->ht[0] >> 16);
+      REQUIRE(numSlots == buffer->getLen() * sizeof(Slot));
+      for (int64_t key = 0; key < numKeys; key++) {
+         uint64_t hash = hashes[key];
+         REQUIRE(mayMatch(view, hash));
+         auto matches = lookup(view, hash, key);
+         REQUIRE(matches.size() == copies[key]);
+         std::vector<bool> seen(copies[key], false);
+         for (auto* match : matches) {
+            int64_t copy = match->value - key * 10;
+            REQUIRE(copy >= 0);
+            REQUIRE(copy < static_cast<int64_t>(copies[key]));
+            REQUIRE(!seen[copy]);
+            seen[copy] = true;
+         }
+      }
+      //hash values that were not inserted are mostly rejected by the filter
+      size_t passed = 0;
+      constexpr size_t numMisses = 100000;
+      for (size_t i = 0; i < numMisses; i++) {
+         uint64_t hash = rng();
+         passed += mayMatch(view, hash);
+         REQUIRE(lookup(view, hash, -1).empty());
+      }
+      REQUIRE(passed < numMisses / 10);
+   });
+}
+
+TEST_CASE("HashIndexedView:Empty") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   lingodb::test::runInQuery([]() {
+      auto buffer = std::make_unique<GrowingBuffer>(16, sizeof(Entry));
+      auto* view = reinterpret_cast<GeneratedView*>(HashIndexedView::build(buffer.get()));
+      std::mt19937_64 rng(5);
+      for (size_t i = 0; i < 1000; i++) {
+         uint64_t hash = rng();
+         REQUIRE(!mayMatch(view, hash));
+         REQUIRE(lookup(view, hash, 0).empty());
+      }
+   });
+}
@@ -0,0 +1,90 @@
+#include "catch2/catch_all.hpp"
+#include "lingodb/runtime/GrowingBuffer.h"
+#include "lingodb/runtime/NestedLoopJoin.h"
+#include "lingodb/utility/Setting.h"
+
+#include "RuntimeTestHelpers.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace lingodb::runtime;
+namespace {
+constexpr size_t numBuild = 1000;
+constexpr size_t numProbe = 300;
+using Seen = std::vector<std::vector<size_t>>;
+//counts every (build entry, probe entry) pair of the blocks
+void countPairs(Buffer buffer, Seen& seen) {
+   REQUIRE(buffer.numElements == sizeof(NestedLoopJoin::BlockPair));
+   auto* pair = reinterpret_cast<NestedLoopJoin::BlockPair*>(buffer.ptr);
+   auto* build = reinterpret_cast<int64_t*>(pair->build);
+   auto* probe = reinterpret_cast<int64_t*>(pair->probe);
+   for (size_t i = 0; i < pair->numBuild; i++) {
+      for (size_t j = 0; j < pair->numProbe; j++) {
+         seen[build[i]][probe[j]]++;
+      }
+   }
+}
+void checkAllPairsOnce(Seen& seen) {
+   for (auto& row : seen) {
+      for (auto count : row) {
+         REQUIRE(count == 1);
+      }
+   }
+}
+} // namespace
+
+TEST_CASE("NestedLoopJoin:AllPairs") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   //several build blocks and probe batches
+   lingodb::utility::setSetting("system.nested_loop_join.block_bytes", "800");
+   lingodb::utility::setSetting("system.nested_loop_join.batch_size", "64");
+   lingodb::test::runInQuery([]() {
+      auto build = std::make_unique<GrowingBuffer>(128, sizeof(int64_t));
+      auto probe = std::make_unique<GrowingBuffer>(128, sizeof(int64_t));
+      for (size_t i = 0; i < numBuild; i++) {
+         *reinterpret_cast<int64_t*>(build->insert()) = i;
+      }
+      for (size_t i = 0; i < numProbe; i++) {
+         *reinterpret_cast<int64_t*>(probe->insert()) = i;
+      }
+      auto* join = NestedLoopJoin::create(build.get(), probe.get());
+      {
+         Seen seen(numBuild, std::vector<size_t>(numProbe, 0));
+         std::mutex mutex;
+         std::pair<Seen*, std::mutex*> context{&seen, &mutex};
+         auto* iterator = NestedLoopJoin::createIterator(join);
+         iterator->iterateEfficient(true, [](Buffer buffer, void* contextPtr) {
+            auto* context = reinterpret_cast<std::pair<Seen*, std::mutex*>*>(contextPtr);
+            std::lock_guard<std::mutex> lock(*context->second);
+            countPairs(buffer, *context->first); }, &context);
+         delete iterator;
+         checkAllPairsOnce(seen);
+      }
+      {
+         Seen seen(numBuild, std::vector<size_t>(numProbe, 0));
+         auto* iterator = NestedLoopJoin::createIterator(join);
+         for (; iterator->isValid(); iterator->next()) {
+            countPairs(iterator->getCurrentBuffer(), seen);
+         }
+         delete iterator;
+         checkAllPairsOnce(seen);
+      }
+   });
+   lingodb::utility::setSetting("system.nested_loop_join.block_bytes", std::to_string(1 << 18));
+   lingodb::utility::setSetting("system.nested_loop_join.batch_size", "1024");
+}
+
+TEST_CASE("NestedLoopJoin:EmptySide") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   lingodb::test::runInQuery([]() {
+      auto build = std::make_unique<GrowingBuffer>(16, sizeof(int64_t));
+      auto probe = std::make_unique<GrowingBuffer>(16, sizeof(int64_t));
+      *reinterpret_cast<int64_t*>(probe->insert()) = 0;
+      auto* join = NestedLoopJoin::create(build.get(), probe.get());
+      auto* iterator = NestedLoopJoin::createIterator(join);
+      REQUIRE(!iterator->isValid());
+      delete iterator;
+   });
+}
@@ -0,0 +1,83 @@
+#include "catch2/catch_all.hpp"
+#include "lingodb/runtime/SegmentTreeView.h"
+#include "lingodb/utility/Setting.h"
+
+#include "RuntimeTestHelpers.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace lingodb::runtime;
+namespace {
+//aggregate of the entries [first, last], ordered is 0 if states were combined out of order
+struct RangeState {
+   int64_t sum;
+   int64_t first;
+   int64_t last;
+   int64_t ordered;
+};
+void createInitialState(uint8_t* state, uint8_t* entry) {
+   auto value = *reinterpret_cast<int64_t*>(entry);
+   *reinterpret_cast<RangeState*>(state) = {value, value, value, 1};
+}
+void combineStates(uint8_t* newState, uint8_t* leftPtr, uint8_t* rightPtr) {
+   auto left = *reinterpret_cast<RangeState*>(leftPtr);
+   auto right = *reinterpret_cast<RangeState*>(rightPtr);
+   *reinterpret_cast<RangeState*>(newState) = {left.sum + right.sum, left.first, right.last, left.ordered && right.ordered && left.last + 1 == right.first};
+}
+void checkRange(SegmentTreeView* view, size_t from, size_t to) {
+   RangeState result;
+   view->lookup(reinterpret_cast<uint8_t*>(&result), from, to);
+   int64_t expectedSum = (static_cast<int64_t>(from) + static_cast<int64_t>(to)) * static_cast<int64_t>(to - from + 1) / 2;
+   REQUIRE(result.first == static_cast<int64_t>(from));
+   REQUIRE(result.last == static_cast<int64_t>(to));
+   REQUIRE(result.ordered == 1);
+   REQUIRE(result.sum == expectedSum);
+}
+} // namespace
+
+TEST_CASE("SegmentTree:RangesAtFanoutEdges") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   for (size_t fanout : {2, 3, 16}) {
+      lingodb::utility::setSetting("system.segment_tree.fanout", std::to_string(fanout));
+      //the last size spans several units of work per level, i.e., the levels are built in parallel
+      for (size_t numEntries : {1ul, fanout - 1, fanout, fanout + 1, fanout * fanout, fanout * fanout + 1, 10000ul}) {
+         if (numEntries == 0) {
+            continue;
+         }
+         lingodb::test::runInQuery([&]() {
+            std::vector<int64_t> entries(numEntries);
+            for (size_t i = 0; i < numEntries; i++) {
+               entries[i] = i;
+            }
+            auto* view = SegmentTreeView::build(Buffer{numEntries * sizeof(int64_t), reinterpret_cast<uint8_t*>(entries.data())}, sizeof(int64_t), createInitialState, combineStates, sizeof(RangeState));
+            if (numEntries <= 300) {
+               for (size_t from = 0; from < numEntries; from++) {
+                  for (size_t to = from; to < numEntries; to++) {
+                     checkRange(view, from, to);
+                  }
+               }
+            } else {
+               //bounds next to the node borders of the first two inner levels
+               std::vector<size_t> bounds = {0, 1, numEntries / 2, numEntries - 2, numEntries - 1};
+               for (size_t border : {fanout, fanout * fanout, fanout * fanout * fanout}) {
+                  for (size_t bound : {border - 1, border, border + 1}) {
+                     if (bound < numEntries) {
+                        bounds.push_back(bound);
+                     }
+                  }
+               }
+               for (auto from : bounds) {
+                  for (auto to : bounds) {
+                     if (from <= to) {
+                        checkRange(view, from, to);
+                     }
+                  }
+               }
+            }
+         });
+      }
+   }
+   lingodb::utility::setSetting("system.segment_tree.fanout", "16");
+}
@@ -0,0 +1,51 @@
+#include "catch2/catch_all.hpp"
+#include "lingodb/runtime/ThreadLocal.h"
+
+#include "RuntimeTestHelpers.h"
+
+#include <vector>
+
+using namespace lingodb::runtime;
+namespace {
+uint8_t* createEmptyVector(uint8_t*) {
+   return reinterpret_cast<uint8_t*>(new std::vector<size_t>());
+}
+//fills the thread-local values with {i} for every i in ids, all other values stay empty
+std::vector<std::vector<size_t>> fill(ThreadLocal* threadLocal, const std::vector<size_t>& ids) {
+   auto values = threadLocal->getThreadLocalValues<std::vector<size_t>>();
+   std::vector<std::vector<size_t>> storage(values.size());
+   for (size_t i = 0; i < values.size(); i++) {
+      values[i] = nullptr;
+   }
+   for (auto id : ids) {
+      storage[id] = {id};
+      values[id] = &storage[id];
+   }
+   return storage;
+}
+} // namespace
+
+TEST_CASE("ThreadLocal:ReduceKeepsOrder") {
+   auto scheduler = lingodb::scheduler::startScheduler(16);
+   lingodb::test::runInQuery([]() {
+      auto* threadLocal = ThreadLocal::create(createEmptyVector, nullptr);
+      size_t numValues = lingodb::scheduler::getNumWorkers();
+      std::vector<std::vector<size_t>> idSets = {{0}, {3, 7}, {1, 2, 5}, {0, 1, 2, 3}};
+      //all values, every other value and every third value: several rounds of the parallel tree reduction
+      for (size_t step = 1; step <= 3; step++) {
+         std::vector<size_t> ids;
+         for (size_t i = 0; i < numValues; i += step) {
+            ids.push_back(i);
+         }
+         idSets.push_back(ids);
+      }
+      for (const auto& ids : idSets) {
+         auto storage = fill(threadLocal, ids);
+         auto* result = threadLocal->reduce<std::vector<size_t>>([](std::vector<size_t>* left, std::vector<size_t>* right) {
+            left->insert(left->end(), right->begin(), right->end());
+         });
+         REQUIRE(result != nullptr);
+         REQUIRE(*result == ids);
+      }
+   });
+}
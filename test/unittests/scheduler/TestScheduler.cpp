@@ -0,0 +1,152 @@
+#include "catch2/catch_all.hpp"
+#include "lingodb/scheduler/Parker.h"
+#include "lingodb/scheduler/Scheduler.h"
+#include "lingodb/scheduler/Task.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <limits>
+#include <thread>
+
+namespace {
+class MockTask : public lingodb::scheduler::Task {
+   std::function<void()> job;
+
+   public:
+   MockTask(std::function<void()> job) : job(std::move(job)) {}
+   bool allocateWork() override {
+      if (workExhausted.exchange(true)) {
+         return false;
+      }
+      return true;
+   }
+   void performWork() override {
+      job();
+   }
+   size_t maxParallelism() override {
+      return 1;
+   }
+};
+//touches the given number of bytes on the stack of the current fiber
+void useStack(size_t bytes) {
+   volatile char buffer[256 << 10];
+   for (size_t i = 0; i < bytes && i < sizeof(buffer); i += 512) {
+      buffer[i] = static_cast<char>(i);
+   }
+}
+} // namespace
+
+TEST_CASE("FiberStackPool:ReleasedStacksAreDecommitted") {
+   auto scheduler = lingodb::scheduler::startScheduler(2);
+   for (size_t i = 0; i < 4; i++) {
+      lingodb::scheduler::awaitEntryTask(std::make_unique<MockTask>([]() { useStack(256 << 10); }));
+   }
+   auto stats = lingodb::scheduler::getFiberStackStats();
+   REQUIRE(stats.cachedStacks > 0);
+   //only the top 64KiB of a cached stack stay committed
+   REQUIRE(stats.cachedResidentBytes <= stats.cachedStacks * (64 << 10));
+}
+
+TEST_CASE("Scheduler:EnqueueAfterParkingWorkers") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   for (size_t i = 0; i < 100; i++) {
+      lingodb::scheduler::setNumActiveWorkers(4);
+      lingodb::scheduler::awaitEntryTask(std::make_unique<MockTask>([]() {}));
+      lingodb::scheduler::setNumActiveWorkers(1);
+      //the new task must be executed, no matter whether the parked workers were idle or still busy
+      auto done = std::async(std::launch::async, []() {
+         lingodb::scheduler::awaitEntryTask(std::make_unique<MockTask>([]() {}));
+      });
+      bool finished = done.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+      //reactivating all workers gets a lost task executed, so that the test fails instead of hanging
+      lingodb::scheduler::setNumActiveWorkers(4);
+      done.wait();
+      REQUIRE(finished);
+   }
+}
+
+TEST_CASE("Scheduler:EnqueueWhileParkingWorkers") {
+   auto scheduler = lingodb::scheduler::startScheduler(4);
+   //changes the number of active workers concurrently to enqueueing tasks
+   std::atomic<bool> stop{false};
+   std::thread resizer([&]() {
+      for (size_t i = 0; !stop.load(); i++) {
+         lingodb::scheduler::setNumActiveWorkers(1 + i % 4);
+      }
+   });
+   constexpr size_t numTasks = 1000;
+   size_t finished = 0;
+   std::future<void> done;
+   for (; finished < numTasks; finished++) {
+      done = std::async(std::launch::async, []() {
+         lingodb::scheduler::awaitEntryTask(std::make_unique<MockTask>([]() {}));
+      });
+      if (done.wait_for(std::chrono::seconds(5)) != std::future_status::ready) {
+         break;
+      }
+   }
+   stop = true;
+   resizer.join();
+   //reactivating all workers gets a lost task executed, so that the test fails instead of hanging
+   lingodb::scheduler::setNumActiveWorkers(4);
+   done.wait();
+   REQUIRE(finished == numTasks);
+}
+
+TEST_CASE("Parker:Spin") {
+   //a wakeup token that is already there is consumed while spinning and keeps the full budget
+   lingodb::scheduler::Parker parker(64);
+   parker.unpark();
+   parker.park();
+   REQUIRE(parker.getSpinBudget() == 64);
+   //a wakeup during the spin phase does not block
+   lingodb::scheduler::Parker spinning(std::numeric_limits<uint32_t>::max());
+   std::thread waker([&]() { spinning.unpark(); });
+   spinning.park();
+   waker.join();
+   REQUIRE(spinning.getSpinBudget() == std::numeric_limits<uint32_t>::max());
+}
+
+TEST_CASE("Parker:Park") {
+   lingodb::scheduler::Parker parker(64);
+   //wakes the parker up once it blocks on the futex
+   auto parkBlocking = [&]() {
+      std::thread waker([&]() {
+         while (!parker.isBlocked()) {
+            std::this_thread::yield();
+         }
+         parker.unpark();
+      });
+      parker.park();
+      waker.join();
+   };
+   parkBlocking();
+   REQUIRE(parker.getSpinBudget() == 32);
+   //blocking repeatedly shrinks the budget only down to the minimum
+   for (size_t i = 0; i < 20; i++) {
+      parkBlocking();
+   }
+   REQUIRE(parker.getSpinBudget() == 4);
+   //so that a wakeup while spinning still grows it again
+   parker.unpark();
+   parker.park();
+   REQUIRE(parker.getSpinBudget() == 9);
+   parkBlocking();
+   REQUIRE(parker.getSpinBudget() == 4);
+   //without a spin budget, the parker always blocks
+   lingodb::scheduler::Parker blocking(0);
+   blocking.unpark();
+   blocking.park();
+   REQUIRE(blocking.getSpinBudget() == 0);
+   std::thread waker([&]() {
+      while (!blocking.isBlocked()) {
+         std::this_thread::yield();
+      }
+      blocking.unpark();
+   });
+   blocking.park();
+   waker.join();
+   REQUIRE(blocking.getSpinBudget() == 0);
+}